@@ -22,6 +22,8 @@
  *      Functions for recording performed gates to <a href="https://en.wikipedia.org/wiki/OpenQASM">QASM</a>
  * @defgroup debug Debugging
  *      Utilities for seeding and debugging, such as state-logging
+ * @defgroup fusion Gate fusion
+ *      Functions for fusing consecutive gates into fewer, larger unitaries, to reduce passes over the state
  *
  * @author Ania Brown
  * @author Tyson Jones
@@ -68,6 +70,63 @@ typedef struct {
     
 } QASMLogger;
 
+/** A buffer of consecutive unitaries which have been fused into a single dense 
+ * matrix, but which are not yet applied to the state, of previously fused 
+ * matrices queued for a cache-blocked application, and of accumulated diagonal 
+ * gates. See startGateFusion() and startBlockedGateFusion().
+ *
+ * @ingroup type
+ */
+typedef struct {
+    
+    int isFusing;       // whether unitaries are being fused, rather than immediately applied
+    int maxNumQubits;   // maximum number of qubits targeted by a fused matrix
+    int numQubits;      // number of qubits targeted by the pending fused matrix
+    int* qubits;        // the qubits of the pending matrix, in order of its index bits
+    qreal* real;        // the pending matrix, flattened row-major, with 2^numQubits rows
+    qreal* imag;
+    qreal* workReal;    // working space of the same size as the pending matrix
+    qreal* workImag;
+    qreal** realRows;   // pointers into the rows of real and imag, for binding to a ComplexMatrixN
+    qreal** imagRows;
+    
+    int numBlockQubits;     // qubits spanned by each cache block, or 0 if fused matrices are applied immediately
+    int numQueued;          // number of fused matrices awaiting a blocked application
+    int numQueuedQubits;    // total number of qubits targeted by the queued matrices
+    int* queuedNumQubits;   // number of qubits targeted by each queued matrix
+    int* queuedQubits;      // the qubits of each queued matrix, concatenated
+    qreal* queuedReal;      // each queued matrix, flattened row-major, in a slot of the pending matrix's capacity
+    qreal* queuedImag;
+    qreal** queuedRealRows; // pointers into the rows of queuedReal and queuedImag
+    qreal** queuedImagRows;
+    
+    int numPhaseTerms;          // number of accumulated diagonal phase terms, applied after the pending matrix
+    long long int* phaseMasks;  // each term multiplies basis states in which every masked qubit is 1...
+    qreal* phaseAngles;         // ...by exp(i angle)
+    int numParityTerms;         // number of accumulated diagonal parity terms, applied after the pending matrix
+    long long int* parityMasks; // each term multiplies basis states of even (odd) masked parity...
+    qreal* parityAngles;        // ...by exp(-i angle/2) (exp(i angle/2))
+    
+} GateFusionBuffer;
+
+/** The dimensions of QuregPool.bins; one stack per memoryPolicy, and per number of 
+ * state-vector qubits (which validation caps at log2(SIZE_MAX)) */
+# define NUM_POOLED_POLICIES 4
+# define NUM_POOLED_QUBITS 64
+
+/** A pool of the memory of destroyed Quregs (their amplitudes, any pair buffers 
+ * and QASM loggers), which is recycled by later Quregs of the same size and 
+ * memory policy. See startQuregPool().
+ *
+ * @ingroup type
+ */
+typedef struct {
+    
+    int isPooling;                  // whether destroyed Quregs are kept for reuse, rather than freed
+    struct PooledQureg* bins[NUM_POOLED_POLICIES][NUM_POOLED_QUBITS]; // stacks of destroyed Quregs, by memoryPolicy then numQubitsInStateVec
+    
+} QuregPool;
+
 /** Represents an array of complex numbers grouped into an array of 
  * real components and an array of coressponding complex components.
  *
@@ -95,6 +154,40 @@ typedef struct ComplexArray
   */
  enum pauliOpType {PAULI_I=0, PAULI_X=1, PAULI_Y=2, PAULI_Z=3};
 
+/** Codes for specifying how the CPU memory of a Qureg's amplitudes is allocated.
+ *
+ * All policies align the amplitude arrays to (at least) a 64-byte cache line, and
+ * first-touch them in parallel with the same static OpenMP schedule used by the
+ * simulation kernels, so that pages are placed on the NUMA node of the thread which
+ * later processes them.
+ *
+ * - ::MEMORY_DEFAULT aligns to 64 bytes and leaves page size to the operating system.
+ * - ::MEMORY_HUGE_PAGES aligns to 2 MiB and requests transparent huge pages (on Linux).
+ * - ::MEMORY_EXPLICIT_HUGE_PAGES maps pages from the reserved huge-page pool (on Linux),
+ *   falling back to transparent huge pages when the pool is exhausted.
+ * - ::MEMORY_FILE_MAPPED backs the amplitudes with files, so that a Qureg may exceed RAM 
+ *   (see below).
+ *
+ * On platforms without huge-page support, the huge-page policies only affect alignment.
+ * The GPU backend ignores the policy.
+ *
+ * Under ::MEMORY_FILE_MAPPED (on POSIX systems), each amplitude array is memory-mapped 
+ * onto a file created in the directory named by the \p QUEST_FILE_MAPPED_DIR environment 
+ * variable, which must be set, and should be on fast local storage (e.g. NVMe) with space 
+ * for the Qureg (and its pair buffers when distributed). There is no default, since the 
+ * system temporary directory is often a RAM-backed tmpfs, which would defeat the policy. The file 
+ * is unlinked upon creation, so it is removed when the Qureg is destroyed or the program 
+ * exits. The operating system pages amplitudes in and out of RAM as the kernels sweep 
+ * them, with read-ahead, and writes modified pages back in the background. Since the 
+ * kernels process amplitudes in contiguous runs (and high-qubit gates in pairs of runs, 
+ * as between distributed chunks), this streams the state through RAM in large sequential 
+ * transfers, though every gate may then cost a full read and write of the state.
+ * This is intended for occasional verification of registers too large for RAM.
+ *
+ * @ingroup type
+ */
+ enum memoryPolicy {MEMORY_DEFAULT=0, MEMORY_HUGE_PAGES=1, MEMORY_EXPLICIT_HUGE_PAGES=2, MEMORY_FILE_MAPPED=3};
+
 /** Represents one complex number.
  *
  * @ingroup type
@@ -168,6 +261,27 @@ typedef struct PauliHamil
     int numQubits;
 } PauliHamil;
 
+/** A Trotter circuit prepared by createTrotterPlan(), as the sequence of Pauli
+ * rotations (see multiRotatePauli()) which applyTrotterPlan() effects.
+ * Each Pauli product is encoded by the qubits upon which it acts as X or Y
+ * (\p xMasks) and as Y or Z (\p zMasks).
+ *
+ * @ingroup type
+ */
+typedef struct TrotterPlan
+{
+    //! The bits of the qubits acted upon by X or Y in each rotation. This is a length \p numTerms array
+    long long int* xMasks;
+    //! The bits of the qubits acted upon by Y or Z in each rotation. This is a length \p numTerms array
+    long long int* zMasks;
+    //! The angle of each rotation, as passed to multiRotatePauli(). This is a length \p numTerms array
+    qreal* angles;
+    //! The number of rotations in the circuit
+    int numTerms;
+    //! The number of qubits upon which the circuit acts
+    int numQubits;
+} TrotterPlan;
+
 /** Represents a diagonal complex operator on the full Hilbert state of a \p Qureg.
  * The operator need not be unitary nor Hermitian (which would constrain it to
  * real values)
@@ -217,6 +331,8 @@ typedef struct Qureg
     int chunkId;
     //! Number of chunks the state vector is broken up into -- the number of MPI processes used
     int numChunks;
+    //! How the CPU memory of stateVec and pairStateVec was allocated
+    enum memoryPolicy memPolicy;
     
     //! Computational state amplitudes - a subset thereof in the MPI version
     ComplexArray stateVec; 
@@ -231,6 +347,9 @@ typedef struct Qureg
     //! Storage for generated QASM output
     QASMLogger* qasmLog;
     
+    //! Storage for unitaries fused but not yet applied, when gate fusion is enabled
+    GateFusionBuffer* fusionBuffer;
+    
 } Qureg;
 
 /** Information about the environment the program is running in.
@@ -243,6 +362,8 @@ typedef struct QuESTEnv
 {
     int rank;
     int numRanks;
+    //! Storage for the memory of destroyed Quregs, when pooling is enabled
+    QuregPool* quregPool;
 } QuESTEnv;
 
 
@@ -283,6 +404,40 @@ Qureg createQureg(int numQubits, QuESTEnv env);
  */
 Qureg createDensityQureg(int numQubits, QuESTEnv env);
 
+/** Create a Qureg object representing a set of qubits which will remain in a pure state,
+ * with the CPU memory of its amplitudes allocated under the given ::memoryPolicy.
+ * This is otherwise identical to createQureg(), which uses ::MEMORY_DEFAULT.
+ *
+ * For example, on a multi-socket node with huge pages reserved,
+ * @code
+Qureg qureg = createQuregWithPolicy(34, env, MEMORY_EXPLICIT_HUGE_PAGES);
+ * @endcode
+ * Clones made with createCloneQureg() inherit the policy of the original.
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] env object representing the execution environment (local, multinode etc)
+ * @param[in] policy how to allocate the amplitude arrays
+ * @throws invalidQuESTInputError if \p numQubits is invalid (as in createQureg()), 
+ *      or if \p policy is not a valid ::memoryPolicy
+ */
+Qureg createQuregWithPolicy(int numQubits, QuESTEnv env, enum memoryPolicy policy);
+
+/** Create a Qureg for qubits which are represented by a density matrix, 
+ * with the CPU memory of its amplitudes allocated under the given ::memoryPolicy.
+ * This is otherwise identical to createDensityQureg(), which uses ::MEMORY_DEFAULT.
+ *
+ * @ingroup type
+ * @returns an object representing the set of qubits
+ * @param[in] numQubits number of qubits in the system
+ * @param[in] env object representing the execution environment (local, multinode etc)
+ * @param[in] policy how to allocate the amplitude arrays
+ * @throws invalidQuESTInputError if \p numQubits is invalid (as in createDensityQureg()), 
+ *      or if \p policy is not a valid ::memoryPolicy
+ */
+Qureg createDensityQuregWithPolicy(int numQubits, QuESTEnv env, enum memoryPolicy policy);
+
 /** Create a new Qureg which is an exact clone of the passed qureg, which can be
  * either a statevector or a density matrix. That is, it will have the same 
  * dimensions as the passed qureg and begin in an identical quantum state.
@@ -625,6 +780,57 @@ real, imag
  */
 void reportState(Qureg qureg);
 
+/** Save the full state of \p qureg (a state-vector or density matrix) to a binary 
+ * checkpoint file, which can be restored with loadQuregCheckpoint().
+ * 
+ * Unlike reportState(), amplitudes are stored exactly, in the precision of the 
+ * writer (see ::qreal). The file begins with a self-describing header (recording 
+ * the precision, the number of qubits, whether \p qureg is a density matrix, and 
+ * the number of nodes which wrote it), followed by the real components of every 
+ * amplitude in order, then the imaginary components. The header fields are 
+ * little-endian and of fixed width, but the amplitudes are in the native byte 
+ * order of the writer, which the header records; a checkpoint can only be loaded 
+ * on a machine of the same byte order.
+ *
+ * In distributed mode, every node writes its own chunk of amplitudes to the single
+ * file in parallel, as two large sequential writes, so \p filename must be on a
+ * file system shared by all nodes.
+ * 
+ * For example, 
+ * @code
+saveQuregCheckpoint(qureg, "state.qchk", env);
+...
+Qureg restored = createQureg(qureg.numQubitsRepresented, env);
+loadQuregCheckpoint(restored, "state.qchk", env);
+ * @endcode
+ *
+ * @ingroup debug
+ * @param[in] qureg object representing the set of qubits to save
+ * @param[in] filename the file to create, or overwrite
+ * @param[in] env object representing the execution environment (local, multinode etc)
+ * @throws invalidQuESTInputError if \p filename cannot be opened or fully written
+ */
+void saveQuregCheckpoint(Qureg qureg, char* filename, QuESTEnv env);
+
+/** Restore the state of \p qureg from a binary checkpoint file written by 
+ * saveQuregCheckpoint().
+ *
+ * The checkpoint may have been written by any number of nodes, and with any 
+ * precision; amplitudes of a different precision are converted to ::qreal.
+ * \p qureg must already be created with the same number of qubits, and be of 
+ * the same type (state-vector or density matrix), as the saved Qureg.
+ * In distributed mode, every node reads only its own chunk of amplitudes.
+ *
+ * @ingroup init
+ * @param[in,out] qureg object representing the set of qubits to overwrite
+ * @param[in] filename the checkpoint file to load
+ * @param[in] env object representing the execution environment (local, multinode etc)
+ * @throws invalidQuESTInputError if \p filename cannot be opened, is not a complete 
+ *      QuEST checkpoint, was saved from a Qureg of a different number of qubits or 
+ *      type than \p qureg, or cannot be read
+ */
+void loadQuregCheckpoint(Qureg qureg, char* filename, QuESTEnv env);
+
 /** Print the current state vector of probability amplitudes for a set of qubits to standard out. 
  * For debugging purposes. Each rank should print output serially. 
  * Only print output for systems <= 5 qubits
@@ -1102,6 +1308,45 @@ QuESTEnv createQuESTEnv(void);
  */
 void destroyQuESTEnv(QuESTEnv env);
 
+/** Begin recycling the memory of destroyed Quregs.
+ * While pooling, destroyQureg() keeps the Qureg's amplitudes (and those of its pair 
+ * buffer in distributed mode, or on the GPU), and its QASM logger, in a pool within 
+ * \p env, rather than freeing them. A subsequent createQureg(), createDensityQureg(), 
+ * createCloneQureg() (or their policy variants) needing the same number of amplitudes 
+ * and ::memoryPolicy then reuses that memory, avoiding the cost of allocation 
+ * and of page faults on first access. A state-vector of \p 2N qubits and a density 
+ * matrix of \p N qubits share memory.
+ *
+ * This is useful in variational and sampling loops which repeatedly create and 
+ * destroy Quregs, e.g.
+ * @code
+startQuregPool(env);
+for (int i=0; i<numIters; i++) {
+    Qureg trial = createCloneQureg(ansatz, env);
+    ...
+    destroyQureg(trial, env); // memory is reused by the next clone
+}
+stopQuregPool(env);
+ * @endcode
+ *
+ * Recycled Quregs are still initialised, as though newly allocated. 
+ * The pooled memory is only released by stopQuregPool() or destroyQuESTEnv(), 
+ * so a program should stop pooling before creating Quregs of a different size 
+ * if memory is scarce.
+ *
+ * @ingroup type
+ * @param[in] env object representing the execution environment
+ */
+void startQuregPool(QuESTEnv env);
+
+/** Stop recycling the memory of destroyed Quregs, and free any memory currently pooled.
+ * Subsequently destroyed Quregs are immediately freed. See startQuregPool().
+ *
+ * @ingroup type
+ * @param[in] env object representing the execution environment
+ */
+void stopQuregPool(QuESTEnv env);
+
 /** Guarantees that all code up to the given point has been executed on all nodes (if running in distributed mode)
  *
  * @ingroup debug
@@ -1139,10 +1384,27 @@ void reportQuESTEnv(QuESTEnv env);
  */
 void getEnvironmentString(QuESTEnv env, Qureg qureg, char str[200]);
 
+/** Returns the precision with which this QuEST library was compiled, as the value of 
+ * \ref QuEST_PREC (1, 2 or 4 for single, double or quad precision). 
+ *
+ * The precision is fixed when the library is built, and is shared by every Qureg it creates. 
+ * A program which wishes to use several precisions (for example, to cheaply screen parameters 
+ * in single precision before refining them in double) can build the library once per precision 
+ * with distinct CMake LIB_NAME (e.g. QuEST_single and QuEST_double), then load each at runtime 
+ * with dlopen() and RTLD_LOCAL (as does Python's ctypes), so that their identically named 
+ * symbols do not clash. This function lets the program confirm which library is which, and 
+ * hence the width of the \ref qreal it must pass to each.
+ *
+ * @ingroup debug
+ * @returns the value of \ref QuEST_PREC with which the library was compiled
+ */
+int getQuEST_PREC(void);
+
 /** In GPU mode, this copies the state-vector (or density matrix) from RAM 
  * (qureg.stateVec) to VRAM / GPU-memory (qureg.deviceStateVec), which is the version 
  * operated upon by other calls to the API. 
- * In CPU mode, this function has no effect.
+ * Any gates pending in an ongoing gate fusion (see startGateFusion()) are first applied.
+ * In CPU mode, this function otherwise has no effect.
  * In conjunction with copyStateFromGPU() (which should be called first), this allows 
  * a user to directly modify the state-vector in a harware agnostic way.
  * Note though that users should instead use setAmps() if possible.
@@ -1165,7 +1427,9 @@ void copyStateToGPU(Qureg qureg);
 /** In GPU mode, this copies the state-vector (or density matrix) from GPU memory 
  * (qureg.deviceStateVec) to RAM (qureg.stateVec), where it can be accessed/modified 
  * by the user.
- * In CPU mode, this function has no effect.
+ * Any gates pending in an ongoing gate fusion (see startGateFusion()) are first applied,
+ * so that the copied state reflects every gate applied so far.
+ * In CPU mode, this function otherwise has no effect.
  * In conjunction with copyStateToGPU(), this allows a user to directly modify the 
  * state-vector in a harware agnostic way.
  * Note though that users should instead use setAmps() if possible.
@@ -2004,6 +2268,67 @@ void controlledPauliY(Qureg qureg, int controlQubit, int targetQubit);
  */
 qreal calcProbOfOutcome(Qureg qureg, int measureQubit, int outcome);
 
+/** Populates \p outcomeProbs with the probabilities of every outcome of measuring the 
+ * given \p qubits, in a single pass over \p qureg (rather than the \p 2^numQubits 
+ * passes of calcProbOfOutcome() required to find the same joint distribution).
+ * This performs no actual measurement and does not change the state of the qubits.
+ *
+ * The probability of outcome \p o is written to \p outcomeProbs[o], where the \p i-th 
+ * bit (from the right) of \p o is the outcome of qubit \p qubits[i]. For example, 
+ * given \p qubits \p = \p {3, 0}, \p outcomeProbs[1] is the total probability of the 
+ * basis states in which qubit 3 is 1 and qubit 0 is 0.
+ *
+ * For state-vectors, this function sums the absolute-value-squared of every amplitude 
+ * contributing to each outcome, and for density matrices, sums the (real) diagonal 
+ * elements. Unlike calcProbOfOutcome(), no outcome is inferred as 1 minus another, so 
+ * the probabilities of un-normalised states sum to calcTotalProb().
+ *
+ * @ingroup calc
+ * @param[in] qureg object representing the set of all qubits
+ * @param[in] qubits a list of the unique qubits to study
+ * @param[in] numQubits the length of list \p qubits
+ * @param[out] outcomeProbs a list of length \p 2^numQubits, to be populated with the 
+ *      probability of every outcome
+ * @throws invalidQuESTInputError
+ *      if any index in \p qubits is outside [0, \p qureg.numQubitsRepresented),
+ *      or if \p qubits contains a repetition,
+ *      or if \p numQubits is outside [1, \p qureg.numQubitsRepresented]
+ */
+void calcProbOfAllOutcomes(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs);
+
+/** Samples \p numShots measurement outcomes of the given \p qubits, without collapsing 
+ * (or otherwise changing) the state of \p qureg.
+ * This is equivalent to (but much faster than) cloning \p qureg, measuring each of \p qubits 
+ * and restoring the clone \p numShots times, since the cumulative probability of the basis 
+ * states is computed only once (in parallel, and distributed), through which every 
+ * shot is drawn.
+ *
+ * The outcome of shot \p s is written to \p outcomes[s] as an integer whose \p i-th bit 
+ * (from the right) is the outcome of qubit \p qubits[i]. For example, measuring 
+ * \p qubits \p = \p {3, 0} of basis state \f$|1000\rangle\f$ gives outcome \p 1.
+ *
+ * For state-vectors, basis states are drawn with probabilities of their absolute-value-squared 
+ * amplitudes, and for density matrices, of their (real) diagonal elements, which are in 
+ * either case normalised by their sum. Hence this function samples un-normalised states 
+ * as if they were normalised, and never samples a (non-physical) negative diagonal element.
+ *
+ * Like measure(), this consumes the random number generator, which can be reseeded 
+ * with seedQuEST() to reproduce the sampled outcomes.
+ *
+ * @ingroup calc
+ * @param[in] qureg object representing the set of all qubits
+ * @param[in] qubits a list of the unique qubits to be measured in each shot
+ * @param[in] numQubits the length of list \p qubits
+ * @param[in] numShots the number of outcomes to sample
+ * @param[out] outcomes a list of length \p numShots, to be populated with the sampled outcomes
+ * @throws invalidQuESTInputError
+ *      if any index in \p qubits is outside [0, \p qureg.numQubitsRepresented),
+ *      or if \p qubits contains a repetition,
+ *      or if \p numQubits is outside [1, \p qureg.numQubitsRepresented],
+ *      or if \p numShots \p <= \p 0
+ */
+void sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes);
+
 /** Updates \p qureg to be consistent with measuring \p measureQubit in the given 
  * \p outcome (0 or 1), and returns the probability of such a measurement outcome. 
  * This is effectively performing a projection, or a measurement with a forced outcome.
@@ -2168,6 +2493,89 @@ void seedQuESTDefault(void);
  **/
 void seedQuEST(unsigned long int *seedArray, int numSeeds);
 
+/** Enable gate fusion. Unitaries subsequently applied to \p qureg are no longer 
+ * immediately effected upon the state. Instead, consecutive unitaries are greedily 
+ * multiplied into a single dense matrix upon at most \p maxNumQubits qubits (counting 
+ * both control and target qubits), which is applied to the state in one pass 
+ * when the next unitary would grow it beyond \p maxNumQubits qubits. Long sequences 
+ * of few-qubit gates hence cost far fewer passes over the state-vector.
+ *
+ * The fused gates are (in addition to their controlled variants where they exist) 
+ * hadamard(), pauliX(), pauliY(), pauliZ(), sGate(), tGate(), phaseShift(), 
+ * rotateX(), rotateY(), rotateZ(), rotateAroundAxis(), compactUnitary(), unitary(), 
+ * controlledNot(), controlledPhaseFlip(), controlledPhaseShift(), swapGate(), 
+ * sqrtSwapGate(), twoQubitUnitary() and multiQubitUnitary(). A gate upon more than 
+ * \p maxNumQubits qubits is applied directly, after any pending fused matrix.
+ *
+ * Diagonal gates (pauliZ(), sGate(), tGate(), phaseShift(), rotateZ(), 
+ * controlledPhaseShift(), multiControlledPhaseShift(), controlledPhaseFlip(), 
+ * multiControlledPhaseFlip(), controlledRotateZ() and multiRotateZ()) which act 
+ * only upon qubits of the pending fused matrix are fused into it. Otherwise, they 
+ * are accumulated (regardless of \p maxNumQubits and of how many qubits they span) 
+ * into a list of phases, which are all applied in a single pass, computing each 
+ * amplitude's total phase from its index bits. Ladders of controlled phase gates, 
+ * as in the quantum Fourier transform or a QAOA cost layer, hence cost one pass. 
+ * The accumulated phases (after the pending fused matrix) are applied before the 
+ * next non-diagonal gate.
+ *
+ * Any other function which reads or modifies the state of \p qureg (such as 
+ * the calculations, measurements, decoherence channels and operators) first 
+ * applies the pending fused matrix, so fusion never changes the results of a 
+ * program, except by floating-point error. QASM recording is unaffected by fusion.
+ * 
+ * Fusing a gate costs O(2^(2 \p maxNumQubits)) operations, independent of the 
+ * size of \p qureg, so \p maxNumQubits should be small (e.g. 3 to 5), and 
+ * \p qureg should be sufficiently large that a pass over its state dominates.
+ *
+ * @ingroup fusion
+ * @param[in,out] qureg The qureg upon which to fuse subsequent unitaries
+ * @param[in] maxNumQubits the maximum number of qubits upon which a fused matrix may act
+ * @throws invalidQuESTInputError
+ *      if \p maxNumQubits is outside [1, \p qureg.numQubitsRepresented], or exceeds 10, 
+ *      or if a \p maxNumQubits-qubit matrix cannot fit in a distributed node's amplitudes
+ */
+void startGateFusion(Qureg qureg, int maxNumQubits);
+
+/** Disable gate fusion, first applying any pending fused unitaries to \p qureg. 
+ * Subsequent unitaries are immediately applied. See startGateFusion().
+ *
+ * @ingroup fusion
+ * @param[in,out] qureg The qureg upon which to cease fusing unitaries
+ */
+void stopGateFusion(Qureg qureg);
+
+/** Enable gate fusion, as per startGateFusion(), and additionally apply the 
+ * fused matrices with cache blocking. Rather than applying each fused matrix to 
+ * the state as soon as it is complete, every fused matrix which targets only 
+ * qubits below \p numBlockQubits is queued. The queue is applied in a single 
+ * (parallelised) sweep over the state, partitioned into blocks of 2^\p numBlockQubits 
+ * contiguous amplitudes, in which every queued matrix is applied to a block before 
+ * the next block is visited. A long sequence of low-qubit gates hence reads and 
+ * writes the state from main memory once, rather than once per fused matrix.
+ *
+ * A fused matrix upon any qubit at or above \p numBlockQubits (or any other 
+ * function which reads or modifies the state) acts as a barrier: the queue is 
+ * first applied, then the matrix is applied directly. For density matrices, 
+ * the conjugate matrix acts upon the shifted qubits, which are only rarely 
+ * below \p numBlockQubits, so blocking chiefly benefits state-vectors.
+ *
+ * A block of 2^\p numBlockQubits amplitudes occupies 2^(\p numBlockQubits + 1) 
+ * ::qreal, and should fit within (a thread's share of) the L2 cache. For example, 
+ * with double precision and a 1 MiB L2 cache, \p numBlockQubits = 15. Calling 
+ * stopGateFusion() applies any queued and pending matrices and disables fusion.
+ *
+ * @ingroup fusion
+ * @param[in,out] qureg The qureg upon which to fuse subsequent unitaries
+ * @param[in] maxNumQubits the maximum number of qubits upon which a fused matrix may act
+ * @param[in] numBlockQubits the number of (least significant) qubits spanned by a cache block
+ * @throws invalidQuESTInputError
+ *      if \p maxNumQubits is outside [1, \p qureg.numQubitsRepresented], or exceeds 10, 
+ *      or if a \p maxNumQubits-qubit matrix cannot fit in a distributed node's amplitudes, 
+ *      or if \p numBlockQubits is less than \p maxNumQubits, 
+ *      or if a block of 2^\p numBlockQubits amplitudes cannot fit in a distributed node's amplitudes
+ */
+void startBlockedGateFusion(Qureg qureg, int maxNumQubits, int numBlockQubits);
+
 /** Enable QASM recording. Gates applied to qureg will here-after be added to a
  * growing log of QASM instructions, progressively consuming more memory until 
  * disabled with stopRecordingQASM(). The QASM log is bound to this qureg instance.
@@ -2696,12 +3104,12 @@ void multiRotateZ(Qureg qureg, int* qubits, int numQubits, qreal angle);
  * by supplying 0 pauli-codes. Hence, if all \p targetPaulis are identity, then 
  * this function does nothing to \p qureg.
  *
- * This function effects this unitary by first rotating the qubits which are 
- * nominated to receive X or Y Paulis into alternate basis, performing 
- * multiRotateZ on all target qubits receiving X, Y or Z Paulis, then restoring 
- * the original basis. In the worst case, this means that 1+2*\p numTargets
- * primitive unitaries are performed on the statevector, and double this on 
- * density matrices.
+ * This function effects this unitary as 
+ * \f$ \cos(\theta/2) \, \hat{1} - i \sin(\theta/2) \, \hat{\sigma} \f$ upon every pair
+ * of amplitudes whose indices differ in the qubits receiving X or Y Paulis, with a
+ * sign given by the parity of the qubits receiving Y or Z Paulis. This means a single
+ * pass is performed on the statevector regardless of \p numTargets, and two passes
+ * on density matrices. If no X or Y Paulis are given, this is equivalent to multiRotateZ().
  *
  * @ingroup unitary
  * @param[in,out] qureg object representing the set of all qubits
@@ -2735,16 +3143,15 @@ void multiRotatePauli(Qureg qureg, int* targetQubits, enum pauliOpType* targetPa
  * applies to the least-significant qubit, i.e. that with index 0).
  *
  * \p workspace must be a register with the same type (statevector vs density matrix) and dimensions 
- * (number of represented qubits) as \p qureg, and is used as working space. When this function returns, \p qureg 
- * will be unchanged and \p workspace will be set to \f$ \sigma | \psi \rangle \f$ (if \p qureg is a statevector)
- * or \f$ \sigma \rho \f$ (if \p qureg is a density matrix). NOTE that this last quantity is NOT the result of applying 
- * the paulis as unitaries, \f$ \sigma^\dagger \rho \sigma \f$, but is instead the result of their direct 
- * multiplication with the density matrix. It is therefore itself not a valid density matrix.
+ * (number of represented qubits) as \p qureg, but is no longer used nor modified, and is retained 
+ * only for backward compatibility. Passing \p qureg itself as \p workspace is permitted, so 
+ * that no second register need be created.
  *
- * This function works by cloning the \p qureg state into \p workspace, applying the specified 
- * Pauli operators to \p workspace then computing its inner product with \p qureg (for statevectors)
- * or its trace (for density matrices). It therefore should scale linearly in time with the number of 
- * specified non-identity Pauli operators, which is bounded by the number of represented qubits.
+ * This function works by encoding the Pauli operators as bit masks of their X (or Y) and Z (or Y) 
+ * targets, and evaluating \f$ \sum_i \psi_{i \oplus x}^* \, (-1)^{|i \wedge z|} \, \psi_i \f$ (times \f$ i^{\#Y} \f$)
+ * in a single read-only pass over \p qureg. It therefore takes the same time irrespective of the 
+ * number of specified non-identity Pauli operators. Density matrices instead sum one element 
+ * \f$ \rho_{i, i \oplus x} \f$ per column, which requires no communication when distributed.
  *
  * @ingroup calc
  * @param[in] qureg the register of which to find the expected value, which is unchanged by this function
@@ -2752,8 +3159,8 @@ void multiRotatePauli(Qureg qureg, int* targetQubits, enum pauliOpType* targetPa
  * @param[in] pauliCodes a list of the Pauli codes (0=PAULI_I, 1=PAULI_X, 2=PAULI_Y, 3=PAULI_Z) 
  *      to apply to the corresponding qubits in \p targetQubits
  * @param[in] numTargets number of target qubits, i.e. the length of \p targetQubits and \p pauliCodes
- * @param[in,out] workspace a working-space qureg with the same dimensions as \p qureg, which is modified 
- *      to be the result of multiplying the state with the pauli operators
+ * @param[in] workspace a qureg with the same type and dimensions as \p qureg (possibly \p qureg 
+ *      itself), which is unused and unchanged
  * @throws invalidQuESTInputError
  *      if \p numTargets is outside [1, \p qureg.numQubitsRepresented]),
  *      or if any qubit in \p targetQubits is outside [0, \p qureg.numQubitsRepresented))
@@ -2787,15 +3194,15 @@ qreal calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauli
  * applies to the least-significant qubit, i.e. that with index 0).
  * 
  * \p workspace must be a register with the same type (statevector vs density matrix) and dimensions 
- * (number of represented qubits) as \p qureg, and is used as working space. When this function returns, \p qureg 
- * will be unchanged and \p workspace will be set to \p qureg pre-multiplied with the final Pauli product.
- * NOTE that if \p qureg is a density matrix, \p workspace will become \f$ \hat{\sigma} \rho \f$ 
- * which is itself not a density matrix (it is distinct from \f$ \hat{\sigma} \rho \hat{\sigma}^\dagger \f$).
+ * (number of represented qubits) as \p qureg, but is no longer used nor modified, and is retained 
+ * only for backward compatibility. Passing \p qureg itself as \p workspace is permitted.
  *
- * This function works by cloning the \p qureg state into \p workspace, applying each of the specified
- * Pauli products to \p workspace (one Pauli operation at a time), then computing its inner product with \p qureg (for statevectors)
- * or its trace (for density matrices) multiplied with the corresponding coefficient, and summing these contributions. 
- * It therefore should scale linearly in time with the total number of non-identity specified Pauli operators.
+ * This function works by grouping the Pauli products which have the same X and Y operators 
+ * (merging any repeated products), since these involve the same pairs of amplitudes. Each group
+ * is then evaluated in a single read-only pass over \p qureg (as per calcExpecPauliProd()), 
+ * in which every amplitude pair is weighted by the summed signs and coefficients of the group's
+ * products. It therefore performs one pass per distinct X mask, rather than per term, though 
+ * the arithmetic still grows linearly with the number of terms.
  *
  * @ingroup calc
  * @param[in] qureg the register of which to find the expected value, which is unchanged by this function
@@ -2804,8 +3211,8 @@ qreal calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauli
  *      in the register, in every term of the sum.
  * @param[in] termCoeffs The coefficients of each term in the sum of Pauli products
  * @param[in] numSumTerms The total number of Pauli products specified
- * @param[in,out] workspace a working-space qureg with the same dimensions as \p qureg, which is modified 
- *      to be the result of multiplying the state with the final specified Pauli product
+ * @param[in] workspace a qureg with the same type and dimensions as \p qureg (possibly \p qureg 
+ *      itself), which is unused and unchanged
  * @throws invalidQuESTInputError
  *      if any code in \p allPauliCodes is not in {0,1,2,3},
  *      or if numSumTerms <= 0,
@@ -2825,22 +3232,14 @@ qreal calcExpecPauliSum(Qureg qureg, enum pauliOpType* allPauliCodes, qreal* ter
  * there for an elaboration.
  * 
  * \p workspace must be a register with the same type (statevector vs density matrix) and dimensions 
- * (number of represented qubits) as \p qureg and \p hamil, and is used as working space. 
- * When this function returns, \p qureg  will be unchanged and \p workspace will be set to
- * \p qureg pre-multiplied with the final Pauli product in \p hamil.
- * NOTE that if \p qureg is a density matrix, \p workspace will become \f$ \hat{\sigma} \rho \f$ 
- * which is itself not a density matrix (it is distinct from \f$ \hat{\sigma} \rho \hat{\sigma}^\dagger \f$).
- *
- * This function works by cloning the \p qureg state into \p workspace, applying each of the specified
- * Pauli products in \p hamil to \p workspace (one Pauli operation at a time), then computing its inner product with \p qureg (for statevectors)
- * or its trace (for density matrices) multiplied with the corresponding coefficient, and summing these contributions. 
- * It therefore should scale linearly in time with the total number of non-identity specified Pauli operators.
+ * (number of represented qubits) as \p qureg and \p hamil, but is no longer used nor modified, 
+ * and is retained only for backward compatibility. Passing \p qureg itself as \p workspace is permitted.
  *
  * @ingroup calc
  * @param[in] qureg the register of which to find the expected value, which is unchanged by this function
  * @param[in] hamil a \p PauliHamil created with createPauliHamil() or createPauliHamilFromFile()
- * @param[in,out] workspace a working-space qureg with the same dimensions as \p qureg, which is modified 
- *      to be the result of multiplying the state with the final specified Pauli product
+ * @param[in] workspace a qureg with the same type and dimensions as \p qureg (possibly \p qureg 
+ *      itself), which is unused and unchanged
  * @throws invalidQuESTInputError
  *      if any code in \p hamil.pauliCodes is not a valid Pauli code,
  *      or if \p hamil.numSumTerms <= 0,
@@ -3276,6 +3675,34 @@ void controlledMultiQubitUnitary(Qureg qureg, int ctrl, int* targs, int numTargs
  */
 void multiControlledMultiQubitUnitary(Qureg qureg, int* ctrls, int numCtrls, int* targs, int numTargs, ComplexMatrixN u);
 
+/** Apply a NOT (or Pauli X) gate with multiple control and target qubits. 
+ * This applies pauliX to every qubit in \p targs, upon only the basis states 
+ * in which every qubit in \p ctrls has value 1. For example, with one control 
+ * and one target, this is controlledNot().
+ *
+ * This is equivalent to (but much faster than) effecting the tensor product of 
+ * X upon each target with multiControlledMultiQubitUnitary(), since it merely 
+ * permutes the amplitudes satisfying the controls; no arithmetic is performed, 
+ * and amplitudes not satisfying the controls are not visited.
+ *
+ * Unlike multiControlledMultiQubitUnitary(), any number of targets is permitted 
+ * in distributed mode, since a NOT upon qubits beyond a node's amplitudes merely 
+ * exchanges them with one other node.
+ *
+ * @ingroup unitary
+ * @param[in,out] qureg object representing the set of all qubits
+ * @param[in] ctrls a list of the control qubits
+ * @param[in] numCtrls the number of control qubits
+ * @param[in] targs a list of the target qubits
+ * @param[in] numTargs the number of target qubits
+ * @throws invalidQuESTInputError
+ *      if any index in \p ctrls and \p targs is outside of [0, \p qureg.numQubitsRepresented),
+ *      or if \p ctrls and \p targs are not unique,
+ *      or if \p numTargs is outside [1, \p qureg.numQubitsRepresented],
+ *      or if \p numCtrls is outside [1, \p qureg.numQubitsRepresented)
+ */
+void multiControlledMultiQubitNot(Qureg qureg, int* ctrls, int numCtrls, int* targs, int numTargs);
+
 /** Apply a general single-qubit Kraus map to a density matrix, as specified by at most 
  * four Kraus operators, \f$K_i\f$ (\p ops). A Kraus map is also referred to as 
  * a "operator-sum representation" of a quantum channel, and enables the simulation of 
@@ -3466,22 +3893,21 @@ void setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg qureg2, Co
  * will apply Hermitian operation \f$ (1.5 X I I - 3.6 X Y Z) \f$ 
  * (where in this notation, the left-most operator applies to the least-significant qubit, i.e. that with index 0).
  *
- * In theory, \p inQureg is unchanged though its state is temporarily 
- * modified and is reverted by re-applying Paulis (XX=YY=ZZ=I), so may see a change by small numerical errors.
- * The initial state in \p outQureg is not used.
+ * \p inQureg is only read, and is unchanged. The initial state in \p outQureg is not used.
  *
  * \p inQureg and \p outQureg must both be state-vectors, or both density matrices,
  * of equal dimensions. \p inQureg cannot be \p outQureg.
  *
- * This function works by applying each Pauli product to \p inQureg in turn, 
- * and adding the resulting state (weighted by a coefficient in \p termCoeffs)
- * to the initially-blanked \p outQureg. Ergo it should scale with the total number 
- * of Pauli operators specified (excluding identities), and the qureg dimension. 
+ * This function works by grouping the Pauli products which have the same X and Y operators 
+ * (merging any repeated products), since these map the same amplitudes of \p inQureg
+ * to the same amplitudes of \p outQureg. Each group is then added to the initially-blanked 
+ * \p outQureg in a single pass, which sets every output amplitude to its weighted input 
+ * amplitude, \f$ \psi^{\text{out}}_i \mathrel{+}= \sum_t c_t \, i^{\#Y_t} (-1)^{|(i \oplus x) \wedge z_t|} \, \psi^{\text{in}}_{i \oplus x} \f$.
+ * Ergo it should scale with the number of distinct X masks, and the qureg dimension. 
  *
  * @ingroup operator
  * @param[in] inQureg the register containing the state which \p outQureg will be set to, under
- *      the action of the Hermitiain operator specified by the Pauli codes. \p inQureg should be 
- *      unchanged, though may vary slightly due to numerical error.
+ *      the action of the Hermitiain operator specified by the Pauli codes. \p inQureg is unchanged.
  * @param[in] allPauliCodes a list of the Pauli codes (0=PAULI_I, 1=PAULI_X, 2=PAULI_Y, 3=PAULI_Z) 
  *      of all Paulis involved in the products of terms. A Pauli must be specified for each qubit 
  *      in the register, in every term of the sum.
@@ -3509,22 +3935,19 @@ void applyPauliSum(Qureg inQureg, enum pauliOpType* allPauliCodes, qreal* termCo
  * this function effects \f$ \alpha | \psi \rangle \f$ on statevector \f$ |\psi\rangle \f$
  * and \f$\alpha \rho\f$ (left matrix multiplication) on density matrix \f$ \rho \f$.
  *
- * In theory, \p inQureg is unchanged though its state is temporarily 
- * modified and is reverted by re-applying Paulis (XX=YY=ZZ=I), so may see a change by small numerical errors.
- * The initial state in \p outQureg is not used.
+ * \p inQureg is only read, and is unchanged. The initial state in \p outQureg is not used.
  *
  * \p inQureg and \p outQureg must both be state-vectors, or both density matrices,
  * of equal dimensions to \p hamil.
  * \p inQureg cannot be \p outQureg.
  *
- * This function works by applying each Pauli product in \p hamil to \p inQureg in turn, 
- * and adding the resulting state (weighted by a coefficient in \p termCoeffs)
- * to the initially-blanked \p outQureg. Ergo it should scale with the total number 
- * of Pauli operators specified (excluding identities), and the qureg dimension. 
+ * This function works by applying each group of Pauli products in \p hamil with the same
+ * X and Y operators in a single pass (see applyPauliSum()). Ergo it should scale with 
+ * the number of distinct X masks, and the qureg dimension. 
  *
  * @ingroup operator
  * @param[in] inQureg the register containing the state which \p outQureg will be set to, under
- *      the action of \p hamil. \p inQureg should be unchanged, though may vary slightly due to numerical error.
+ *      the action of \p hamil. \p inQureg is unchanged.
  * @param[in] hamil a weighted sum of products of pauli operators
  * @param[out] outQureg the qureg to modify to be the result of applyling \p hamil to the state in \p inQureg
  * @throws invalidQuESTInputError
@@ -3594,6 +4017,53 @@ void applyPauliHamil(Qureg inQureg, PauliHamil hamil, Qureg outQureg);
  */
 void applyTrotterCircuit(Qureg qureg, PauliHamil hamil, qreal time, int order, int reps);
 
+/** Prepares the Trotter circuit of applyTrotterCircuit() once, so that it can be
+ * cheaply applied to many registers, or many times, with applyTrotterPlan().
+ *
+ * The rotations prescribed by the decomposition are simplified without approximation.
+ * A rotation is merged into an earlier rotation of the same Pauli product (by summing
+ * their angles) whenever every rotation between them commutes with it, as occurs at the
+ * boundaries of the symmetrized decompositions and of consecutive repetitions. A rotation
+ * of only Z (and identity) operators is similarly moved beside an earlier such rotation,
+ * so that consecutive diagonal rotations are applied in a single pass by applyTrotterPlan().
+ * Terms of \p hamil which are only identity operators contribute a global phase, and are omitted.
+ *
+ * The returned \p TrotterPlan must later be freed via destroyTrotterPlan(), and
+ * does not depend on \p hamil, which may be subsequently modified or destroyed.
+ *
+ * @ingroup operator
+ * @param[in] hamil the hamiltonian under which to approximate unitary-time evolution
+ * @param[in] time the target evolution time, which is permitted to be both positive and negative.
+ * @param[in] order the order of Trotter-Suzuki decomposition to use, as per applyTrotterCircuit()
+ * @param[in] reps the number of repetitions of the decomposition of the given order
+ * @returns a dynamic \p TrotterPlan, with its fields stored in the heap
+ * @throws invalidQuESTInputError if \p hamil contains invalid parameters or Pauli codes,
+ *      or if \p order is not in {1, 2, 4, 6, ...}
+ *      or if \p reps <= 0.
+ */
+TrotterPlan createTrotterPlan(PauliHamil hamil, qreal time, int order, int reps);
+
+/** Applies the Trotter circuit prepared by createTrotterPlan() to \p qureg.
+ * This effects the same operator as applyTrotterCircuit() with the parameters of the
+ * plan, but without re-deriving the circuit.
+ *
+ * Note that the applied circuit is captured by QASM, if QASM logging is enabled
+ * on \p qureg.
+ *
+ * @ingroup operator
+ * @param[in,out] qureg the register to modify under the approximate unitary-time evolution
+ * @param[in] plan the circuit created by createTrotterPlan()
+ * @throws invalidQuESTInputError if \p qureg.numQubitsRepresented != \p plan.numQubits
+ */
+void applyTrotterPlan(Qureg qureg, TrotterPlan plan);
+
+/** Destroy a \p TrotterPlan instance, created with createTrotterPlan().
+ *
+ * @ingroup operator
+ * @param[in] plan a dynamic \p TrotterPlan instantiation
+ */
+void destroyTrotterPlan(TrotterPlan plan);
+
 /** Apply a general 2-by-2 matrix, which may be non-unitary. The matrix is 
  * left-multiplied onto the state, for both state-vectors and density matrices.
  * Hence, this function differs from unitary() by more than just permitting a non-unitary 
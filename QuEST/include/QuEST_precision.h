@@ -27,7 +27,9 @@
  */
 # if QuEST_PREC==1
     # define qreal float
+    # define qaccum double
     // \cond HIDDEN_SYMBOLS   
+    # define MPI_QuEST_ACCUM MPI_DOUBLE
     # define MPI_QuEST_REAL MPI_FLOAT
     # define MPI_MAX_AMPS_IN_MSG (1LL<<29) // must be 2^int
     # define REAL_STRING_FORMAT "%.8f"
@@ -41,7 +43,9 @@
  */
 # elif QuEST_PREC==2
     # define qreal double
+    # define qaccum double
     // \cond HIDDEN_SYMBOLS   
+    # define MPI_QuEST_ACCUM MPI_DOUBLE
     # define MPI_QuEST_REAL MPI_DOUBLE
     # define MPI_MAX_AMPS_IN_MSG (1LL<<28) // must be 2^int
     # define REAL_STRING_FORMAT "%.14f"
@@ -56,7 +60,9 @@
  */
 # elif QuEST_PREC==4
     # define qreal long double
+    # define qaccum long double
     // \cond HIDDEN_SYMBOLS   
+    # define MPI_QuEST_ACCUM MPI_LONG_DOUBLE
     # define MPI_QuEST_REAL MPI_LONG_DOUBLE
     # define MPI_MAX_AMPS_IN_MSG (1LL<<27) // must be 2^int
     # define REAL_STRING_FORMAT "%.17Lf"
@@ -76,6 +82,8 @@
  * This should be passed as a macro to the preprocessor during compilation, which overwrites the
  * value explicitly defined in \ref QuEST_precision.h.
  * Note that quad precision is not compatible with most GPUs.
+ * The precision is fixed per library build; see \ref getQuEST_PREC for using builds of 
+ * several precisions within one program.
  *
  * @ingroup type
  * @author Ania Brown
@@ -92,4 +100,16 @@
  * @author Tyson Jones (doc)
  */
 
+/** @def qaccum
+ *
+ * The type in which the CPU backend accumulates sums over amplitudes, such as the reductions of
+ * \ref calcTotalProb, \ref calcInnerProduct and the calcExpec* functions, and the matrix-vector
+ * products of the multi-qubit unitary kernels. It is at least double precision, so that a
+ * single precision build (\ref QuEST_PREC = 1) stores amplitudes as floats, halving memory and
+ * communication, while its sums of many amplitudes are not limited to single precision.
+ * Results are still returned as \ref qreal.
+ *
+ * @ingroup type
+ */
+
 # endif // QUEST_PRECISION_H
@@ -10,9 +10,16 @@
  * @author Balint Koczor
  */
 
+// expose posix_memalign(), mmap() and madvise() despite -std=c99
+# if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+# define _DEFAULT_SOURCE
+# endif
+
 # include "QuEST.h"
 # include "QuEST_internal.h"
 # include "QuEST_precision.h"
+# include "QuEST_validation.h"
+# include "QuEST_fusion.h"
 # include "mt19937ar.h"
 
 # include "QuEST_cpu_internal.h"
@@ -20,6 +27,7 @@
 # include <math.h>  
 # include <stdio.h>
 # include <stdlib.h>
+# include <string.h>
 # include <stdint.h>
 # include <assert.h>
 
@@ -27,6 +35,13 @@
 # include <omp.h>
 # endif
 
+# ifdef _WIN32
+# include <malloc.h>
+# else
+# include <sys/mman.h>
+# include <unistd.h>
+# endif
+
 
 
 /*
@@ -34,9 +49,11 @@
  */
 
 void copyStateToGPU(Qureg qureg) {
+    fusion_flush(qureg);
 }
 
 void copyStateFromGPU(Qureg qureg) {
+    fusion_flush(qureg);
 }
 
 
@@ -864,27 +881,32 @@ qreal densmatr_calcPurityLocal(Qureg qureg) {
     long long int index;
     long long int numAmps = qureg.numAmpsPerChunk;
         
-    qreal trace = 0;
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum traceParts[numThreadSums];
+    initThreadSums(traceParts, numThreadSums);
+    CompensatedSum threadTrace;
     qreal *vecRe = qureg.stateVec.real;
     qreal *vecIm = qureg.stateVec.imag;
     
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (vecRe, vecIm, numAmps) \
-    private   (index) \
-    reduction ( +:trace )
+    shared    (vecRe, vecIm, numAmps, traceParts) \
+    private   (index, threadTrace)
 # endif 
     {
+        threadTrace = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
         for (index=0LL; index<numAmps; index++) {
                         
-            trace += vecRe[index]*vecRe[index] + vecIm[index]*vecIm[index];
+            addToCompensatedSum(&threadTrace, 
+                (qaccum) vecRe[index]*vecRe[index] + (qaccum) vecIm[index]*vecIm[index]);
         }
+        setThreadSum(traceParts, threadTrace);
     }
     
-    return trace;
+    return getThreadSumsValue(traceParts, numThreadSums);
 }
 
 void densmatr_mixDensityMatrix(Qureg combineQureg, qreal otherProb, Qureg otherQureg) {
@@ -930,8 +952,8 @@ qreal densmatr_calcHilbertSchmidtDistanceSquaredLocal(Qureg a, Qureg b) {
     qreal *bRe = b.stateVec.real;
     qreal *bIm = b.stateVec.imag;
     
-    qreal trace = 0;
-    qreal difRe, difIm;
+    qaccum trace = 0;
+    qaccum difRe, difIm;
     
 # ifdef _OPENMP
 # pragma omp parallel \
@@ -945,8 +967,8 @@ qreal densmatr_calcHilbertSchmidtDistanceSquaredLocal(Qureg a, Qureg b) {
 # endif
         for (index=0LL; index<numAmps; index++) {
                         
-            difRe = aRe[index] - bRe[index];
-            difIm = aIm[index] - bIm[index];
+            difRe = (qaccum) aRe[index] - bRe[index];
+            difIm = (qaccum) aIm[index] - bIm[index];
             trace += difRe*difRe + difIm*difIm;
         }
     }
@@ -965,24 +987,29 @@ qreal densmatr_calcInnerProductLocal(Qureg a, Qureg b) {
     qreal *bRe = b.stateVec.real;
     qreal *bIm = b.stateVec.imag;
     
-    qreal trace = 0;
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum traceParts[numThreadSums];
+    initThreadSums(traceParts, numThreadSums);
+    CompensatedSum threadTrace;
     
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (aRe,aIm, bRe,bIm, numAmps) \
-    private   (index) \
-    reduction ( +:trace )
+    shared    (aRe,aIm, bRe,bIm, numAmps, traceParts) \
+    private   (index, threadTrace)
 # endif 
     {
+        threadTrace = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
         for (index=0LL; index<numAmps; index++) {
-            trace += aRe[index]*bRe[index] + aIm[index]*bIm[index];
+            addProductToCompensatedSum(&threadTrace, aRe[index], bRe[index]);
+            addProductToCompensatedSum(&threadTrace, aIm[index], bIm[index]);
         }
+        setThreadSum(traceParts, threadTrace);
     }
     
-    return trace;
+    return getThreadSumsValue(traceParts, numThreadSums);
 }
 
 
@@ -1018,13 +1045,13 @@ qreal densmatr_calcFidelityLocal(Qureg qureg, Qureg pureState) {
     // starting GLOBAL column index of the qureg columns on this node
     int startCol = (int) (qureg.chunkId * pureState.numAmpsPerChunk);
     
-    qreal densElemRe, densElemIm;
-    qreal prefacRe, prefacIm;
-    qreal rowSumRe, rowSumIm;
-    qreal vecElemRe, vecElemIm;
+    qaccum densElemRe, densElemIm;
+    qaccum prefacRe, prefacIm;
+    qaccum rowSumRe, rowSumIm;
+    qaccum vecElemRe, vecElemIm;
     
     // quantity computed by this node
-    qreal globalSumRe = 0;   // imag-component is assumed zero
+    qaccum globalSumRe = 0;   // imag-component is assumed zero
     
 # ifdef _OPENMP
 # pragma omp parallel \
@@ -1070,8 +1097,12 @@ qreal densmatr_calcFidelityLocal(Qureg qureg, Qureg pureState) {
 
 Complex statevec_calcInnerProductLocal(Qureg bra, Qureg ket) {
     
-    qreal innerProdReal = 0;
-    qreal innerProdImag = 0;
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum innerProdRealParts[numThreadSums];
+    initThreadSums(innerProdRealParts, numThreadSums);
+    CompensatedSum innerProdImagParts[numThreadSums];
+    initThreadSums(innerProdImagParts, numThreadSums);
+    CompensatedSum threadProdReal, threadProdImag;
     
     long long int index;
     long long int numAmps = bra.numAmpsPerChunk;
@@ -1080,15 +1111,16 @@ Complex statevec_calcInnerProductLocal(Qureg bra, Qureg ket) {
     qreal *ketVecReal = ket.stateVec.real;
     qreal *ketVecImag = ket.stateVec.imag;
     
-    qreal braRe, braIm, ketRe, ketIm;
+    qaccum braRe, braIm, ketRe, ketIm;
     
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (braVecReal, braVecImag, ketVecReal, ketVecImag, numAmps) \
-    private   (index, braRe, braIm, ketRe, ketIm) \
-    reduction ( +:innerProdReal, innerProdImag )
+    shared    (braVecReal, braVecImag, ketVecReal, ketVecImag, numAmps, innerProdRealParts, innerProdImagParts) \
+    private   (index, braRe, braIm, ketRe, ketIm, threadProdReal, threadProdImag)
 # endif 
     {
+        threadProdReal = (CompensatedSum) {0, 0};
+        threadProdImag = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
@@ -1099,14 +1131,18 @@ Complex statevec_calcInnerProductLocal(Qureg bra, Qureg ket) {
             ketIm = ketVecImag[index];
             
             // conj(bra_i) * ket_i
-            innerProdReal += braRe*ketRe + braIm*ketIm;
-            innerProdImag += braRe*ketIm - braIm*ketRe;
+            addProductToCompensatedSum(&threadProdReal, braRe, ketRe);
+            addProductToCompensatedSum(&threadProdReal, braIm, ketIm);
+            addProductToCompensatedSum(&threadProdImag, braRe, ketIm);
+            addProductToCompensatedSum(&threadProdImag, -braIm, ketRe);
         }
+        setThreadSum(innerProdRealParts, threadProdReal);
+        setThreadSum(innerProdImagParts, threadProdImag);
     }
     
     Complex innerProd;
-    innerProd.real = innerProdReal;
-    innerProd.imag = innerProdImag;
+    innerProd.real = getThreadSumsValue(innerProdRealParts, numThreadSums);
+    innerProd.imag = getThreadSumsValue(innerProdImagParts, numThreadSums);
     return innerProd;
 }
 
@@ -1276,7 +1312,159 @@ void statevec_setAmps(Qureg qureg, long long int startInd, qreal* reals, qreal*
     }
 }
 
-void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
+/* every amplitude array is aligned to a cache line (which is also an AVX-512 vector) */
+# define AMP_ARRAY_ALIGNMENT 64
+
+/* arrays under the huge-page policies are aligned to, and mapped in multiples of, a huge page */
+# define HUGE_PAGE_SIZE (2*1024*1024)
+
+# if defined(__linux__) && defined(MAP_HUGETLB) && defined(MADV_HUGEPAGE)
+# define HUGE_PAGES_SUPPORTED
+# endif
+
+/** Returns the policy actually used to allocate an array of arrSize bytes; arrays 
+ * smaller than a huge page cannot benefit from one, and Windows cannot file-map, so
+ * these fall back to the default.
+ * This is deterministic so that freeAmpArray() agrees with allocAmpArray()
+ */
+static enum memoryPolicy getAmpArrayPolicy(size_t arrSize, enum memoryPolicy policy) {
+# ifdef _WIN32
+    if (policy == MEMORY_FILE_MAPPED)
+        return MEMORY_DEFAULT;
+# endif
+    if (policy != MEMORY_FILE_MAPPED && arrSize < HUGE_PAGE_SIZE)
+        return MEMORY_DEFAULT;
+    return policy;
+}
+
+static size_t getHugePageMapSize(size_t arrSize) {
+    return ((arrSize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+}
+
+# ifndef _WIN32
+/** Maps an array of arrSize bytes onto a new file in the directory named by the 
+ * QUEST_FILE_MAPPED_DIR environment variable (validated to be set by the front-end). 
+ * There is no fallback to the temporary directory, which is often RAM-backed (tmpfs) 
+ * and so would defeat the policy. The file is unlinked immediately, so that it is 
+ * removed when unmapped or the process exits
+ */
+static qreal* allocFileMappedAmpArray(size_t arrSize) {
+    
+    const char* dir = getenv("QUEST_FILE_MAPPED_DIR");
+    if (dir == NULL || dir[0] == '\0')
+        return NULL;
+    
+    char fn[FILENAME_MAX];
+    if (snprintf(fn, sizeof fn, "%s/QuEST_amps_XXXXXX", dir) >= (int) sizeof fn)
+        return NULL;
+    int fd = mkstemp(fn);
+    if (fd == -1)
+        return NULL;
+    unlink(fn);
+    
+    // the file is sparse, so its blocks are only allocated when first written
+    void* arr = MAP_FAILED;
+    if (ftruncate(fd, (off_t) arrSize) == 0)
+        arr = mmap(NULL, arrSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (arr == MAP_FAILED)
+        return NULL;
+    
+    // kernels sweep contiguous runs of amplitudes, so read ahead aggressively and 
+    // release pages behind; the OS writes back modified pages in the background
+    madvise(arr, arrSize, MADV_SEQUENTIAL);
+    return (qreal*) arr;
+}
+# endif
+
+/** Allocates an uninitialised array of arrSize bytes under the given policy, returning NULL on failure */
+static qreal* allocAmpArray(size_t arrSize, enum memoryPolicy policy) {
+    
+    policy = getAmpArrayPolicy(arrSize, policy);
+    size_t alignment = (policy == MEMORY_DEFAULT)? AMP_ARRAY_ALIGNMENT : HUGE_PAGE_SIZE;
+    void* arr = NULL;
+    
+# ifdef _WIN32
+    arr = _aligned_malloc(arrSize, alignment);
+# else
+    
+    if (policy == MEMORY_FILE_MAPPED)
+        return allocFileMappedAmpArray(arrSize);
+    
+# ifdef HUGE_PAGES_SUPPORTED
+    if (policy == MEMORY_EXPLICIT_HUGE_PAGES) {
+        size_t mapSize = getHugePageMapSize(arrSize);
+        arr = mmap(NULL, mapSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+        
+        // fall back to transparent huge pages when the reserved pool is exhausted
+        if (arr == MAP_FAILED) {
+            arr = mmap(NULL, mapSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+            if (arr != MAP_FAILED)
+                madvise(arr, mapSize, MADV_HUGEPAGE);
+        }
+        return (arr == MAP_FAILED)? NULL : (qreal*) arr;
+    }
+# endif
+    
+    if (posix_memalign(&arr, alignment, arrSize))
+        return NULL;
+    
+# ifdef HUGE_PAGES_SUPPORTED
+    if (policy == MEMORY_HUGE_PAGES)
+        madvise(arr, arrSize, MADV_HUGEPAGE);
+# endif
+    
+# endif
+    return (qreal*) arr;
+}
+
+static void freeAmpArray(qreal* arr, size_t arrSize, enum memoryPolicy policy) {
+    
+    policy = getAmpArrayPolicy(arrSize, policy);
+    
+# ifdef _WIN32
+    _aligned_free(arr);
+# else
+    
+    if (policy == MEMORY_FILE_MAPPED) {
+        munmap(arr, arrSize);
+        return;
+    }
+    
+# ifdef HUGE_PAGES_SUPPORTED
+    if (policy == MEMORY_EXPLICIT_HUGE_PAGES) {
+        munmap(arr, getHugePageMapSize(arrSize));
+        return;
+    }
+# endif
+    
+    free(arr);
+# endif
+}
+
+/** Zeroes the array with the same static schedule as the simulation kernels, so that
+ * each page is first touched, and hence placed on the NUMA node of, the thread which
+ * will later process it
+ */
+static void firstTouchAmpArray(qreal* arr, long long int numAmps) {
+    
+    long long int index;
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (arr, numAmps) \
+    private  (index) 
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<numAmps; index++)
+            arr[index] = 0;
+    }
+}
+
+void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env, enum memoryPolicy policy)
 {
     long long int numAmps = 1LL << numQubits;
     long long int numAmpsPerRank = numAmps/env.numRanks;
@@ -1287,24 +1475,32 @@ void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
     }
 
     size_t arrSize = (size_t) (numAmpsPerRank * sizeof(*(qureg->stateVec.real)));
-    qureg->stateVec.real = malloc(arrSize);
-    qureg->stateVec.imag = malloc(arrSize);
+    qureg->stateVec.real = allocAmpArray(arrSize, policy);
+    qureg->stateVec.imag = allocAmpArray(arrSize, policy);
     if (env.numRanks>1){
-        qureg->pairStateVec.real = malloc(arrSize);
-        qureg->pairStateVec.imag = malloc(arrSize);
+        qureg->pairStateVec.real = allocAmpArray(arrSize, policy);
+        qureg->pairStateVec.imag = allocAmpArray(arrSize, policy);
     }
 
     if ( (!(qureg->stateVec.real) || !(qureg->stateVec.imag))
             && numAmpsPerRank ) {
-        printf("Could not allocate memory!");
+        printf("%s", (policy == MEMORY_FILE_MAPPED)? "Could not map memory to a file (see QUEST_FILE_MAPPED_DIR)!" : "Could not allocate memory!");
         exit (EXIT_FAILURE);
     }
 
     if ( env.numRanks>1 && (!(qureg->pairStateVec.real) || !(qureg->pairStateVec.imag))
             && numAmpsPerRank ) {
-        printf("Could not allocate memory!");
+        printf("%s", (policy == MEMORY_FILE_MAPPED)? "Could not map memory to a file (see QUEST_FILE_MAPPED_DIR)!" : "Could not allocate memory!");
         exit (EXIT_FAILURE);
     }
+    
+    // stateVec is first touched by the caller's (parallel) initialisation, but pairStateVec 
+    // would otherwise be first written by a single thread receiving an MPI message. File-mapped
+    // pages have no NUMA placement worth the cost of writing the whole buffer to file
+    if (env.numRanks>1 && policy != MEMORY_FILE_MAPPED) {
+        firstTouchAmpArray(qureg->pairStateVec.real, numAmpsPerRank);
+        firstTouchAmpArray(qureg->pairStateVec.imag, numAmpsPerRank);
+    }
 
     qureg->numQubitsInStateVec = numQubits;
     qureg->numAmpsTotal = numAmps;
@@ -1312,19 +1508,22 @@ void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
     qureg->chunkId = env.rank;
     qureg->numChunks = env.numRanks;
     qureg->isDensityMatrix = 0;
+    qureg->memPolicy = policy;
 }
 
 void statevec_destroyQureg(Qureg qureg, QuESTEnv env){
+    
+    size_t arrSize = (size_t) (qureg.numAmpsPerChunk * sizeof(*(qureg.stateVec.real)));
 
     qureg.numQubitsInStateVec = 0;
     qureg.numAmpsTotal = 0;
     qureg.numAmpsPerChunk = 0;
 
-    free(qureg.stateVec.real);
-    free(qureg.stateVec.imag);
+    freeAmpArray(qureg.stateVec.real, arrSize, qureg.memPolicy);
+    freeAmpArray(qureg.stateVec.imag, arrSize, qureg.memPolicy);
     if (env.numRanks>1){
-        free(qureg.pairStateVec.real);
-        free(qureg.pairStateVec.imag);
+        freeAmpArray(qureg.pairStateVec.real, arrSize, qureg.memPolicy);
+        freeAmpArray(qureg.pairStateVec.imag, arrSize, qureg.memPolicy);
     }
     qureg.stateVec.real = NULL;
     qureg.stateVec.imag = NULL;
@@ -1621,141 +1820,325 @@ void statevec_initDebugState (Qureg qureg)
     }
 }
 
-// returns 1 if successful, else 0
-int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env){
-    long long int chunkSize, stateVecSize;
-    long long int indexInChunk, totalIndex;
+/* the number of bytes read at a time when counting the lines of a state file */
+# define STATE_FILE_BLOCK_SIZE (1<<20)
 
-    chunkSize = qureg->numAmpsPerChunk;
-    stateVecSize = chunkSize*qureg->numChunks;
+/* the maximum length of a line of a state file, beyond which the remainder of the line is ignored */
+# define STATE_FILE_LINE_SIZE 200
 
-    qreal *stateVecReal = qureg->stateVec.real;
-    qreal *stateVecImag = qureg->stateVec.imag;
+static int seekStateFile(FILE* file, long long int offset, int whence) {
+# ifdef _WIN32
+    return _fseeki64(file, offset, whence) == 0;
+# else
+    return fseeko(file, (off_t) offset, whence) == 0;
+# endif
+}
+
+static long long int tellStateFile(FILE* file) {
+# ifdef _WIN32
+    return _ftelli64(file);
+# else
+    return (long long int) ftello(file);
+# endif
+}
 
-    FILE *fp;
-    char line[200];
+/* a state file is divided into byte segments [seg*segSize, (seg+1)*segSize), clamped to the file */
+static void getStateFileSegmentBounds(
+    int seg, long long int segSize, long long int fileSize, long long int* segStart, long long int* segEnd
+) {
+    *segStart = (seg*segSize < fileSize)? seg*segSize : fileSize;
+    *segEnd = ((seg+1)*segSize < fileSize)? (seg+1)*segSize : fileSize;
+}
 
-    for (int rank=0; rank<(qureg->numChunks); rank++){
-        if (rank==qureg->chunkId){
-            fp = fopen(filename, "r");
-            
-            // indicate file open failure
-            if (fp == NULL)
-                return 0;
-            
-            indexInChunk = 0; totalIndex = 0;
-            while (fgets(line, sizeof(char)*200, fp) != NULL && totalIndex<stateVecSize){
-                if (line[0]!='#'){
-                    int chunkId = (int) (totalIndex/chunkSize);
-                    if (chunkId==qureg->chunkId){
-                        # if QuEST_PREC==1
-                        sscanf(line, "%f, %f", &(stateVecReal[indexInChunk]), 
-                                &(stateVecImag[indexInChunk])); 
-                        # elif QuEST_PREC==2                    
-                        sscanf(line, "%lf, %lf", &(stateVecReal[indexInChunk]), 
-                                &(stateVecImag[indexInChunk]));
-                        # elif QuEST_PREC==4
-                        sscanf(line, "%Lf, %Lf", &(stateVecReal[indexInChunk]), 
-                                &(stateVecImag[indexInChunk]));
-                        # endif
-                        indexInChunk += 1;
-                    }
-                    totalIndex += 1;
-                }
-            }   
-            fclose(fp);
+long long int statevec_getStateFileSizeLocal(char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL)
+        return -1;
+    long long int fileSize = seekStateFile(file, 0, SEEK_END)? tellStateFile(file) : -1;
+    fclose(file);
+    return fileSize;
+}
+
+/** Counts the amplitude lines (those not beginning with '#') which begin within bytes 
+ * [segStart, segEnd) of the file, and finds the offset of the first line (of any kind) 
+ * beginning there, or segEnd if there is none. Returns 1 if successful, else 0
+ */
+static int countStateFileSegmentLines(
+    FILE* file, char* block, long long int segStart, long long int segEnd, 
+    long long int* numAmpLines, long long int* firstLineStart
+) {
+    *numAmpLines = 0;
+    *firstLineStart = segEnd;
+    
+    // whether the byte at offset segStart begins a line
+    int prev = '\n';
+    if (segStart > 0) {
+        if (!seekStateFile(file, segStart - 1, SEEK_SET))
+            return 0;
+        prev = fgetc(file);
+    } else if (!seekStateFile(file, 0, SEEK_SET))
+        return 0;
+    
+    for (long long int blockStart=segStart; blockStart < segEnd; blockStart += STATE_FILE_BLOCK_SIZE) {
+        long long int blockLen = segEnd - blockStart;
+        if (blockLen > STATE_FILE_BLOCK_SIZE)
+            blockLen = STATE_FILE_BLOCK_SIZE;
+        if (fread(block, 1, (size_t) blockLen, file) != (size_t) blockLen)
+            return 0;
+        
+        for (long long int i=0; i < blockLen; i++) {
+            if (prev == '\n') {
+                if (*firstLineStart == segEnd)
+                    *firstLineStart = blockStart + i;
+                if (block[i] != '#')
+                    *numAmpLines += 1;
+            }
+            prev = block[i];
         }
-        syncQuESTEnv(env);
     }
-    
-    // indicate success
     return 1;
 }
 
-int statevec_compareStates(Qureg mq1, Qureg mq2, qreal precision){
-    qreal diff;
-    long long int chunkSize = mq1.numAmpsPerChunk;
+/** Parses the amplitude lines beginning within bytes [firstLineStart, segEnd) of the file, 
+ * the first of which has global index firstAmpInd, into the qureg amplitudes of global 
+ * indices [chunkStart, chunkEnd). Returns 1 if every such amplitude was parsed, else 0
+ */
+static int parseStateFileSegmentLines(
+    FILE* file, Qureg qureg, long long int firstLineStart, long long int segEnd, 
+    long long int firstAmpInd, long long int chunkStart, long long int chunkEnd
+) {
+    if (!seekStateFile(file, firstLineStart, SEEK_SET))
+        return 0;
     
-    for (long long int i=0; i<chunkSize; i++){
-        diff = absReal(mq1.stateVec.real[i] - mq2.stateVec.real[i]);
-        if (diff>precision) return 0;
-        diff = absReal(mq1.stateVec.imag[i] - mq2.stateVec.imag[i]);
-        if (diff>precision) return 0;
+    char line[STATE_FILE_LINE_SIZE];
+    long long int offset = firstLineStart;
+    long long int ampInd = firstAmpInd;
+    
+    while (offset < segEnd && ampInd < chunkEnd && fgets(line, sizeof line, file) != NULL) {
+        
+        // consume the remainder of an overlong line (or one containing a null byte), so that 
+        // it is counted once, as when counting lines
+        size_t lineLen = strlen(line);
+        int isLineEnded = (lineLen > 0 && line[lineLen-1] == '\n');
+        int c;
+        while (!isLineEnded && (c = fgetc(file)) != EOF)
+            isLineEnded = (c == '\n');
+        offset = tellStateFile(file);
+        if (offset < 0)
+            return 0;
+        
+        if (line[0] == '#')
+            continue;
+        
+        if (ampInd >= chunkStart) {
+            long long int localInd = ampInd - chunkStart;
+            int numParsed;
+            # if QuEST_PREC==1
+            numParsed = sscanf(line, "%f, %f", &(qureg.stateVec.real[localInd]), &(qureg.stateVec.imag[localInd]));
+            # elif QuEST_PREC==2
+            numParsed = sscanf(line, "%lf, %lf", &(qureg.stateVec.real[localInd]), &(qureg.stateVec.imag[localInd]));
+            # elif QuEST_PREC==4
+            numParsed = sscanf(line, "%Lf, %Lf", &(qureg.stateVec.real[localInd]), &(qureg.stateVec.imag[localInd]));
+            # endif
+            if (numParsed != 2)
+                return 0;
+        }
+        ampInd += 1;
     }
     return 1;
 }
 
-void statevec_compactUnitaryLocal (Qureg qureg, int targetQubit, Complex alpha, Complex beta)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;         
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;  
-    sizeBlock     = 2LL * sizeHalfBlock; 
-
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
+/* Loading a text file of one "real, imag" line per amplitude (ignoring lines beginning '#') 
+ * is split into two passes over a table of byte segments of the file. First, each segment's
+ * amplitude lines are counted (only by the node owning that segment, in parallel over threads), 
+ * then a prefix sum of the counts gives the global index of the first amplitude in every 
+ * segment, so that each node parses in parallel only the segments containing its own chunk. 
+ * Every byte is hence counted once, and parsed about once, however many nodes load the file.
+ */
 
+/** Counts the amplitude lines in segments [firstSeg, firstSeg + numSegs) of the file, into 
+ * numAmpLines and firstLineStarts (each of length numSegs). Returns 1 if successful, else 0
+ */
+int statevec_countStateFileLinesLocal(
+    char* filename, long long int fileSize, long long int segSize, int firstSeg, int numSegs,
+    long long int* numAmpLines, long long int* firstLineStarts
+) {
+    int success = 1;
+    int seg;
+    
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none) \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag, numTasks) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (filename, fileSize, segSize, firstSeg, numSegs, numAmpLines, firstLineStarts) \
+    private  (seg) \
+    reduction(&&:success)
 # endif
     {
+        // every thread reads through its own stream
+        FILE* segFile = fopen(filename, "rb");
+        char* block = (segFile != NULL)? malloc(STATE_FILE_BLOCK_SIZE) : NULL;
+        success = (block != NULL);
+        
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            // store current state vector values in temp variables
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
+        for (seg=0; seg < numSegs; seg++) {
+            long long int segStart, segEnd;
+            getStateFileSegmentBounds(firstSeg + seg, segSize, fileSize, &segStart, &segEnd);
+            
+            numAmpLines[seg] = 0;
+            firstLineStarts[seg] = segEnd;
+            if (success)
+                success = countStateFileSegmentLines(
+                    segFile, block, segStart, segEnd, &numAmpLines[seg], &firstLineStarts[seg]);
+        }
+        
+        free(block);
+        if (segFile != NULL)
+            fclose(segFile);
+    }
+    return success;
+}
 
-            stateRealLo = stateVecReal[indexLo];
-            stateImagLo = stateVecImag[indexLo];
+/** Parses the amplitudes of this node's chunk from the file, given the counted numAmpLines 
+ * and firstLineStarts of all numSegs segments. Returns 1 if the file has a parseable line 
+ * for every amplitude of the chunk, else 0
+ */
+int statevec_parseStateFileLinesLocal(
+    Qureg qureg, char* filename, long long int fileSize, long long int segSize, int numSegs,
+    long long int* numAmpLines, long long int* firstLineStarts
+) {
+    long long int chunkStart = qureg.chunkId * qureg.numAmpsPerChunk;
+    long long int chunkEnd = chunkStart + qureg.numAmpsPerChunk;
+    
+    // the global index of the first amplitude in every segment, and the segments overlapping the chunk
+    long long int* firstAmpInds = malloc(numSegs * sizeof *firstAmpInds);
+    validateMemoryAllocation(firstAmpInds != NULL, __func__);
+    long long int numPrevAmpLines = 0;
+    int firstOverlapSeg = numSegs;
+    int endOverlapSeg = 0;
+    for (int s=0; s < numSegs; s++) {
+        firstAmpInds[s] = numPrevAmpLines;
+        numPrevAmpLines += numAmpLines[s];
+        if (firstAmpInds[s] < chunkEnd && numPrevAmpLines > chunkStart) {
+            if (s < firstOverlapSeg)
+                firstOverlapSeg = s;
+            endOverlapSeg = s + 1;
+        }
+    }
+    
+    // the file must contain every amplitude of the chunk
+    if (numPrevAmpLines < chunkEnd) {
+        free(firstAmpInds);
+        return 0;
+    }
+    
+    int success = 1;
+    int seg;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (qureg, filename, fileSize, segSize, firstLineStarts, firstAmpInds, \
+              firstOverlapSeg, endOverlapSeg, chunkStart, chunkEnd) \
+    private  (seg) \
+    reduction(&&:success)
+# endif
+    {
+        // every thread reads through its own stream
+        FILE* segFile = fopen(filename, "rb");
+        success = (segFile != NULL);
+        
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (seg=firstOverlapSeg; seg < endOverlapSeg; seg++) {
+            long long int segStart, segEnd;
+            getStateFileSegmentBounds(seg, segSize, fileSize, &segStart, &segEnd);
+            
+            if (success)
+                success = parseStateFileSegmentLines(
+                    segFile, qureg, firstLineStarts[seg], segEnd, 
+                    firstAmpInds[seg], chunkStart, chunkEnd);
+        }
+        
+        if (segFile != NULL)
+            fclose(segFile);
+    }
+    
+    free(firstAmpInds);
+    return success;
+}
 
-            // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-            stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp 
-                - betaReal*stateRealLo - betaImag*stateImagLo;
-            stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp 
-                - betaReal*stateImagLo + betaImag*stateRealLo;
-
-            // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-            stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp 
-                + alphaReal*stateRealLo + alphaImag*stateImagLo;
-            stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp 
-                + alphaReal*stateImagLo - alphaImag*stateRealLo;
-        } 
+int statevec_compareStates(Qureg mq1, Qureg mq2, qreal precision){
+    qreal diff;
+    long long int chunkSize = mq1.numAmpsPerChunk;
+    
+    for (long long int i=0; i<chunkSize; i++){
+        diff = absReal(mq1.stateVec.real[i] - mq2.stateVec.real[i]);
+        if (diff>precision) return 0;
+        diff = absReal(mq1.stateVec.imag[i] - mq2.stateVec.imag[i]);
+        if (diff>precision) return 0;
     }
+    return 1;
+}
 
+void statevec_compactUnitaryLocal (Qureg qureg, int targetQubit, Complex alpha, Complex beta)
+{
+    // compactUnitary is the unitary [[alpha, -conj(beta)], [beta, conj(alpha)]]
+    ComplexMatrix2 u;
+    u.real[0][0] =  alpha.real; u.imag[0][0] =  alpha.imag;
+    u.real[0][1] = -beta.real;  u.imag[0][1] =  beta.imag;
+    u.real[1][0] =  beta.real;  u.imag[1][0] =  beta.imag;
+    u.real[1][1] =  alpha.real; u.imag[1][1] = -alpha.imag;
+
+    statevec_unitaryLocal(qureg, targetQubit, u);
 } 
 
+/** Prepares the enumeration of only the amplitudes (of this chunk) which satisfy the 
+ * controls, for a controlled kernel upon targets targs. The local controls and the targets 
+ * are written to fixedQubits in increasing order, and the value the local controls must take 
+ * (1, unless flipped by ctrlFlipMask) to ctrlValueMask. The index of task thisTask's 
+ * amplitude (with all targets 0) is then found by inserting a zero bit at each of the 
+ * fixedQubits, in order, and OR'ing ctrlValueMask. Controls upon qubits beyond this chunk 
+ * take the same value in every local amplitude, so are checked once here. Returns the 
+ * number of tasks, which is 2^(numCtrls) fewer than were every amplitude visited, or 
+ * 0 if no local amplitude satisfies the controls.
+ */
+static long long int getControlSubspace(
+    Qureg qureg, long long int ctrlMask, long long int ctrlFlipMask, int* targs, int numTargs,
+    int* fixedQubits, int* numFixed, long long int* ctrlValueMask)
+{
+    long long int localMask = qureg.numAmpsPerChunk - 1;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int globalCtrlMask = ctrlMask & ~localMask;
+    if (((globalIndStart ^ ctrlFlipMask) & globalCtrlMask) != globalCtrlMask)
+        return 0;
+    
+    long long int fixedMask = (ctrlMask & localMask) | getQubitBitMask(targs, numTargs);
+    *numFixed = 0;
+    for (int q=0; (fixedMask >> q) != 0; q++)
+        if (maskContainsBit(fixedMask, q))
+            fixedQubits[(*numFixed)++] = q;
+    
+    *ctrlValueMask = ctrlMask & ~ctrlFlipMask & localMask;
+    return qureg.numAmpsPerChunk >> *numFixed;
+}
+
 void statevec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int q1, int q2, ComplexMatrix4 u) {
 
     // can't use qureg.stateVec as a private OMP var
     qreal *reVec = qureg.stateVec.real;
     qreal *imVec = qureg.stateVec.imag;
     
-    // the global (between all nodes) index of this node's start index
-    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk; 
+    // each iteration updates 4 amplitudes, and only those satisfying the controls are visited
+    int fixedQubits[qureg.numQubitsInStateVec];
+    int numFixed, f;
+    long long int ctrlValueMask;
+    long long int numTasks = getControlSubspace(
+        qureg, ctrlMask, 0, (int[]) {q1, q2}, 2, fixedQubits, &numFixed, &ctrlValueMask);
     
-    long long int numTasks = qureg.numAmpsPerChunk >> 2; // each iteration updates 4 amplitudes
     long long int thisTask;
-    long long int thisGlobalInd00;
     long long int ind00, ind01, ind10, ind11;
     qreal re00, re01, re10, re11;
     qreal im00, im01, im10, im11;
@@ -1763,8 +2146,8 @@ void statevec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctr
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none) \
-    shared   (reVec,imVec,globalIndStart,numTasks,ctrlMask,u,q2,q1) \
-    private  (thisTask, thisGlobalInd00, ind00,ind01,ind10,ind11, re00,re01,re10,re11, im00,im01,im10,im11)
+    shared   (reVec,imVec,numTasks,fixedQubits,numFixed,ctrlValueMask,u,q2,q1) \
+    private  (thisTask, f, ind00,ind01,ind10,ind11, re00,re01,re10,re11, im00,im01,im10,im11)
 # endif
     {
 # ifdef _OPENMP
@@ -1772,13 +2155,11 @@ void statevec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctr
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
             
-            // determine ind00 of |..0..0..>
-            ind00 = insertTwoZeroBits(thisTask, q1, q2);
-            
-            // skip amplitude if controls aren't in 1 state (overloaded for speed)
-            thisGlobalInd00 = ind00 + globalIndStart;
-            if (ctrlMask && ((ctrlMask & thisGlobalInd00) != ctrlMask))
-                continue;
+            // determine ind00 of |..0..0..>, with the controls satisfied
+            ind00 = thisTask;
+            for (f=0; f < numFixed; f++)
+                ind00 = insertZeroBit(ind00, fixedQubits[f]);
+            ind00 |= ctrlValueMask;
             
             // inds of |..0..1..>, |..1..0..> and |..1..1..>
             ind01 = flipBit(ind00, q1);
@@ -1843,43 +2224,42 @@ int qsortComp(const void *a, const void *b) {
     return *(int*)a - *(int*)b; 
 }
 
-void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, int numTargs, ComplexMatrixN u)
+/** The generic multi-target kernel, used when numTargs exceeds MAX_NUM_SPECIALISED_TARGS,
+ * and for a single target (numTargs < 2), which has no specialised fixed-size path */
+static void statevec_multiControlledMultiQubitUnitaryLocalGeneric(Qureg qureg, long long int ctrlMask, int* targs, int numTargs, ComplexMatrixN u)
 {
     // can't use qureg.stateVec as a private OMP var
     qreal *reVec = qureg.stateVec.real;
     qreal *imVec = qureg.stateVec.imag;
     
-    long long int numTasks = qureg.numAmpsPerChunk >> numTargs;  // kernel called on every 1 in 2^numTargs amplitudes
     long long int numTargAmps = 1 << u.numQubits;  // num amps to be modified by each task
     
-    // the global (between all nodes) index of this node's start index
-    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk; 
+    // we need a sorted list of the targets (and controls) to find thisInd00 for each task.
+    // we can't modify targets, because the user-ordering of targets matters in u.
+    // only tasks satisfying the controls are enumerated
+    int fixedQubits[qureg.numQubitsInStateVec];
+    int numFixed, f;
+    long long int ctrlValueMask;
+    long long int numTasks = getControlSubspace(
+        qureg, ctrlMask, 0, targs, numTargs, fixedQubits, &numFixed, &ctrlValueMask);
     
     long long int thisTask;
     long long int thisInd00; // this thread's index of |..0..0..> (target qubits = 0) 
-    long long int thisGlobalInd00; // the global (between all nodes) index of this thread's |..0..0..> state
     long long int ind;   // each thread's iteration of amplitudes to modify
     int i, t, r, c;  // each thread's iteration of amps and targets 
-    qreal reElem, imElem;  // each thread's iteration of u elements
+    qaccum reElem, imElem;  // each thread's iteration of u elements
+    qaccum reSum, imSum;  // each thread's accumulation of a modified amp
     
     // each thread/task will record and modify numTargAmps amplitudes, privately
-    // (of course, tasks eliminated by the ctrlMask won't edit their allocation)
     long long int ampInds[numTargAmps];
-    qreal reAmps[numTargAmps];
-    qreal imAmps[numTargAmps];
-
-    // we need a sorted targets list to find thisInd00 for each task.
-    // we can't modify targets, because the user-ordering of targets matters in u
-    int sortedTargs[numTargs]; 
-    for (int t=0; t < numTargs; t++) 
-        sortedTargs[t] = targs[t];
-    qsort(sortedTargs, numTargs, sizeof(int), qsortComp);
+    qaccum reAmps[numTargAmps];
+    qaccum imAmps[numTargAmps];
     
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none) \
-    shared   (reVec,imVec, numTasks,numTargAmps,globalIndStart, ctrlMask,targs,sortedTargs,u,numTargs) \
-    private  (thisTask,thisInd00,thisGlobalInd00,ind,i,t,r,c,reElem,imElem,  ampInds,reAmps,imAmps)
+    shared   (reVec,imVec, numTasks,numTargAmps, fixedQubits,numFixed,ctrlValueMask, targs,u,numTargs) \
+    private  (thisTask,thisInd00,ind,i,t,f,r,c,reElem,imElem,reSum,imSum,  ampInds,reAmps,imAmps)
 # endif
     {
 # ifdef _OPENMP
@@ -1887,15 +2267,11 @@ void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int c
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
             
-            // find this task's start index (where all targs are 0)
+            // find this task's start index (where all targs are 0, and controls are satisfied)
             thisInd00 = thisTask;
-            for (t=0; t < numTargs; t++)
-                thisInd00 = insertZeroBit(thisInd00, sortedTargs[t]);
-                
-            // this task only modifies amplitudes if control qubits are 1 for this state
-            thisGlobalInd00 = thisInd00 + globalIndStart;
-            if (ctrlMask && ((ctrlMask & thisGlobalInd00) != ctrlMask))
-                continue;
+            for (f=0; f < numFixed; f++)
+                thisInd00 = insertZeroBit(thisInd00, fixedQubits[f]);
+            thisInd00 |= ctrlValueMask;
                 
             // determine the indices and record values of this tasks's target amps
             for (i=0; i < numTargAmps; i++) {
@@ -1914,77 +2290,616 @@ void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int c
             
             // modify this tasks's target amplitudes
             for (r=0; r < numTargAmps; r++) {
-                ind = ampInds[r];
-                reVec[ind] = 0;
-                imVec[ind] = 0;
+                reSum = 0;
+                imSum = 0;
                 
                 for (c=0; c < numTargAmps; c++) {
                     reElem = u.real[r][c];
                     imElem = u.imag[r][c];
-                    reVec[ind] += reAmps[c]*reElem - imAmps[c]*imElem;
-                    imVec[ind] += reAmps[c]*imElem + imAmps[c]*reElem;
+                    reSum += reAmps[c]*reElem - imAmps[c]*imElem;
+                    imSum += reAmps[c]*imElem + imAmps[c]*reElem;
                 }
+                ind = ampInds[r];
+                reVec[ind] = reSum;
+                imVec[ind] = imSum;
             }
         }
     }
 }
 
-void statevec_unitaryLocal(Qureg qureg, int targetQubit, ComplexMatrix2 u)
-{
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;         
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;  
-    sizeBlock     = 2LL * sizeHalfBlock; 
+/** The largest number of targets for which statevec_multiControlledMultiQubitUnitaryLocal 
+ * uses a kernel with a compile-time fixed matrix size */
+# define MAX_NUM_SPECIALISED_TARGS 6
 
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
+/** Applies the (dim x dim) matrix (uRe, uIm), flattened row-major, to the amplitudes 
+ * at indices thisInd00 + ampOffsets[i]. This is expanded with a literal dim, so that 
+ * the loops are fully unrolled, the amplitudes are held in locals, and each output 
+ * amplitude is accumulated privately before a single write to the state-vector.
+ */
+# define macro_applyFixedSizeMatrixToAmps(dim) { \
+    qaccum reAmps_[dim], imAmps_[dim]; \
+    qaccum reSum_, imSum_; \
+    for (int i_=0; i_ < (dim); i_++) { \
+        reAmps_[i_] = reVec[thisInd00 + ampOffsets[i_]]; \
+        imAmps_[i_] = imVec[thisInd00 + ampOffsets[i_]]; \
+    } \
+    for (int r_=0; r_ < (dim); r_++) { \
+        reSum_ = 0; \
+        imSum_ = 0; \
+        for (int c_=0; c_ < (dim); c_++) { \
+            reSum_ += reAmps_[c_]*uRe[r_*(dim) + c_] - imAmps_[c_]*uIm[r_*(dim) + c_]; \
+            imSum_ += reAmps_[c_]*uIm[r_*(dim) + c_] + imAmps_[c_]*uRe[r_*(dim) + c_]; \
+        } \
+        reVec[thisInd00 + ampOffsets[r_]] = reSum_; \
+        imVec[thisInd00 + ampOffsets[r_]] = imSum_; \
+    } \
+}
 
+void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, int numTargs, ComplexMatrixN u)
+{
+    if (numTargs > MAX_NUM_SPECIALISED_TARGS || numTargs < 2) {
+        statevec_multiControlledMultiQubitUnitaryLocalGeneric(qureg, ctrlMask, targs, numTargs, u);
+        return;
+    }
+    
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    
+    int numTargAmps = 1 << numTargs;  // num amps to be modified by each task
+    
+    // we need a sorted list of the targets (and controls) to find thisInd00 for each task.
+    // only tasks satisfying the controls are enumerated
+    int fixedQubits[qureg.numQubitsInStateVec];
+    int numFixed, f;
+    long long int ctrlValueMask;
+    long long int numTasks = getControlSubspace(
+        qureg, ctrlMask, 0, targs, numTargs, fixedQubits, &numFixed, &ctrlValueMask);
+    
+    long long int thisTask;
+    long long int thisInd00; // this thread's index of |..0..0..> (target qubits = 0) 
+    int t;
+    
+    // the offset of each target amplitude from thisInd00 is the same for every task, 
+    // so is computed once here rather than by flipping bits in every task
+    long long int ampOffsets[1 << MAX_NUM_SPECIALISED_TARGS];
+    for (int i=0; i < numTargAmps; i++) {
+        ampOffsets[i] = 0;
+        for (t=0; t < numTargs; t++)
+            if (extractBit(t, i))
+                ampOffsets[i] |= 1LL << targs[t];
+    }
+    
+    // a contiguous copy of u avoids the double indirection of u.real[r][c]
+    qreal uRe[1 << (2*MAX_NUM_SPECIALISED_TARGS)];
+    qreal uIm[1 << (2*MAX_NUM_SPECIALISED_TARGS)];
+    for (int r=0; r < numTargAmps; r++) {
+        for (int c=0; c < numTargAmps; c++) {
+            uRe[r*numTargAmps + c] = u.real[r][c];
+            uIm[r*numTargAmps + c] = u.imag[r][c];
+        }
+    }
+    
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none) \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u,numTasks) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (reVec,imVec, numTasks, fixedQubits,numFixed,ctrlValueMask,numTargs, ampOffsets,uRe,uIm) \
+    private  (thisTask,thisInd00,f)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
+            
+            // find this task's start index (where all targs are 0, and controls are satisfied)
+            thisInd00 = thisTask;
+            for (f=0; f < numFixed; f++)
+                thisInd00 = insertZeroBit(thisInd00, fixedQubits[f]);
+            thisInd00 |= ctrlValueMask;
+            
+            switch (numTargs) {
+                case 2: macro_applyFixedSizeMatrixToAmps(4);  break;
+                case 3: macro_applyFixedSizeMatrixToAmps(8);  break;
+                case 4: macro_applyFixedSizeMatrixToAmps(16); break;
+                case 5: macro_applyFixedSizeMatrixToAmps(32); break;
+                case 6: macro_applyFixedSizeMatrixToAmps(64); break;
+            }
+        }
+    }
+}
 
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
+/** Finds the layout of the blocks of density matrix elements which differ only in the row and
+ * column bits of the targets, as visited by the densmatr_applyMultiQubit*Local kernels. Element i 
+ * of a block has its target row bits given by the lower numTargets bits of i, and its target column 
+ * bits by the upper. The sorted local row and column qubits (which are zero in a block's first 
+ * element) are written to blockQubits, and each element's offset from the block's first to ampOffsets.
+ * At most one of the row and column qubits, pairQubit, may be non-local (else pairQubit is -1), and
+ * ampInPair records whether each element lies in the chunk differing from this one in that bit.
+ */
+static void getDensityMatrixBlocks(Qureg qureg, int* targets, int numTargets, int pairQubit,
+    int* blockQubits, int* numBlockQubits, long long int* ampOffsets, int* ampInPair)
+{
+    int numQb = qureg.numQubitsRepresented;
+    long long int numAmps = qureg.numAmpsPerChunk;
+    long long int numBlockAmps = 1LL << (2*numTargets);
+    
+    *numBlockQubits = 0;
+    for (int t=0; t < numTargets; t++) {
+        if (targets[t] != pairQubit)
+            blockQubits[(*numBlockQubits)++] = targets[t];
+        if (targets[t] + numQb != pairQubit)
+            blockQubits[(*numBlockQubits)++] = targets[t] + numQb;
+    }
+    qsort(blockQubits, *numBlockQubits, sizeof(int), qsortComp);
+
+    long long int globalIndStart = qureg.chunkId*numAmps;
+    int pairBit = (pairQubit == -1)? 0 : ! extractBit(pairQubit, globalIndStart);
+    for (long long int i=0; i < numBlockAmps; i++) {
+        long long int offset = 0;
+        for (int t=0; t < numTargets; t++) {
+            offset |= (long long int) extractBit(t, i) << targets[t];
+            offset |= (long long int) extractBit(t + numTargets, i) << (targets[t] + numQb);
+        }
+        ampInPair[i] = (pairQubit != -1) && (extractBit(pairQubit, offset) == pairBit);
+        ampOffsets[i] = offset & (numAmps - 1);
+    }
+}
 
-            // store current state vector values in temp variables
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
+/** Applies the Kraus map with superoperator superOp (as populated by populateKrausSuperOperatorN)
+ * to each block of density matrix elements which differ only in the row and column bits of the
+ * targets (see getDensityMatrixBlocks). At most one of these row and column qubits, pairQubit,
+ * may be non-local, in which case pairStateVec holds the amplitudes of the chunk which differs
+ * from this one in that bit, and only this chunk's elements are updated. Otherwise pairQubit is -1,
+ * and the map is effected with no communication nor swapping of qubits.
+ */
+void densmatr_applyMultiQubitKrausSuperoperatorLocal(Qureg qureg, int* targets, int numTargets, ComplexMatrixN superOp,
+    int pairQubit, ComplexArray pairStateVec)
+{
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    qreal *rePairVec = pairStateVec.real;
+    qreal *imPairVec = pairStateVec.imag;
 
-            stateRealLo = stateVecReal[indexLo];
-            stateImagLo = stateVecImag[indexLo];
+    long long int numBlockAmps = 1LL << (2*numTargets);
+    int blockQubits[2*numTargets];
+    int numBlockQubits;
+    long long int ampOffsets[numBlockAmps];
+    int ampInPair[numBlockAmps];
+    getDensityMatrixBlocks(qureg, targets, numTargets, pairQubit, blockQubits, &numBlockQubits, ampOffsets, ampInPair);
 
+    long long int numTasks = qureg.numAmpsPerChunk >> numBlockQubits;
+    long long int thisTask, thisInd00, ind;
+    long long int r, c;
+    int q;
+    qaccum reSum, imSum, reElem, imElem;
 
-            // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
-            stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp 
-                + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
-            stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp 
-                + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
+    // each thread/task will record the block elements privately
+    qaccum reAmps[numBlockAmps];
+    qaccum imAmps[numBlockAmps];
 
-            // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
-            stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp 
-                + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
-            stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp 
-                + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (reVec,imVec, rePairVec,imPairVec, numTasks,numBlockAmps, blockQubits,numBlockQubits, \
+              ampOffsets,ampInPair, superOp) \
+    private  (thisTask,thisInd00,ind,r,c,q, reSum,imSum,reElem,imElem, reAmps,imAmps)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
 
-        } 
+            // find this task's first block element (where all local target row and column bits are 0)
+            thisInd00 = thisTask;
+            for (q=0; q < numBlockQubits; q++)
+                thisInd00 = insertZeroBit(thisInd00, blockQubits[q]);
+
+            for (c=0; c < numBlockAmps; c++) {
+                ind = thisInd00 + ampOffsets[c];
+                reAmps[c] = (ampInPair[c])? rePairVec[ind] : reVec[ind];
+                imAmps[c] = (ampInPair[c])? imPairVec[ind] : imVec[ind];
+            }
+
+            // only this chunk's elements are updated
+            for (r=0; r < numBlockAmps; r++) {
+                if (ampInPair[r])
+                    continue;
+
+                reSum = 0;
+                imSum = 0;
+                for (c=0; c < numBlockAmps; c++) {
+                    reElem = superOp.real[r][c];
+                    imElem = superOp.imag[r][c];
+                    reSum += reAmps[c]*reElem - imAmps[c]*imElem;
+                    imSum += reAmps[c]*imElem + imAmps[c]*reElem;
+                }
+                ind = thisInd00 + ampOffsets[r];
+                reVec[ind] = reSum;
+                imVec[ind] = imSum;
+            }
+        }
+    }
+}
+
+/** Effects U rho U^dagger upon each block of density matrix elements which differ only in the row
+ * and column bits of the targets (see getDensityMatrixBlocks), in a single pass. Each block B is 
+ * updated as U B U^dagger, which costs as many flops as applying U to the row qubits and U^* to 
+ * the column qubits in two passes. pairQubit and pairStateVec are as in 
+ * densmatr_applyMultiQubitKrausSuperoperatorLocal.
+ */
+void densmatr_applyMultiQubitUnitaryLocal(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u,
+    int pairQubit, ComplexArray pairStateVec)
+{
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    qreal *rePairVec = pairStateVec.real;
+    qreal *imPairVec = pairStateVec.imag;
+
+    long long int numBlockAmps = 1LL << (2*numTargets);
+    int blockQubits[2*numTargets];
+    int numBlockQubits;
+    long long int ampOffsets[numBlockAmps];
+    int ampInPair[numBlockAmps];
+    getDensityMatrixBlocks(qureg, targets, numTargets, pairQubit, blockQubits, &numBlockQubits, ampOffsets, ampInPair);
+
+    // a contiguous copy of u avoids the double indirection of u.real[r][c]
+    int dim = 1 << numTargets;
+    qreal uRe[numBlockAmps];
+    qreal uIm[numBlockAmps];
+    for (int r=0; r < dim; r++) {
+        for (int c=0; c < dim; c++) {
+            uRe[r*dim + c] = u.real[r][c];
+            uIm[r*dim + c] = u.imag[r][c];
+        }
     }
+
+    long long int numTasks = qureg.numAmpsPerChunk >> numBlockQubits;
+    long long int thisTask, thisInd00, ind;
+    int q, i, r, c, k;
+    qaccum reSum, imSum;
+
+    // each thread/task will record the block B, and U B, privately
+    qaccum reAmps[numBlockAmps], imAmps[numBlockAmps];
+    qaccum reProd[numBlockAmps], imProd[numBlockAmps];
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (reVec,imVec, rePairVec,imPairVec, numTasks,numBlockAmps,dim, blockQubits,numBlockQubits, \
+              ampOffsets,ampInPair, uRe,uIm) \
+    private  (thisTask,thisInd00,ind,q,i,r,c,k, reSum,imSum, reAmps,imAmps,reProd,imProd)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+
+            // find this task's first block element (where all local target row and column bits are 0)
+            thisInd00 = thisTask;
+            for (q=0; q < numBlockQubits; q++)
+                thisInd00 = insertZeroBit(thisInd00, blockQubits[q]);
+
+            // B[r][c] is element r + c*dim of the block
+            for (i=0; i < numBlockAmps; i++) {
+                ind = thisInd00 + ampOffsets[i];
+                reAmps[i] = (ampInPair[i])? rePairVec[ind] : reVec[ind];
+                imAmps[i] = (ampInPair[i])? imPairVec[ind] : imVec[ind];
+            }
+
+            // (U B)[r][c] = sum_k U[r][k] B[k][c]
+            for (c=0; c < dim; c++) {
+                for (r=0; r < dim; r++) {
+                    reSum = 0;
+                    imSum = 0;
+                    for (k=0; k < dim; k++) {
+                        reSum += uRe[r*dim + k]*reAmps[k + c*dim] - uIm[r*dim + k]*imAmps[k + c*dim];
+                        imSum += uRe[r*dim + k]*imAmps[k + c*dim] + uIm[r*dim + k]*reAmps[k + c*dim];
+                    }
+                    reProd[r + c*dim] = reSum;
+                    imProd[r + c*dim] = imSum;
+                }
+            }
+
+            // (U B U^dagger)[r][c] = sum_k (U B)[r][k] conj(U[c][k]), written only to this chunk
+            for (c=0; c < dim; c++) {
+                for (r=0; r < dim; r++) {
+                    if (ampInPair[r + c*dim])
+                        continue;
+
+                    reSum = 0;
+                    imSum = 0;
+                    for (k=0; k < dim; k++) {
+                        reSum += reProd[r + k*dim]*uRe[c*dim + k] + imProd[r + k*dim]*uIm[c*dim + k];
+                        imSum += imProd[r + k*dim]*uRe[c*dim + k] - reProd[r + k*dim]*uIm[c*dim + k];
+                    }
+                    ind = thisInd00 + ampOffsets[r + c*dim];
+                    reVec[ind] = reSum;
+                    imVec[ind] = imSum;
+                }
+            }
+        }
+    }
+}
+
+/** Applies each of the numUnitaries unitaries us (the i-th upon the us[i].numQubits 
+ * qubits listed consecutively in targs) in turn, to each contiguous block of 
+ * 2^numBlockQubits amplitudes in turn. Every target must be below numBlockQubits, 
+ * so that a block is closed under every unitary. A block is visited by a single 
+ * thread and remains cache-resident while the whole sequence is applied to it, 
+ * so the state-vector is streamed from memory once, rather than once per unitary.
+ */
+void statevec_multiQubitUnitarySequenceLocal(Qureg qureg, int numBlockQubits, ComplexMatrixN* us, int* targs, int numUnitaries)
+{
+    // can't use qureg.stateVec as a private OMP var
+    qreal *reVec = qureg.stateVec.real;
+    qreal *imVec = qureg.stateVec.imag;
+    
+    long long int numBlocks = qureg.numAmpsPerChunk >> numBlockQubits;
+    long long int blockSize = 1LL << numBlockQubits;
+    
+    // the start of each unitary's targets, amplitude offsets and elements in the flat arrays below
+    int targStarts[numUnitaries];
+    long long int ampStarts[numUnitaries];
+    long long int elemStarts[numUnitaries];
+    int numAllTargs = 0;
+    long long int numAllAmps = 0;
+    long long int numAllElems = 0;
+    for (int n=0; n < numUnitaries; n++) {
+        long long int numTargAmps = 1LL << us[n].numQubits;
+        targStarts[n] = numAllTargs;
+        ampStarts[n] = numAllAmps;
+        elemStarts[n] = numAllElems;
+        numAllTargs += us[n].numQubits;
+        numAllAmps += numTargAmps;
+        numAllElems += numTargAmps * numTargAmps;
+    }
+    
+    // as in statevec_multiControlledMultiQubitUnitaryLocal, the sorted targets, the 
+    // offsets of the target amplitudes from |..0..0..> and contiguous copies of each 
+    // unitary are prepared once, rather than by every task of every block
+    int sortedTargs[numAllTargs];
+    long long int *allAmpOffsets = malloc(numAllAmps * sizeof *allAmpOffsets);
+    qreal *allRe = malloc(numAllElems * sizeof *allRe);
+    qreal *allIm = malloc(numAllElems * sizeof *allIm);
+    validateMemoryAllocation(allAmpOffsets && allRe && allIm, __func__);
+    
+    // matrices too large for the fixed-size kernels gather their amplitudes into 
+    // per-thread heap scratch, sized by the largest such matrix in the sequence
+    long long int maxNumTargAmps = 0;
+    for (int n=0; n < numUnitaries; n++)
+        if (us[n].numQubits > MAX_NUM_SPECIALISED_TARGS && (1LL << us[n].numQubits) > maxNumTargAmps)
+            maxNumTargAmps = 1LL << us[n].numQubits;
+    int numThreads = 1;
+# ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+# endif
+    qaccum *allScratch = NULL;
+    if (maxNumTargAmps > 0) {
+        allScratch = malloc(2 * numThreads * maxNumTargAmps * sizeof *allScratch);
+        validateMemoryAllocation(allScratch != NULL, __func__);
+    }
+    
+    for (int n=0; n < numUnitaries; n++) {
+        int numTargs = us[n].numQubits;
+        long long int numTargAmps = 1LL << numTargs;
+        
+        for (int t=0; t < numTargs; t++)
+            sortedTargs[targStarts[n] + t] = targs[targStarts[n] + t];
+        qsort(&sortedTargs[targStarts[n]], numTargs, sizeof(int), qsortComp);
+        
+        for (long long int i=0; i < numTargAmps; i++) {
+            allAmpOffsets[ampStarts[n] + i] = 0;
+            for (int t=0; t < numTargs; t++)
+                if (extractBit(t, i))
+                    allAmpOffsets[ampStarts[n] + i] |= 1LL << targs[targStarts[n] + t];
+        }
+        for (long long int r=0; r < numTargAmps; r++) {
+            for (long long int c=0; c < numTargAmps; c++) {
+                allRe[elemStarts[n] + r*numTargAmps + c] = us[n].real[r][c];
+                allIm[elemStarts[n] + r*numTargAmps + c] = us[n].imag[r][c];
+            }
+        }
+    }
+    
+    long long int thisBlock, blockStart, thisTask, numTasks, thisInd00, numTargAmps, r, c;
+    long long int *ampOffsets;
+    qreal *uRe, *uIm;
+    qaccum reAmp, imAmp, reSum, imSum;
+    qaccum *reAmps, *imAmps;
+    int n, t, numTargs;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (reVec,imVec, numBlocks,blockSize,numBlockQubits, us,numUnitaries, \
+              targStarts,ampStarts,elemStarts, sortedTargs,allAmpOffsets,allRe,allIm, \
+              allScratch,maxNumTargAmps) \
+    private  (thisBlock,blockStart,thisTask,numTasks,thisInd00,numTargAmps,r,c, \
+              ampOffsets,uRe,uIm, reAmp,imAmp,reSum,imSum, reAmps,imAmps, n,t,numTargs)
+# endif
+    {
+        reAmps = NULL;
+        imAmps = NULL;
+        if (allScratch != NULL) {
+            int thread = 0;
+# ifdef _OPENMP
+            thread = omp_get_thread_num();
+# endif
+            reAmps = &allScratch[2 * thread * maxNumTargAmps];
+            imAmps = &reAmps[maxNumTargAmps];
+        }
+        
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisBlock=0; thisBlock<numBlocks; thisBlock++) {
+            blockStart = thisBlock << numBlockQubits;
+            
+            // apply the whole sequence to this block before moving to the next
+            for (n=0; n < numUnitaries; n++) {
+                numTargs = us[n].numQubits;
+                numTargAmps = 1LL << numTargs;
+                numTasks = blockSize >> numTargs;
+                ampOffsets = &allAmpOffsets[ampStarts[n]];
+                uRe = &allRe[elemStarts[n]];
+                uIm = &allIm[elemStarts[n]];
+                
+                for (thisTask=0; thisTask<numTasks; thisTask++) {
+                    
+                    // find this task's start index (where all targs are 0)
+                    thisInd00 = thisTask;
+                    for (t=0; t < numTargs; t++)
+                        thisInd00 = insertZeroBit(thisInd00, sortedTargs[targStarts[n] + t]);
+                    thisInd00 += blockStart;
+                    
+                    switch (numTargs) {
+                        case 1: {
+                            // the 2x2 case needs no private amplitude arrays
+                            reAmp = reVec[thisInd00];
+                            imAmp = imVec[thisInd00];
+                            reSum = reVec[thisInd00 + ampOffsets[1]];
+                            imSum = imVec[thisInd00 + ampOffsets[1]];
+                            reVec[thisInd00] = uRe[0]*reAmp - uIm[0]*imAmp + uRe[1]*reSum - uIm[1]*imSum;
+                            imVec[thisInd00] = uRe[0]*imAmp + uIm[0]*reAmp + uRe[1]*imSum + uIm[1]*reSum;
+                            reVec[thisInd00 + ampOffsets[1]] = uRe[2]*reAmp - uIm[2]*imAmp + uRe[3]*reSum - uIm[3]*imSum;
+                            imVec[thisInd00 + ampOffsets[1]] = uRe[2]*imAmp + uIm[2]*reAmp + uRe[3]*imSum + uIm[3]*reSum;
+                            break;
+                        }
+                        case 2: macro_applyFixedSizeMatrixToAmps(4);  break;
+                        case 3: macro_applyFixedSizeMatrixToAmps(8);  break;
+                        case 4: macro_applyFixedSizeMatrixToAmps(16); break;
+                        case 5: macro_applyFixedSizeMatrixToAmps(32); break;
+                        case 6: macro_applyFixedSizeMatrixToAmps(64); break;
+                        default: {
+                            // larger matrices are rare enough to use the per-thread heap scratch
+                            for (r=0; r < numTargAmps; r++) {
+                                reAmps[r] = reVec[thisInd00 + ampOffsets[r]];
+                                imAmps[r] = imVec[thisInd00 + ampOffsets[r]];
+                            }
+                            for (r=0; r < numTargAmps; r++) {
+                                reSum = 0;
+                                imSum = 0;
+                                for (c=0; c < numTargAmps; c++) {
+                                    reSum += reAmps[c]*uRe[r*numTargAmps + c] - imAmps[c]*uIm[r*numTargAmps + c];
+                                    imSum += reAmps[c]*uIm[r*numTargAmps + c] + imAmps[c]*uRe[r*numTargAmps + c];
+                                }
+                                reVec[thisInd00 + ampOffsets[r]] = reSum;
+                                imVec[thisInd00 + ampOffsets[r]] = imSum;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    free(allAmpOffsets);
+    free(allRe);
+    free(allIm);
+    free(allScratch);
+}
+
+# define LOW_TARGET_HALF_BLOCK 8
+
+/** The 2x2 kernel shared by all local single-qubit unitaries. Amplitude pairs are 
+ * enumerated without any per-amplitude division or modulo, using one of two loop 
+ * structures:
+ *  - for low targets (sizeHalfBlock < LOW_TARGET_HALF_BLOCK), the pairs of adjacent 
+ *    blocks share cache lines, so we iterate pairs directly, computing indexUp by 
+ *    inserting a zero bit. For targetQubit=0 this reduces to indexUp = 2*thisTask.
+ *  - for higher targets, we iterate blocks and then the contiguous half-block within,
+ *    so that the inner loop is unit-stride and auto-vectorisable. The OpenMP loop is 
+ *    placed on whichever of the two nested loops is longer, so that the highest 
+ *    targets (with few blocks) are still parallelised.
+ */
+void statevec_unitaryLocal(Qureg qureg, int targetQubit, ComplexMatrix2 u)
+{
+    long long int sizeBlock, sizeHalfBlock, numBlocks;
+    long long int thisBlock, thisOffset, // current block, and current index within its upper half
+         indexUp,indexLo;    // current index and corresponding index in lower half block
+
+    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
+    long long int thisTask;         
+    long long int numTasks=qureg.numAmpsPerChunk>>1;
+
+    // set dimensions
+    sizeHalfBlock = 1LL << targetQubit;  
+    sizeBlock     = 2LL * sizeHalfBlock; 
+    numBlocks     = numTasks / sizeHalfBlock;
+
+    // Can't use qureg.stateVec as a private OMP var
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+
+    // unpack the matrix into scalars so they're held in registers
+    qreal u00Re=u.real[0][0], u00Im=u.imag[0][0], u01Re=u.real[0][1], u01Im=u.imag[0][1];
+    qreal u10Re=u.real[1][0], u10Im=u.imag[1][0], u11Re=u.real[1][1], u11Im=u.imag[1][1];
+
+    int isLowTarget = (sizeHalfBlock < LOW_TARGET_HALF_BLOCK);
+    int isParallelOverBlocks = (numBlocks >= sizeHalfBlock);
+
+// state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
+// state[indexLo] = u10 * state[indexUp] + u11 * state[indexLo]
+# define macro_applyUnitaryToAmpPair \
+    stateRealUp = stateVecReal[indexUp]; \
+    stateImagUp = stateVecImag[indexUp]; \
+    stateRealLo = stateVecReal[indexLo]; \
+    stateImagLo = stateVecImag[indexLo]; \
+    stateVecReal[indexUp] = u00Re*stateRealUp - u00Im*stateImagUp + u01Re*stateRealLo - u01Im*stateImagLo; \
+    stateVecImag[indexUp] = u00Re*stateImagUp + u00Im*stateRealUp + u01Re*stateImagLo + u01Im*stateRealLo; \
+    stateVecReal[indexLo] = u10Re*stateRealUp - u10Im*stateImagUp + u11Re*stateRealLo - u11Im*stateImagLo; \
+    stateVecImag[indexLo] = u10Re*stateImagUp + u10Im*stateRealUp + u11Re*stateImagLo + u11Im*stateRealLo;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (sizeBlock,sizeHalfBlock,numBlocks, stateVecReal,stateVecImag, numTasks,targetQubit, \
+              isLowTarget,isParallelOverBlocks, u00Re,u00Im,u01Re,u01Im,u10Re,u10Im,u11Re,u11Im) \
+    private  (thisTask,thisBlock,thisOffset ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+# endif
+    {
+        if (isLowTarget) {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+            for (thisTask=0; thisTask<numTasks; thisTask++) {
+                indexUp = insertZeroBit(thisTask, targetQubit);
+                indexLo = indexUp + sizeHalfBlock;
+                macro_applyUnitaryToAmpPair
+            }
+        }
+        else if (isParallelOverBlocks) {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+            for (thisBlock=0; thisBlock<numBlocks; thisBlock++) {
+                for (thisOffset=0; thisOffset<sizeHalfBlock; thisOffset++) {
+                    indexUp = thisBlock*sizeBlock + thisOffset;
+                    indexLo = indexUp + sizeHalfBlock;
+                    macro_applyUnitaryToAmpPair
+                }
+            }
+        }
+        else {
+            for (thisBlock=0; thisBlock<numBlocks; thisBlock++) {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+                for (thisOffset=0; thisOffset<sizeHalfBlock; thisOffset++) {
+                    indexUp = thisBlock*sizeBlock + thisOffset;
+                    indexLo = indexUp + sizeHalfBlock;
+                    macro_applyUnitaryToAmpPair
+                }
+            }
+        }
+    }
+
+# undef macro_applyUnitaryToAmpPair
 } 
 
 /** Rotate a single qubit in the state vector of probability amplitudes, 
@@ -2101,93 +3016,38 @@ void statevec_unitaryDistributed (Qureg qureg,
 void statevec_controlledCompactUnitaryLocal (Qureg qureg, int controlQubit, int targetQubit, 
         Complex alpha, Complex beta)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;         
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-    long long int chunkSize=qureg.numAmpsPerChunk;
-    long long int chunkId=qureg.chunkId;
-
-    int controlBit;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;  
-    sizeBlock     = 2LL * sizeHalfBlock; 
-
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-    qreal alphaImag=alpha.imag, alphaReal=alpha.real;
-    qreal betaImag=beta.imag, betaReal=beta.real;
-
-# ifdef _OPENMP
-# pragma omp parallel \
-    default  (none) \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, alphaReal,alphaImag, betaReal,betaImag, \
-                numTasks,chunkId,chunkSize,controlQubit) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
-# endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-            if (controlBit){
-                // store current state vector values in temp variables
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
-
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
-
-                // state[indexUp] = alpha * state[indexUp] - conj(beta)  * state[indexLo]
-                stateVecReal[indexUp] = alphaReal*stateRealUp - alphaImag*stateImagUp 
-                    - betaReal*stateRealLo - betaImag*stateImagLo;
-                stateVecImag[indexUp] = alphaReal*stateImagUp + alphaImag*stateRealUp 
-                    - betaReal*stateImagLo + betaImag*stateRealLo;
-
-                // state[indexLo] = beta  * state[indexUp] + conj(alpha) * state[indexLo]
-                stateVecReal[indexLo] = betaReal*stateRealUp - betaImag*stateImagUp 
-                    + alphaReal*stateRealLo + alphaImag*stateImagLo;
-                stateVecImag[indexLo] = betaReal*stateImagUp + betaImag*stateRealUp 
-                    + alphaReal*stateImagLo - alphaImag*stateRealLo;
-            }
-        } 
-    }
-
+    // compactUnitary is the unitary [[alpha, -conj(beta)], [beta, conj(alpha)]]
+    ComplexMatrix2 u;
+    u.real[0][0] =  alpha.real; u.imag[0][0] =  alpha.imag;
+    u.real[0][1] = -beta.real;  u.imag[0][1] =  beta.imag;
+    u.real[1][0] =  beta.real;  u.imag[1][0] =  beta.imag;
+    u.real[1][1] =  alpha.real; u.imag[1][1] = -alpha.imag;
+
+    statevec_multiControlledUnitaryLocal(qureg, targetQubit, 1LL << controlQubit, 0, u);
 } 
 
 /* ctrlQubitsMask is a bit mask indicating which qubits are control Qubits
  * ctrlFlipMask is a bit mask indicating which control qubits should be 'flipped'
- * in the condition, i.e. they should have value 0 when the unitary is applied
+ * in the condition, i.e. they should have value 0 when the unitary is applied.
+ * Only the amplitude pairs satisfying the controls are enumerated.
  */
 void statevec_multiControlledUnitaryLocal(
     Qureg qureg, int targetQubit, 
     long long int ctrlQubitsMask, long long int ctrlFlipMask,
     ComplexMatrix2 u)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
+    long long int indexUp,indexLo;    // current index and corresponding index in lower half block
 
     qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;         
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-    long long int chunkSize=qureg.numAmpsPerChunk;
-    long long int chunkId=qureg.chunkId;
+    long long int thisTask;
+    
+    int fixedQubits[qureg.numQubitsInStateVec];
+    int numFixed, f;
+    long long int ctrlValueMask;
+    long long int numTasks = getControlSubspace(
+        qureg, ctrlQubitsMask, ctrlFlipMask, &targetQubit, 1, fixedQubits, &numFixed, &ctrlValueMask);
 
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;  
-    sizeBlock     = 2LL * sizeHalfBlock; 
+    long long int sizeHalfBlock = 1LL << targetQubit;  
 
     // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
@@ -2196,9 +3056,8 @@ void statevec_multiControlledUnitaryLocal(
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none) \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u, ctrlQubitsMask,ctrlFlipMask, \
-                numTasks,chunkId,chunkSize) \
-    private  (thisTask,thisBlock, indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
+    shared   (sizeHalfBlock, stateVecReal,stateVecImag, u, fixedQubits,numFixed,ctrlValueMask, numTasks) \
+    private  (thisTask,f, indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo)
 # endif
     {
 # ifdef _OPENMP
@@ -2206,33 +3065,31 @@ void statevec_multiControlledUnitaryLocal(
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
 
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-            
+            // the index with target 0 and the controls in their desired values
+            indexUp = thisTask;
+            for (f=0; f < numFixed; f++)
+                indexUp = insertZeroBit(indexUp, fixedQubits[f]);
+            indexUp |= ctrlValueMask;
+            indexLo = indexUp + sizeHalfBlock;
             
-            // take the basis index, flip the designated (XOR) 'control' bits, AND with the controls.
-            // if this equals the control mask, the control qubits have the desired values in the basis index
-            if (ctrlQubitsMask == (ctrlQubitsMask & ((indexUp+chunkId*chunkSize) ^ ctrlFlipMask))) {
-                // store current state vector values in temp variables
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
+            // store current state vector values in temp variables
+            stateRealUp = stateVecReal[indexUp];
+            stateImagUp = stateVecImag[indexUp];
 
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
+            stateRealLo = stateVecReal[indexLo];
+            stateImagLo = stateVecImag[indexLo];
 
-                // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
-                stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp 
-                    + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
-                stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp 
-                    + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
+            // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
+            stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp 
+                + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
+            stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp 
+                + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
 
-                // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
-                stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp 
-                    + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
-                stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp 
-                    + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
-            }
+            // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
+            stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp 
+                + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
+            stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp 
+                + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
         } 
     }
 
@@ -2241,67 +3098,7 @@ void statevec_multiControlledUnitaryLocal(
 void statevec_controlledUnitaryLocal(Qureg qureg, int controlQubit, int targetQubit, 
         ComplexMatrix2 u)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateRealLo,stateImagUp,stateImagLo;
-    long long int thisTask;         
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-    long long int chunkSize=qureg.numAmpsPerChunk;
-    long long int chunkId=qureg.chunkId;
-
-    int controlBit;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;  
-    sizeBlock     = 2LL * sizeHalfBlock; 
-
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-# ifdef _OPENMP
-# pragma omp parallel \
-    default  (none) \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, u,numTasks,chunkId,chunkSize,controlQubit) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,stateRealLo,stateImagLo,controlBit)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
-# endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            controlBit = extractBit (controlQubit, indexUp+chunkId*chunkSize);
-            if (controlBit){
-                // store current state vector values in temp variables
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
-
-                stateRealLo = stateVecReal[indexLo];
-                stateImagLo = stateVecImag[indexLo];
-
-
-                // state[indexUp] = u00 * state[indexUp] + u01 * state[indexLo]
-                stateVecReal[indexUp] = u.real[0][0]*stateRealUp - u.imag[0][0]*stateImagUp 
-                    + u.real[0][1]*stateRealLo - u.imag[0][1]*stateImagLo;
-                stateVecImag[indexUp] = u.real[0][0]*stateImagUp + u.imag[0][0]*stateRealUp 
-                    + u.real[0][1]*stateImagLo + u.imag[0][1]*stateRealLo;
-
-                // state[indexLo] = u10  * state[indexUp] + u11 * state[indexLo]
-                stateVecReal[indexLo] = u.real[1][0]*stateRealUp  - u.imag[1][0]*stateImagUp 
-                    + u.real[1][1]*stateRealLo  -  u.imag[1][1]*stateImagLo;
-                stateVecImag[indexLo] = u.real[1][0]*stateImagUp + u.imag[1][0]*stateRealUp 
-                    + u.real[1][1]*stateImagLo + u.imag[1][1]*stateRealLo;
-            }
-        } 
-    }
-
+    statevec_multiControlledUnitaryLocal(qureg, targetQubit, 1LL << controlQubit, 0, u);
 }
 
 /** Rotate a single qubit in the state vector of probability amplitudes, given two complex 
@@ -2495,50 +3292,168 @@ void statevec_multiControlledUnitaryDistributed (
     }
 }
 
-void statevec_pauliXLocal(Qureg qureg, int targetQubit)
+/** Applies NOT to every qubit in targMask, upon only the amplitudes for which every qubit 
+ * in ctrlMask is 1. This is a pure permutation of amplitudes, so no arithmetic is performed.
+ * The visited indices are enumerated by inserting the controls (as 1) and the highest 
+ * target (as 0) into the task index, so amplitudes failing the controls are never touched. 
+ * Consecutive tasks are contiguous in runs of sizeRun amplitudes (below the lowest such 
+ * inserted qubit) so that, for high qubits, the swaps are unit-stride block swaps which the 
+ * compiler can vectorise. As in statevec_unitaryLocal, the OpenMP loop is placed on 
+ * whichever of the runs, or the amplitudes within a run, are more numerous.
+ * Controls upon qubits beyond this chunk are permitted; all targets must be local.
+ */
+void statevec_multiControlledMultiQubitNotLocal(Qureg qureg, long long int ctrlMask, long long int targMask)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;         
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;  
-    sizeBlock     = 2LL * sizeHalfBlock; 
-
+    // controls upon qubits beyond this chunk are identical for every local amplitude
+    long long int localMask = qureg.numAmpsPerChunk - 1;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int globalCtrlMask = ctrlMask & ~localMask;
+    if ((globalIndStart & globalCtrlMask) != globalCtrlMask)
+        return;
+    ctrlMask &= localMask;
+    
+    // the qubits fixed by the enumeration, in increasing order
+    int highTarg = 0;
+    while (targMask >> (highTarg+1))
+        highTarg++;
+    long long int fixedMask = ctrlMask | (1LL << highTarg);
+    int fixedQubits[qureg.numQubitsInStateVec];
+    int numFixed = 0;
+    for (int q=0; (fixedMask >> q) != 0; q++)
+        if (maskContainsBit(fixedMask, q))
+            fixedQubits[numFixed++] = q;
+    
+    long long int sizeRun = 1LL << fixedQubits[0];
+    long long int numTasks = qureg.numAmpsPerChunk >> numFixed;
+    long long int numRuns = numTasks / sizeRun;
+    long long int lowTargMask = targMask & (sizeRun-1);  // targets within a run
+    long long int highTargMask = targMask ^ lowTargMask;
+    
     // Can't use qureg.stateVec as a private OMP var
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
+    
+    long long int thisTask, thisRun, thisOffset, runUp, runLo, indexUp, indexLo;
+    qreal stateRealUp, stateImagUp;
+    int f;
+    
+    int isShortRun = (sizeRun < LOW_TARGET_HALF_BLOCK);
+    int isParallelOverRuns = (numRuns >= sizeRun);
+
+# define macro_swapAmpPair \
+    stateRealUp = stateVecReal[indexUp]; \
+    stateImagUp = stateVecImag[indexUp]; \
+    stateVecReal[indexUp] = stateVecReal[indexLo]; \
+    stateVecImag[indexUp] = stateVecImag[indexLo]; \
+    stateVecReal[indexLo] = stateRealUp; \
+    stateVecImag[indexLo] = stateImagUp;
+
+// the first index of thisRun (with controls 1 and highest target 0), and that of its pair run
+# define macro_findRunStarts \
+    runUp = thisRun*sizeRun; \
+    for (f=0; f < numFixed; f++) \
+        runUp = insertZeroBit(runUp, fixedQubits[f]); \
+    runUp |= ctrlMask; \
+    runLo = runUp ^ highTargMask;
 
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none) \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, numTasks) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp)
+    shared   (stateVecReal,stateVecImag, numTasks,numRuns,sizeRun, ctrlMask,targMask,lowTargMask,highTargMask, \
+              fixedQubits,numFixed, isShortRun,isParallelOverRuns) \
+    private  (thisTask,thisRun,thisOffset, runUp,runLo,indexUp,indexLo, stateRealUp,stateImagUp, f)
 # endif
     {
+        if (isShortRun) {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
+            for (thisTask=0; thisTask<numTasks; thisTask++) {
+                indexUp = thisTask;
+                for (f=0; f < numFixed; f++)
+                    indexUp = insertZeroBit(indexUp, fixedQubits[f]);
+                indexUp |= ctrlMask;
+                indexLo = indexUp ^ targMask;
+                macro_swapAmpPair
+            }
+        }
+        else if (isParallelOverRuns) {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+            for (thisRun=0; thisRun<numRuns; thisRun++) {
+                macro_findRunStarts
+                for (thisOffset=0; thisOffset<sizeRun; thisOffset++) {
+                    indexUp = runUp + thisOffset;
+                    indexLo = runLo + (thisOffset ^ lowTargMask);
+                    macro_swapAmpPair
+                }
+            }
+        }
+        else {
+            for (thisRun=0; thisRun<numRuns; thisRun++) {
+                macro_findRunStarts
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+                for (thisOffset=0; thisOffset<sizeRun; thisOffset++) {
+                    indexUp = runUp + thisOffset;
+                    indexLo = runLo + (thisOffset ^ lowTargMask);
+                    macro_swapAmpPair
+                }
+            }
+        }
+    }
 
-            stateRealUp = stateVecReal[indexUp];
-            stateImagUp = stateVecImag[indexUp];
+# undef macro_swapAmpPair
+# undef macro_findRunStarts
+}
 
-            stateVecReal[indexUp] = stateVecReal[indexLo];
-            stateVecImag[indexUp] = stateVecImag[indexLo];
+/** Applies NOT to every qubit in targMask, upon only the amplitudes for which every qubit 
+ * in ctrlMask is 1, where some targets lie beyond this chunk. stateVecIn must be the entire 
+ * chunk of the pair node, which differs from this chunk in the non-local targets. 
+ *
+ *  @param[in,out] qureg object representing the set of qubits
+ *  @param[in] ctrlMask bit mask of the control qubits
+ *  @param[in] targMask bit mask of the target qubits
+ *  @param[in] stateVecIn probability amplitudes of the pair chunk
+ *  @param[out] stateVecOut this chunk's amplitudes, to update
+ */
+void statevec_multiControlledMultiQubitNotDistributed(Qureg qureg, long long int ctrlMask, long long int targMask,
+        ComplexArray stateVecIn,
+        ComplexArray stateVecOut)
+{
+    long long int thisTask;  
+    long long int numTasks=qureg.numAmpsPerChunk;
+    long long int globalIndStart=qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int localTargMask = targMask & (qureg.numAmpsPerChunk-1);
 
-            stateVecReal[indexLo] = stateRealUp;
-            stateVecImag[indexLo] = stateImagUp;
-        } 
+    qreal *stateVecRealIn=stateVecIn.real, *stateVecImagIn=stateVecIn.imag;
+    qreal *stateVecRealOut=stateVecOut.real, *stateVecImagOut=stateVecOut.imag;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (stateVecRealIn,stateVecImagIn,stateVecRealOut,stateVecImagOut, \
+                numTasks,globalIndStart,ctrlMask,localTargMask) \
+    private  (thisTask)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            if (((thisTask+globalIndStart) & ctrlMask) == ctrlMask) {
+                stateVecRealOut[thisTask] = stateVecRealIn[thisTask ^ localTargMask];
+                stateVecImagOut[thisTask] = stateVecImagIn[thisTask ^ localTargMask];
+            }
+        }
     }
+}
 
+void statevec_pauliXLocal(Qureg qureg, int targetQubit)
+{
+    statevec_multiControlledMultiQubitNotLocal(qureg, 0, 1LL << targetQubit);
 }
 
 /** Rotate a single qubit by {{0,1},{1,0}.
@@ -2583,54 +3498,7 @@ void statevec_pauliXDistributed (Qureg qureg,
 
 void statevec_controlledNotLocal(Qureg qureg, int controlQubit, int targetQubit)
 {
-    long long int sizeBlock, sizeHalfBlock;
-    long long int thisBlock, // current block
-         indexUp,indexLo;    // current index and corresponding index in lower half block
-
-    qreal stateRealUp,stateImagUp;
-    long long int thisTask;         
-    long long int numTasks=qureg.numAmpsPerChunk>>1;
-    long long int chunkSize=qureg.numAmpsPerChunk;
-    long long int chunkId=qureg.chunkId;
-
-    int controlBit;
-
-    // set dimensions
-    sizeHalfBlock = 1LL << targetQubit;  
-    sizeBlock     = 2LL * sizeHalfBlock; 
-
-    // Can't use qureg.stateVec as a private OMP var
-    qreal *stateVecReal = qureg.stateVec.real;
-    qreal *stateVecImag = qureg.stateVec.imag;
-
-# ifdef _OPENMP
-# pragma omp parallel \
-    default  (none) \
-    shared   (sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag,numTasks,chunkId,chunkSize,controlQubit) \
-    private  (thisTask,thisBlock ,indexUp,indexLo, stateRealUp,stateImagUp,controlBit)
-# endif
-    {
-# ifdef _OPENMP
-# pragma omp for schedule (static)
-# endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {
-            thisBlock   = thisTask / sizeHalfBlock;
-            indexUp     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
-            indexLo     = indexUp + sizeHalfBlock;
-
-            controlBit = extractBit(controlQubit, indexUp+chunkId*chunkSize);
-            if (controlBit){
-                stateRealUp = stateVecReal[indexUp];
-                stateImagUp = stateVecImag[indexUp];
-
-                stateVecReal[indexUp] = stateVecReal[indexLo];
-                stateVecImag[indexUp] = stateVecImag[indexLo];
-
-                stateVecReal[indexLo] = stateRealUp;
-                stateVecImag[indexLo] = stateImagUp;
-            }
-        } 
-    }
+    statevec_multiControlledMultiQubitNotLocal(qureg, 1LL << controlQubit, 1LL << targetQubit);
 }
 
 /** Rotate a single qubit by {{0,1},{1,0}.
@@ -3106,44 +3974,209 @@ int getBitMaskParity(long long int mask) {
     return parity;
 }
 
-void statevec_multiRotateZ(Qureg qureg, long long int mask, qreal angle)
+void statevec_multiRotateZ(Qureg qureg, long long int mask, qreal angle)
+{
+    long long int index;
+    long long int stateVecSize;
+
+    long long int chunkSize=qureg.numAmpsPerChunk;
+    long long int chunkId=qureg.chunkId;
+
+    stateVecSize = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    
+    qreal stateReal, stateImag;
+    qreal cosAngle = cos(angle/2.0);
+    qreal sinAngle = sin(angle/2.0); 
+    
+    // = +-1, to flip sinAngle based on target qubit parity, to effect
+    // exp(-angle/2 i fac_j)|j>
+    int fac; 
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none)              \
+    shared   (stateVecSize, stateVecReal, stateVecImag, mask, chunkId,chunkSize,cosAngle,sinAngle) \
+    private  (index, fac, stateReal, stateImag)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++) {
+            stateReal = stateVecReal[index];
+            stateImag = stateVecImag[index];
+            
+            // odd-parity target qubits get fac_j = -1
+            fac = getBitMaskParity(mask & (index+chunkId*chunkSize))? -1 : 1;
+            stateVecReal[index] = cosAngle*stateReal + fac * sinAngle*stateImag;
+            stateVecImag[index] = - fac * sinAngle*stateReal + cosAngle*stateImag;  
+        }
+    }
+}
+
+/** Multiplies every amplitude by the product of all the given diagonal terms, in a 
+ * single pass. Each phase term multiplies the basis states in which every qubit in 
+ * phaseMasks[t] is 1 by exp(i phaseAngles[t]), and each parity term multiplies basis 
+ * states by exp(-i parityAngles[t]/2) or exp(i parityAngles[t]/2) when the qubits in 
+ * parityMasks[t] have even or odd parity, as does statevec_multiRotateZ. The total 
+ * phase of each amplitude is found from its index bits, so that the cost is one 
+ * sin and cos per amplitude, regardless of the number of terms.
+ */
+void statevec_applyDiagonalPhases(Qureg qureg, 
+    long long int* phaseMasks, qreal* phaseAngles, int numPhaseTerms, 
+    long long int* parityMasks, qreal* parityAngles, int numParityTerms)
+{
+    long long int index, globalIndex;
+    long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    
+    qreal stateReal, stateImag, angle, cosAngle, sinAngle;
+    int t;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none)              \
+    shared   (stateVecSize, stateVecReal, stateVecImag, globalIndStart, \
+              phaseMasks,phaseAngles,numPhaseTerms, parityMasks,parityAngles,numParityTerms) \
+    private  (index, globalIndex, stateReal, stateImag, angle, cosAngle, sinAngle, t)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (index=0; index<stateVecSize; index++) {
+            globalIndex = index + globalIndStart;
+            
+            // accumulate the total phase of this basis state from every term
+            angle = 0;
+            for (t=0; t < numPhaseTerms; t++)
+                if ((globalIndex & phaseMasks[t]) == phaseMasks[t])
+                    angle += phaseAngles[t];
+            for (t=0; t < numParityTerms; t++)
+                angle += (getBitMaskParity(globalIndex & parityMasks[t]))? 
+                    parityAngles[t]/2 : - parityAngles[t]/2;
+            
+            if (angle == 0)
+                continue;
+            
+            cosAngle = cos(angle);
+            sinAngle = sin(angle);
+            stateReal = stateVecReal[index];
+            stateImag = stateVecImag[index];
+            stateVecReal[index] = cosAngle*stateReal - sinAngle*stateImag;
+            stateVecImag[index] = sinAngle*stateReal + cosAngle*stateImag;
+        }
+    }
+}
+
+/** Effects diagFac I + offDiagFac P' upon every pair of amplitudes (i, i ^ xMask), where 
+ * P' maps |j> to (-1)^|j & zMask| |j ^ xMask|>. With diagFac = cos(angle/2) and offDiagFac 
+ * = -i sin(angle/2) i^numY, this is the rotation exp(-i angle/2 P) of the Pauli product P 
+ * with these masks, effected in a single pass regardless of its weight. xMask must target 
+ * only local qubits, and must be non-zero.
+ */
+void statevec_multiRotatePauliMasksLocal(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac)
+{
+    long long int thisTask, indexLo, indexHi;
+    long long int numTasks = qureg.numAmpsPerChunk >> 1;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    
+    // each pair is visited once, by the index with the highest bit of xMask as zero
+    int pairBit = 0;
+    while (xMask >> (pairBit + 1))
+        pairBit++;
+    
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    qreal offRe = offDiagFac.real;
+    qreal offIm = offDiagFac.imag;
+    
+    qreal stateRealLo, stateImagLo, stateRealHi, stateImagHi;
+    int signLo, signHi;
+
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none)              \
+    shared   (numTasks, stateVecReal, stateVecImag, globalIndStart, pairBit, xMask,zMask, diagFac,offRe,offIm) \
+    private  (thisTask, indexLo,indexHi, stateRealLo,stateImagLo,stateRealHi,stateImagHi, signLo,signHi)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (thisTask=0; thisTask<numTasks; thisTask++) {
+            indexLo = insertZeroBit(thisTask, pairBit);
+            indexHi = indexLo ^ xMask;
+            
+            signLo = getBitMaskParity((indexLo + globalIndStart) & zMask)? -1 : 1;
+            signHi = getBitMaskParity((indexHi + globalIndStart) & zMask)? -1 : 1;
+            
+            stateRealLo = stateVecReal[indexLo];
+            stateImagLo = stateVecImag[indexLo];
+            stateRealHi = stateVecReal[indexHi];
+            stateImagHi = stateVecImag[indexHi];
+            
+            // lo = diag lo + off signHi hi
+            stateVecReal[indexLo] = diagFac*stateRealLo + signHi*(offRe*stateRealHi - offIm*stateImagHi);
+            stateVecImag[indexLo] = diagFac*stateImagLo + signHi*(offRe*stateImagHi + offIm*stateRealHi);
+            
+            // hi = diag hi + off signLo lo
+            stateVecReal[indexHi] = diagFac*stateRealHi + signLo*(offRe*stateRealLo - offIm*stateImagLo);
+            stateVecImag[indexHi] = diagFac*stateImagHi + signLo*(offRe*stateImagLo + offIm*stateRealLo);
+        }
+    }
+}
+
+/** As statevec_multiRotatePauliMasksLocal, but where xMask targets non-local qubits, so that 
+ * each amplitude i is paired with i ^ xMask in pairStateVec, which holds the amplitudes of 
+ * the chunk differing from this one in the non-local bits of xMask.
+ */
+void statevec_multiRotatePauliMasksDistributed(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac, 
+    ComplexArray pairStateVec)
 {
-    long long int index;
-    long long int stateVecSize;
-
-    long long int chunkSize=qureg.numAmpsPerChunk;
-    long long int chunkId=qureg.chunkId;
-
-    stateVecSize = qureg.numAmpsPerChunk;
+    long long int index, pairIndex;
+    long long int numAmps = qureg.numAmpsPerChunk;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int localXMask = xMask & (numAmps - 1);
+    
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
+    qreal *pairVecReal = pairStateVec.real;
+    qreal *pairVecImag = pairStateVec.imag;
+    qreal offRe = offDiagFac.real;
+    qreal offIm = offDiagFac.imag;
     
-    qreal stateReal, stateImag;
-    qreal cosAngle = cos(angle/2.0);
-    qreal sinAngle = sin(angle/2.0); 
-    
-    // = +-1, to flip sinAngle based on target qubit parity, to effect
-    // exp(-angle/2 i fac_j)|j>
-    int fac; 
+    qreal stateReal, stateImag, pairReal, pairImag;
+    int pairSign;
 
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none)              \
-    shared   (stateVecSize, stateVecReal, stateVecImag, mask, chunkId,chunkSize,cosAngle,sinAngle) \
-    private  (index, fac, stateReal, stateImag)
+    shared   (numAmps, stateVecReal,stateVecImag, pairVecReal,pairVecImag, globalIndStart, \
+                localXMask,xMask,zMask, diagFac,offRe,offIm) \
+    private  (index,pairIndex, stateReal,stateImag,pairReal,pairImag, pairSign)
 # endif
     {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (index=0; index<stateVecSize; index++) {
+        for (index=0; index<numAmps; index++) {
+            pairIndex = index ^ localXMask;
+            pairSign = getBitMaskParity(((index + globalIndStart) ^ xMask) & zMask)? -1 : 1;
+            
             stateReal = stateVecReal[index];
             stateImag = stateVecImag[index];
+            pairReal = pairVecReal[pairIndex];
+            pairImag = pairVecImag[pairIndex];
             
-            // odd-parity target qubits get fac_j = -1
-            fac = getBitMaskParity(mask & (index+chunkId*chunkSize))? -1 : 1;
-            stateVecReal[index] = cosAngle*stateReal + fac * sinAngle*stateImag;
-            stateVecImag[index] = - fac * sinAngle*stateReal + cosAngle*stateImag;  
+            // amp = diag amp + off pairSign pair
+            stateVecReal[index] = diagFac*stateReal + pairSign*(offRe*pairReal - offIm*pairImag);
+            stateVecImag[index] = diagFac*stateImag + pairSign*(offRe*pairImag + offIm*pairReal);
         }
     }
 }
@@ -3168,16 +4201,19 @@ qreal densmatr_findProbabilityOfZeroLocal(Qureg qureg, int measureQubit) {
     long long int basisStateInd;    // current diagonal index being considered
     long long int index;            // index in the local chunk
     
-    qreal zeroProb = 0;
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum zeroProbParts[numThreadSums];
+    initThreadSums(zeroProbParts, numThreadSums);
+    CompensatedSum threadProb;
     qreal *stateVecReal = qureg.stateVec.real;
     
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (localIndNextDiag, numPrevDiags, diagSpacing, stateVecReal, numDiagsInThisChunk) \
-    private   (visitedDiags, basisStateInd, index) \
-    reduction ( +:zeroProb )
+    shared    (localIndNextDiag, numPrevDiags, diagSpacing, stateVecReal, numDiagsInThisChunk, zeroProbParts) \
+    private   (visitedDiags, basisStateInd, index, threadProb)
 # endif 
     {
+        threadProb = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
@@ -3188,12 +4224,13 @@ qreal densmatr_findProbabilityOfZeroLocal(Qureg qureg, int measureQubit) {
             index = localIndNextDiag + diagSpacing * visitedDiags;
     
             if (extractBit(measureQubit, basisStateInd) == 0)
-                zeroProb += stateVecReal[index]; // assume imag[diagonls] ~ 0
+                addToCompensatedSum(&threadProb, stateVecReal[index]); // assume imag[diagonls] ~ 0
 
         }
+        setThreadSum(zeroProbParts, threadProb);
     }
     
-    return zeroProb;
+    return getThreadSumsValue(zeroProbParts, numThreadSums);
 }
 
 /** Measure the total probability of a specified qubit being in the zero state across all amplitudes in this chunk.
@@ -3213,7 +4250,7 @@ qreal statevec_findProbabilityOfZeroLocal (Qureg qureg,
     long long int thisBlock,                                  // current block
          index;                                               // current index for first half block
     // ----- measured probability
-    qreal   totalProbability;                                  // probability (returned) value
+    CompensatedSum threadProbability;                         // each thread's part of the probability
     // ----- temp variables
     long long int thisTask;                                   
     long long int numTasks=qureg.numAmpsPerChunk>>1;
@@ -3225,19 +4262,21 @@ qreal statevec_findProbabilityOfZeroLocal (Qureg qureg,
     // and then the number to skip
     sizeBlock     = 2LL * sizeHalfBlock;                         // size of blocks (pairs of measure and skip entries)
 
-    // initialise returned value
-    totalProbability = 0.0;
+    // the threads' parts of the returned value, combined in thread order
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum totalProbabilityParts[numThreadSums];
+    initThreadSums(totalProbabilityParts, numThreadSums);
 
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (numTasks,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag) \
-    private   (thisTask,thisBlock,index) \
-    reduction ( +:totalProbability )
+    shared    (numTasks,sizeBlock,sizeHalfBlock, stateVecReal,stateVecImag, totalProbabilityParts) \
+    private   (thisTask,thisBlock,index, threadProbability)
 # endif 
     {
+        threadProbability = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
@@ -3245,11 +4284,12 @@ qreal statevec_findProbabilityOfZeroLocal (Qureg qureg,
             thisBlock = thisTask / sizeHalfBlock;
             index     = thisBlock*sizeBlock + thisTask%sizeHalfBlock;
 
-            totalProbability += stateVecReal[index]*stateVecReal[index]
-                + stateVecImag[index]*stateVecImag[index];
+            addToCompensatedSum(&threadProbability, 
+                (qaccum) stateVecReal[index]*stateVecReal[index] + (qaccum) stateVecImag[index]*stateVecImag[index]);
         }
+        setThreadSum(totalProbabilityParts, threadProbability);
     }
-    return totalProbability;
+    return getThreadSumsValue(totalProbabilityParts, numThreadSums);
 }
 
 /** Measure the probability of a specified qubit being in the zero state across all amplitudes held in this chunk.
@@ -3261,7 +4301,7 @@ qreal statevec_findProbabilityOfZeroLocal (Qureg qureg,
  */
 qreal statevec_findProbabilityOfZeroDistributed (Qureg qureg) {
     // ----- measured probability
-    qreal   totalProbability;                                  // probability (returned) value
+    CompensatedSum threadProbability;                         // each thread's part of the probability
     // ----- temp variables
     long long int thisTask;                                   // task based approach for expose loop with small granularity
     long long int numTasks=qureg.numAmpsPerChunk;
@@ -3270,29 +4310,447 @@ qreal statevec_findProbabilityOfZeroDistributed (Qureg qureg) {
     //            find probability                                      //
     // ---------------------------------------------------------------- //
 
-    // initialise returned value
-    totalProbability = 0.0;
+    // the threads' parts of the returned value, combined in thread order
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum totalProbabilityParts[numThreadSums];
+    initThreadSums(totalProbabilityParts, numThreadSums);
 
     qreal *stateVecReal = qureg.stateVec.real;
     qreal *stateVecImag = qureg.stateVec.imag;
 
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (numTasks,stateVecReal,stateVecImag) \
-    private   (thisTask) \
-    reduction ( +:totalProbability )
+    shared    (numTasks,stateVecReal,stateVecImag, totalProbabilityParts) \
+    private   (thisTask, threadProbability)
 # endif
     {
+        threadProbability = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
         for (thisTask=0; thisTask<numTasks; thisTask++) {
-            totalProbability += stateVecReal[thisTask]*stateVecReal[thisTask]
-                + stateVecImag[thisTask]*stateVecImag[thisTask];
+            addToCompensatedSum(&threadProbability, 
+                (qaccum) stateVecReal[thisTask]*stateVecReal[thisTask] + (qaccum) stateVecImag[thisTask]*stateVecImag[thisTask]);
+        }
+        setThreadSum(totalProbabilityParts, threadProbability);
+    }
+
+    return getThreadSumsValue(totalProbabilityParts, numThreadSums);
+}
+
+/** Computes the sum of |amp|^2 over every amplitude in this chunk */
+qreal statevec_calcTotalProbLocal(Qureg qureg) {
+    
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum totalProbParts[numThreadSums];
+    initThreadSums(totalProbParts, numThreadSums);
+    CompensatedSum threadProb;
+    long long int index;
+    long long int numAmps = qureg.numAmpsPerChunk;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (numAmps, stateVecReal,stateVecImag, totalProbParts) \
+    private   (index, threadProb)
+# endif
+    {
+        threadProb = (CompensatedSum) {0, 0};
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0; index<numAmps; index++) {
+            addToCompensatedSum(&threadProb, 
+                (qaccum) stateVecReal[index]*stateVecReal[index] + (qaccum) stateVecImag[index]*stateVecImag[index]);
+        }
+        setThreadSum(totalProbParts, threadProb);
+    }
+    
+    return getThreadSumsValue(totalProbParts, numThreadSums);
+}
+
+/** Returns the index of the first of the sorted shots at or beyond cumulative probability prob */
+static int findFirstSampledShot(SampledShot* shots, int numShots, qaccum prob) {
+    int lo = 0;
+    int hi = numShots;
+    while (lo < hi) {
+        int mid = lo + (hi - lo)/2;
+        if (shots[mid].prob < prob)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/** The number of contiguous blocks into which the local basis states are divided when 
+ * sampling, such that each thread computes the probability of (and later sweeps) one block */
+static int getNumSampledBlocks(void) {
+    int numBlocks = 1;
+# ifdef _OPENMP
+    numBlocks = omp_get_max_threads();
+# endif
+    return numBlocks;
+}
+
+/** Finds the basis states [firstBasis, endBasis) whose probabilities are stored in this chunk, 
+ * being every amplitude of a state-vector, or every diagonal element of a density matrix. The 
+ * probability of basis state i is stored at local index i*spacing - chunkStart */
+static void getLocalBasisStates(Qureg qureg, long long int* firstBasis, long long int* endBasis, long long int* spacing) {
+    long long int chunkStart = qureg.chunkId * qureg.numAmpsPerChunk;
+    long long int chunkEnd = chunkStart + qureg.numAmpsPerChunk;
+    long long int diagSpacing = (qureg.isDensityMatrix)? 1LL + (1LL << qureg.numQubitsRepresented) : 1;
+    
+    *firstBasis = (chunkStart + diagSpacing - 1) / diagSpacing;
+    *endBasis = (chunkEnd + diagSpacing - 1) / diagSpacing;
+    *spacing = diagSpacing;
+}
+
+/** Sums the probabilities of the local basis states within each of numBlocks contiguous blocks */
+static void calcSampledBlockProbs(Qureg qureg, int numBlocks, qaccum* blockProbs) {
+    
+    long long int firstBasis, endBasis, spacing;
+    getLocalBasisStates(qureg, &firstBasis, &endBasis, &spacing);
+    long long int numBasis = endBasis - firstBasis;
+    long long int blockSize = (numBasis + numBlocks - 1) / numBlocks;
+    long long int chunkStart = qureg.chunkId * qureg.numAmpsPerChunk;
+    int isDensityMatrix = qureg.isDensityMatrix;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int basis, basisStart, basisEnd, index;
+    qaccum blockProb, prob;
+    int block;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (numBlocks,blockProbs, firstBasis,numBasis,blockSize,spacing,chunkStart, isDensityMatrix,stateVecReal,stateVecImag) \
+    private  (block, basis,basisStart,basisEnd,index, blockProb,prob)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (block=0; block<numBlocks; block++) {
+            basisStart = firstBasis + ((block*blockSize < numBasis)? block*blockSize : numBasis);
+            basisEnd = firstBasis + (((block+1)*blockSize < numBasis)? (block+1)*blockSize : numBasis);
+            
+            // (unphysical) negative diagonals of a density matrix are never sampled
+            blockProb = 0;
+            for (basis=basisStart; basis<basisEnd; basis++) {
+                index = basis*spacing - chunkStart;
+                if (isDensityMatrix)
+                    prob = stateVecReal[index];
+                else
+                    prob = (qaccum) stateVecReal[index]*stateVecReal[index] + (qaccum) stateVecImag[index]*stateVecImag[index];
+                if (prob > 0)
+                    blockProb += prob;
+            }
+            blockProbs[block] = blockProb;
+        }
+    }
+}
+
+/** Computes the total probability of the basis states stored in this chunk (the sum of |amp|^2 
+ * of a state-vector, or of the diagonal of a density matrix), summed exactly as the cumulative 
+ * probabilities are by statevec_sampleOutcomesLocal */
+qaccum statevec_calcSampledProbLocal(Qureg qureg) {
+    
+    int numBlocks = getNumSampledBlocks();
+    qaccum* blockProbs = malloc(numBlocks * sizeof *blockProbs);
+    validateMemoryAllocation(blockProbs != NULL, __func__);
+    calcSampledBlockProbs(qureg, numBlocks, blockProbs);
+    
+    qaccum totalProb = 0;
+    for (int b=0; b<numBlocks; b++)
+        totalProb += blockProbs[b];
+    
+    free(blockProbs);
+    return totalProb;
+}
+
+/** Draws numShots basis states (of a state-vector, or the diagonal of a density matrix) 
+ * with probabilities given by the whole distributed register, and sets outcomes[s] to the 
+ * bits (at qubits) of every shot s which falls within this chunk, leaving the other 
+ * outcomes untouched. This chunk spans cumulative probabilities [probOffset, probEnd) 
+ * (as found by statevec_calcSampledProbLocal on every node) of the register's totalProb.
+ * Every node draws the same shots, as positions within the cumulative probability which 
+ * are sorted, so that each thread finds the shots within its block by binary search, 
+ * and then assigns them in a single sweep of the block */
+void statevec_sampleOutcomesLocal(
+    Qureg qureg, int* qubits, int numQubits, int numShots,
+    qaccum probOffset, qaccum probEnd, qaccum totalProb, long long int* outcomes
+) {
+    SampledShot* shots = malloc(numShots * sizeof *shots);
+    validateMemoryAllocation(shots != NULL, __func__);
+    for (int s=0; s<numShots; s++) {
+        shots[s].prob = genrand_real2() * totalProb;
+        shots[s].index = s;
+    }
+    qsort(shots, numShots, sizeof *shots, compareSampledShots);
+    
+    // the cumulative probability at the start of each block, chained from the block sums
+    int numBlocks = getNumSampledBlocks();
+    qaccum* blockProbs = malloc(numBlocks * sizeof *blockProbs);
+    qaccum* blockBounds = malloc((numBlocks + 1) * sizeof *blockBounds);
+    validateMemoryAllocation(blockProbs && blockBounds, __func__);
+    calcSampledBlockProbs(qureg, numBlocks, blockProbs);
+    
+    blockBounds[0] = probOffset;
+    for (int b=0; b<numBlocks; b++)
+        blockBounds[b+1] = (blockBounds[b] + blockProbs[b] < probEnd)? blockBounds[b] + blockProbs[b] : probEnd;
+    blockBounds[numBlocks] = probEnd;
+    
+    long long int firstBasis, endBasis, spacing;
+    getLocalBasisStates(qureg, &firstBasis, &endBasis, &spacing);
+    long long int numBasis = endBasis - firstBasis;
+    long long int blockSize = (numBasis + numBlocks - 1) / numBlocks;
+    long long int chunkStart = qureg.chunkId * qureg.numAmpsPerChunk;
+    int isDensityMatrix = qureg.isDensityMatrix;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int basis, basisStart, basisEnd, lastBasis, index, outcome;
+    qaccum cumProb, prob;
+    int block, shot, shotEnd, q;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (numBlocks,blockBounds, shots,numShots, qubits,numQubits,outcomes, \
+              firstBasis,numBasis,blockSize,spacing,chunkStart, isDensityMatrix,stateVecReal,stateVecImag) \
+    private  (block, basis,basisStart,basisEnd,lastBasis,index,outcome, cumProb,prob, shot,shotEnd,q)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+        for (block=0; block<numBlocks; block++) {
+            shot = findFirstSampledShot(shots, numShots, blockBounds[block]);
+            shotEnd = findFirstSampledShot(shots, numShots, blockBounds[block+1]);
+            if (shot == shotEnd)
+                continue;
+            
+            basisStart = firstBasis + ((block*blockSize < numBasis)? block*blockSize : numBasis);
+            basisEnd = firstBasis + (((block+1)*blockSize < numBasis)? (block+1)*blockSize : numBasis);
+            
+            // assign each shot the basis state at which the cumulative probability passes it
+            cumProb = blockBounds[block];
+            lastBasis = basisStart;
+            for (basis=basisStart; basis<basisEnd && shot<shotEnd; basis++) {
+                index = basis*spacing - chunkStart;
+                if (isDensityMatrix)
+                    prob = stateVecReal[index];
+                else
+                    prob = (qaccum) stateVecReal[index]*stateVecReal[index] + (qaccum) stateVecImag[index]*stateVecImag[index];
+                if (prob <= 0)
+                    continue;
+                
+                cumProb += prob;
+                lastBasis = basis;
+                if (shots[shot].prob >= cumProb)
+                    continue;
+                
+                outcome = 0;
+                for (q=0; q<numQubits; q++)
+                    outcome |= (long long int) extractBit(qubits[q], basis) << q;
+                for (; shot<shotEnd && shots[shot].prob < cumProb; shot++)
+                    outcomes[shots[shot].index] = outcome;
+            }
+            
+            // shots beyond the swept cumulative probability (by rounding) take the final outcome
+            outcome = 0;
+            for (q=0; q<numQubits; q++)
+                outcome |= (long long int) extractBit(qubits[q], lastBasis) << q;
+            for (; shot<shotEnd; shot++)
+                outcomes[shots[shot].index] = outcome;
         }
     }
+    
+    free(shots);
+    free(blockProbs);
+    free(blockBounds);
+}
+
+/* the largest number of outcomes for which calcProbOfAllOutcomes gives every thread a private histogram */
+# define MAX_OUTCOME_HISTOGRAM_SIZE (1LL<<16)
+
+/** Returns the j-th basis state of those with bits fixedBits at the numFixed fixedQubits (in increasing order) */
+static inline long long int getBasisWithFixedBits(long long int j, int* fixedQubits, int numFixed, long long int fixedBits) {
+    for (int f=0; f<numFixed; f++)
+        j = insertZeroBit(j, fixedQubits[f]);
+    return j | fixedBits;
+}
+
+/** Returns the smallest j in [0, numFree] for which getBasisWithFixedBits(j) is at least minBasis */
+static long long int findFirstBasisWithFixedBits(
+    long long int minBasis, long long int numFree, int* fixedQubits, int numFixed, long long int fixedBits
+) {
+    long long int lo = 0;
+    long long int hi = numFree;
+    while (lo < hi) {
+        long long int mid = lo + (hi - lo)/2;
+        if (getBasisWithFixedBits(mid, fixedQubits, numFixed, fixedBits) < minBasis)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
 
-    return totalProbability;
+/** Computes the probability of every outcome of the given qubits, from the basis states stored 
+ * in this chunk (every amplitude of a state-vector, or every diagonal element of a density 
+ * matrix). The outcome of each basis state is assembled from a lookup of each of its bytes, 
+ * rather than from each of its qubits. 
+ * 
+ * For few outcomes, each thread accumulates a private histogram in a single sweep of the 
+ * chunk, and the histograms are summed in order of thread index. Beyond MAX_OUTCOME_HISTOGRAM_SIZE
+ * outcomes, the outcomes are instead partitioned by their bits at some of the qubits, and each 
+ * partition's basis states are enumerated and accumulated (directly into outcomeProbs, since 
+ * every outcome then receives few terms) by one thread, so that no extra memory is needed */
+void statevec_calcProbOfAllOutcomesLocal(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs) {
+    
+    long long int firstBasis, endBasis, spacing;
+    getLocalBasisStates(qureg, &firstBasis, &endBasis, &spacing);
+    long long int numOutcomes = 1LL << numQubits;
+    long long int chunkStart = qureg.chunkId * qureg.numAmpsPerChunk;
+    int isDensityMatrix = qureg.isDensityMatrix;
+    qreal *stateVecReal = qureg.stateVec.real;
+    qreal *stateVecImag = qureg.stateVec.imag;
+    long long int basis, index, outcome;
+    qaccum prob;
+    int byte;
+    
+    for (outcome=0; outcome<numOutcomes; outcome++)
+        outcomeProbs[outcome] = 0;
+    
+    // byteOutcomes[byte][b] is the outcome bits set by the value b of the byte-th byte of a basis state
+    int numBytes = (qureg.numQubitsRepresented + 7) / 8;
+    long long int byteOutcomes[numBytes][256];
+    for (byte=0; byte<numBytes; byte++) {
+        for (int b=0; b<256; b++) {
+            byteOutcomes[byte][b] = 0;
+            for (int q=0; q<numQubits; q++)
+                if (qubits[q]/8 == byte)
+                    byteOutcomes[byte][b] |= (long long int) extractBit(qubits[q] % 8, b) << q;
+        }
+    }
+    
+    int numThreads = getNumThreadSums();
+    
+    if (numOutcomes <= MAX_OUTCOME_HISTOGRAM_SIZE) {
+        
+        // threadProbs[t*numOutcomes + outcome] is thread t's histogram
+        qaccum* threadProbs = calloc(numThreads * numOutcomes, sizeof *threadProbs);
+        validateMemoryAllocation(threadProbs != NULL, __func__);
+        int thread;
+        
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (outcomeProbs, numOutcomes,numBytes,byteOutcomes, firstBasis,endBasis,spacing,chunkStart, \
+              isDensityMatrix,stateVecReal,stateVecImag, threadProbs,numThreads) \
+    private  (basis,index,outcome, prob, byte,thread)
+# endif
+        {
+            thread = 0;
+# ifdef _OPENMP
+            thread = omp_get_thread_num();
+# endif
+            qaccum* probs = &threadProbs[thread * numOutcomes];
+            
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+            for (basis=firstBasis; basis<endBasis; basis++) {
+                index = basis*spacing - chunkStart;
+                if (isDensityMatrix)
+                    prob = stateVecReal[index];
+                else
+                    prob = (qaccum) stateVecReal[index]*stateVecReal[index] + (qaccum) stateVecImag[index]*stateVecImag[index];
+                
+                outcome = 0;
+                for (byte=0; byte<numBytes; byte++)
+                    outcome |= byteOutcomes[byte][(basis >> (8*byte)) & 255];
+                probs[outcome] += prob;
+            }
+            
+            // the histograms are summed in order of thread index, so the result is reproducible
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+            for (outcome=0; outcome<numOutcomes; outcome++) {
+                prob = 0;
+                for (int t=0; t<numThreads; t++)
+                    prob += threadProbs[t*numOutcomes + outcome];
+                outcomeProbs[outcome] = prob;
+            }
+        }
+        
+        free(threadProbs);
+        return;
+    }
+    
+    // partition by (a few times as many bit patterns as threads at) the highest-position qubits 
+    // whose bits vary between the local basis states, so that the partitions are balanced
+    int numVaryingBits = 0;
+    while (numVaryingBits < qureg.numQubitsRepresented && (1LL << (numVaryingBits+1)) <= endBasis - firstBasis)
+        numVaryingBits++;
+    int maxPartQubits = 0;
+    while ((1LL << maxPartQubits) < 4*numThreads)
+        maxPartQubits++;
+    int partQubits[maxPartQubits];
+    int numPartQubits = 0;
+    for (int pos=numVaryingBits-1; pos >= 0 && numPartQubits < maxPartQubits; pos--)
+        for (int q=0; q<numQubits; q++)
+            if (qubits[q] == pos)
+                partQubits[numPartQubits++] = pos;
+    
+    // insertZeroBit requires the fixed qubits in increasing order
+    for (int i=0; i<numPartQubits/2; i++) {
+        int tmp = partQubits[i];
+        partQubits[i] = partQubits[numPartQubits-1-i];
+        partQubits[numPartQubits-1-i] = tmp;
+    }
+    
+    long long int numParts = 1LL << numPartQubits;
+    long long int numFree = 1LL << (qureg.numQubitsRepresented - numPartQubits);
+    long long int part, fixedBits, j, jStart, jEnd;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (outcomeProbs, numBytes,byteOutcomes, firstBasis,endBasis,spacing,chunkStart, \
+              isDensityMatrix,stateVecReal,stateVecImag, partQubits,numPartQubits,numParts,numFree) \
+    private  (basis,index,outcome, prob, byte, part,fixedBits,j,jStart,jEnd)
+# endif
+    {
+# ifdef _OPENMP
+# pragma omp for schedule (dynamic)
+# endif
+        for (part=0; part<numParts; part++) {
+            fixedBits = 0;
+            for (int f=0; f<numPartQubits; f++)
+                fixedBits |= ((part >> f) & 1LL) << partQubits[f];
+            
+            jStart = findFirstBasisWithFixedBits(firstBasis, numFree, partQubits, numPartQubits, fixedBits);
+            jEnd = findFirstBasisWithFixedBits(endBasis, numFree, partQubits, numPartQubits, fixedBits);
+            
+            for (j=jStart; j<jEnd; j++) {
+                basis = getBasisWithFixedBits(j, partQubits, numPartQubits, fixedBits);
+                index = basis*spacing - chunkStart;
+                if (isDensityMatrix)
+                    prob = stateVecReal[index];
+                else
+                    prob = (qaccum) stateVecReal[index]*stateVecReal[index] + (qaccum) stateVecImag[index]*stateVecImag[index];
+                
+                outcome = 0;
+                for (byte=0; byte<numBytes; byte++)
+                    outcome |= byteOutcomes[byte][(basis >> (8*byte)) & 255];
+                outcomeProbs[outcome] += prob;
+            }
+        }
+    }
 }
 
 
@@ -3545,31 +5003,70 @@ void statevec_swapQubitAmpsLocal(Qureg qureg, int qb1, int qb2) {
     qreal re01, re10;
     qreal im01, im10;
     
+    // consecutive tasks are contiguous in runs below the lower qubit, so (as in 
+    // statevec_multiControlledMultiQubitNotLocal) for high qubits we swap unit-stride runs
+    int qbLow = (qb1 < qb2)? qb1 : qb2;
+    long long int sizeRun = 1LL << qbLow;
+    long long int numRuns = numTasks / sizeRun;
+    long long int thisRun, thisOffset;
+    int isShortRun = (sizeRun < LOW_TARGET_HALF_BLOCK);
+    int isParallelOverRuns = (numRuns >= sizeRun);
+    
+// swap the |..0..1..> and |..1..0..> amps
+# define macro_swapAmpPair \
+    re01 = reVec[ind01]; im01 = imVec[ind01]; \
+    re10 = reVec[ind10]; im10 = imVec[ind10]; \
+    reVec[ind01] = re10; reVec[ind10] = re01; \
+    imVec[ind01] = im10; imVec[ind10] = im01;
+    
 # ifdef _OPENMP
 # pragma omp parallel \
     default  (none) \
-    shared   (reVec,imVec,numTasks,qb1,qb2) \
-    private  (thisTask, ind00,ind01,ind10, re01,re10, im01,im10) 
+    shared   (reVec,imVec,numTasks,qb1,qb2, numRuns,sizeRun,isShortRun,isParallelOverRuns) \
+    private  (thisTask,thisRun,thisOffset, ind00,ind01,ind10, re01,re10, im01,im10) 
 # endif
     {
+        if (isShortRun) {
 # ifdef _OPENMP
 # pragma omp for schedule (static)
 # endif
-        for (thisTask=0; thisTask<numTasks; thisTask++) {    
-            // determine ind00 of |..0..0..>, |..0..1..> and |..1..0..>
-            ind00 = insertTwoZeroBits(thisTask, qb1, qb2);
-            ind01 = flipBit(ind00, qb1);
-            ind10 = flipBit(ind00, qb2);
-
-            // extract statevec amplitudes 
-            re01 = reVec[ind01]; im01 = imVec[ind01];
-            re10 = reVec[ind10]; im10 = imVec[ind10];
-
-            // swap 01 and 10 amps
-            reVec[ind01] = re10; reVec[ind10] = re01;
-            imVec[ind01] = im10; imVec[ind10] = im01;
+            for (thisTask=0; thisTask<numTasks; thisTask++) {    
+                // determine ind00 of |..0..0..>, |..0..1..> and |..1..0..>
+                ind00 = insertTwoZeroBits(thisTask, qb1, qb2);
+                ind01 = flipBit(ind00, qb1);
+                ind10 = flipBit(ind00, qb2);
+                macro_swapAmpPair
+            }
+        }
+        else if (isParallelOverRuns) {
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+            for (thisRun=0; thisRun<numRuns; thisRun++) {
+                ind00 = insertTwoZeroBits(thisRun*sizeRun, qb1, qb2);
+                for (thisOffset=0; thisOffset<sizeRun; thisOffset++) {
+                    ind01 = flipBit(ind00, qb1) + thisOffset;
+                    ind10 = flipBit(ind00, qb2) + thisOffset;
+                    macro_swapAmpPair
+                }
+            }
+        }
+        else {
+            for (thisRun=0; thisRun<numRuns; thisRun++) {
+                ind00 = insertTwoZeroBits(thisRun*sizeRun, qb1, qb2);
+# ifdef _OPENMP
+# pragma omp for schedule (static)
+# endif
+                for (thisOffset=0; thisOffset<sizeRun; thisOffset++) {
+                    ind01 = flipBit(ind00, qb1) + thisOffset;
+                    ind10 = flipBit(ind00, qb2) + thisOffset;
+                    macro_swapAmpPair
+                }
+            }
         }
     }
+    
+# undef macro_swapAmpPair
 }
 
 /** qureg.pairStateVec contains the entire set of amplitudes of the paired node
@@ -3737,8 +5234,12 @@ void densmatr_applyDiagonalOpLocal(Qureg qureg, DiagonalOp op) {
 
 Complex statevec_calcExpecDiagonalOpLocal(Qureg qureg, DiagonalOp op) {
     
-    qreal expecRe = 0;
-    qreal expecIm = 0;
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum expecReParts[numThreadSums];
+    initThreadSums(expecReParts, numThreadSums);
+    CompensatedSum expecImParts[numThreadSums];
+    initThreadSums(expecImParts, numThreadSums);
+    CompensatedSum threadExpecRe, threadExpecIm;
     
     long long int index;
     long long int numAmps = qureg.numAmpsPerChunk;
@@ -3747,15 +5248,16 @@ Complex statevec_calcExpecDiagonalOpLocal(Qureg qureg, DiagonalOp op) {
     qreal *opReal = op.real;
     qreal *opImag = op.imag;
     
-    qreal vecRe,vecIm,vecAbs, opRe, opIm;
+    qaccum vecRe,vecIm,vecAbs, opRe, opIm;
     
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (stateReal, stateImag, opReal, opImag, numAmps) \
-    private   (index, vecRe,vecIm,vecAbs, opRe,opIm) \
-    reduction ( +:expecRe, expecIm )
+    shared    (stateReal, stateImag, opReal, opImag, numAmps, expecReParts, expecImParts) \
+    private   (index, vecRe,vecIm,vecAbs, opRe,opIm, threadExpecRe,threadExpecIm)
 # endif 
     {
+        threadExpecRe = (CompensatedSum) {0, 0};
+        threadExpecIm = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
@@ -3767,14 +5269,16 @@ Complex statevec_calcExpecDiagonalOpLocal(Qureg qureg, DiagonalOp op) {
             
             // abs(vec)^2 op
             vecAbs = vecRe*vecRe + vecIm*vecIm;
-            expecRe += vecAbs*opRe;
-            expecIm += vecAbs*opIm;
+            addProductToCompensatedSum(&threadExpecRe, vecAbs, opRe);
+            addProductToCompensatedSum(&threadExpecIm, vecAbs, opIm);
         }
+        setThreadSum(expecReParts, threadExpecRe);
+        setThreadSum(expecImParts, threadExpecIm);
     }
     
     Complex innerProd;
-    innerProd.real = expecRe;
-    innerProd.imag = expecIm;
+    innerProd.real = getThreadSumsValue(expecReParts, numThreadSums);
+    innerProd.imag = getThreadSumsValue(expecImParts, numThreadSums);
     return innerProd;
 }
 
@@ -3799,22 +5303,27 @@ Complex densmatr_calcExpecDiagonalOpLocal(Qureg qureg, DiagonalOp op) {
     qreal* opReal = op.real;
     qreal* opImag = op.imag;
     
-    qreal expecRe = 0;
-    qreal expecIm = 0;
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum expecReParts[numThreadSums];
+    initThreadSums(expecReParts, numThreadSums);
+    CompensatedSum expecImParts[numThreadSums];
+    initThreadSums(expecImParts, numThreadSums);
+    CompensatedSum threadExpecRe, threadExpecIm;
     
     long long int stateInd;
     long long int opInd;
-    qreal matRe, matIm, opRe, opIm;
+    qaccum matRe, matIm, opRe, opIm;
     
     // visits every diagonal element with global index (2^n + 1)i for i in [0, 2^n-1]
     
 # ifdef _OPENMP
 # pragma omp parallel \
-    shared    (stateReal,stateImag, opReal,opImag, localIndNextDiag,diagSpacing,numAmps) \
-    private   (stateInd,opInd, matRe,matIm, opRe,opIm) \
-    reduction ( +:expecRe, expecIm )
+    shared    (stateReal,stateImag, opReal,opImag, localIndNextDiag,diagSpacing,numAmps, expecReParts,expecImParts) \
+    private   (stateInd,opInd, matRe,matIm, opRe,opIm, threadExpecRe,threadExpecIm)
 # endif 
     {
+        threadExpecRe = (CompensatedSum) {0, 0};
+        threadExpecIm = (CompensatedSum) {0, 0};
 # ifdef _OPENMP
 # pragma omp for schedule  (static)
 # endif
@@ -3828,17 +5337,212 @@ Complex densmatr_calcExpecDiagonalOpLocal(Qureg qureg, DiagonalOp op) {
             
             // (matRe + matIm i)(opRe + opIm i) = 
             //      (matRe opRe - matIm opIm) + i (matRe opIm + matIm opRe)
-            expecRe += matRe * opRe - matIm * opIm;
-            expecIm += matRe * opIm + matIm * opRe;
+            addProductToCompensatedSum(&threadExpecRe, matRe, opRe);
+            addProductToCompensatedSum(&threadExpecRe, -matIm, opIm);
+            addProductToCompensatedSum(&threadExpecIm, matRe, opIm);
+            addProductToCompensatedSum(&threadExpecIm, matIm, opRe);
         }
+        setThreadSum(expecReParts, threadExpecRe);
+        setThreadSum(expecImParts, threadExpecIm);
     }
     
     Complex expecVal;
-    expecVal.real = expecRe;
-    expecVal.imag = expecIm;
+    expecVal.real = getThreadSumsValue(expecReParts, numThreadSums);
+    expecVal.imag = getThreadSumsValue(expecImParts, numThreadSums);
     return expecVal;
 }
 
+/** Sets weight = sum_t coeffs_t (-1)^|index & zMasks_t|, the diagonal element (at index) of a 
+ * sum of Pauli products sharing an X mask, where each coefficient includes its phase i^numY
+ */
+static inline void getPauliMasksWeight(
+    long long int index, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms,
+    qreal* weightRe, qreal* weightIm
+) {
+    *weightRe = 0;
+    *weightIm = 0;
+    for (int t=0; t < numTerms; t++) {
+        if (getBitMaskParity(index & zMasks[t])) {
+            *weightRe -= coeffsRe[t];
+            *weightIm -= coeffsIm[t];
+        } else {
+            *weightRe += coeffsRe[t];
+            *weightIm += coeffsIm[t];
+        }
+    }
+}
+
+/** Computes the real component of sum_i conj(psi_{i ^ xMask}) w_i psi_i over the amplitudes 
+ * psi_i of this chunk, where w_i = sum_t coeffs_t (-1)^|i & zMasks_t|. This is the expected 
+ * value of the sum of numTerms Pauli products which share xMask, where each coefficient 
+ * includes its product's phase i^numY. Every term hence reuses the same amplitude pairs,
+ * read in a single pass. The amplitudes psi_{i ^ xMask} are read from pairStateVec, 
+ * which is either this chunk (when xMask targets only local qubits), or the chunk 
+ * differing from this one in the non-local bits of xMask.
+ */
+qreal statevec_calcExpecPauliMasksLocal(
+    Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms, 
+    ComplexArray pairStateVec
+) {
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum expecValParts[numThreadSums];
+    initThreadSums(expecValParts, numThreadSums);
+    CompensatedSum threadExpecVal;
+    
+    long long int index, pairIndex;
+    long long int numAmps = qureg.numAmpsPerChunk;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int localXMask = xMask & (numAmps - 1);
+    qreal *stateReal = qureg.stateVec.real;
+    qreal *stateImag = qureg.stateVec.imag;
+    qreal *pairReal = pairStateVec.real;
+    qreal *pairImag = pairStateVec.imag;
+    
+    qaccum ketRe, ketIm, braRe, braIm;
+    qreal weightRe, weightIm;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (stateReal,stateImag, pairReal,pairImag, numAmps,globalIndStart,localXMask, \
+                zMasks,coeffsRe,coeffsIm,numTerms, expecValParts) \
+    private   (index,pairIndex, ketRe,ketIm, braRe,braIm, weightRe,weightIm, threadExpecVal)
+# endif 
+    {
+        threadExpecVal = (CompensatedSum) {0, 0};
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0; index < numAmps; index++) {
+            
+            // the diagonal weight of this amplitude, accumulated from every term
+            getPauliMasksWeight(index + globalIndStart, zMasks, coeffsRe, coeffsIm, numTerms, &weightRe, &weightIm);
+            
+            pairIndex = index ^ localXMask;
+            ketRe = stateReal[index];
+            ketIm = stateImag[index];
+            braRe = pairReal[pairIndex];
+            braIm = pairImag[pairIndex];
+            
+            // real(weight conj(bra) ket)
+            addProductToCompensatedSum(&threadExpecVal, weightRe, braRe*ketRe + braIm*ketIm);
+            addProductToCompensatedSum(&threadExpecVal, -weightIm, braRe*ketIm - braIm*ketRe);
+        }
+        setThreadSum(expecValParts, threadExpecVal);
+    }
+    
+    return getThreadSumsValue(expecValParts, numThreadSums);
+}
+
+/** Computes the real component of sum_i w_i rho_{i, i ^ xMask} over the elements of this 
+ * chunk, where w_i = sum_t coeffs_t (-1)^|i & zMasks_t|. This is Trace(H rho) of the sum H
+ * of numTerms Pauli products which share xMask, where each coefficient includes its product's
+ * phase i^numY. Each column of rho contributes one element, so this needs no communication 
+ * when distributed.
+ */
+qreal densmatr_calcExpecPauliMasksLocal(
+    Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms
+) {
+    int numQubits = qureg.numQubitsRepresented;
+    long long int numAmps = qureg.numAmpsPerChunk;
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    
+    // this chunk contains whole columns, or a part of a single column
+    long long int firstCol = globalIndStart >> numQubits;
+    long long int numCols = numAmps >> numQubits;
+    if (numCols == 0)
+        numCols = 1;
+    
+    qreal* stateReal = qureg.stateVec.real;
+    qreal* stateImag = qureg.stateVec.imag;
+    
+    int numThreadSums = getNumThreadSums();
+    CompensatedSum expecValParts[numThreadSums];
+    initThreadSums(expecValParts, numThreadSums);
+    CompensatedSum threadExpecVal;
+    
+    long long int col, row, index;
+    qreal weightRe, weightIm;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    shared    (stateReal,stateImag, numQubits,numAmps,globalIndStart,firstCol,numCols, \
+                xMask,zMasks,coeffsRe,coeffsIm,numTerms, expecValParts) \
+    private   (col,row,index, weightRe,weightIm, threadExpecVal)
+# endif 
+    {
+        threadExpecVal = (CompensatedSum) {0, 0};
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (col=firstCol; col < firstCol + numCols; col++) {
+            row = col ^ xMask;
+            index = row + (col << numQubits) - globalIndStart;
+            if (index < 0 || index >= numAmps)
+                continue;
+            
+            // the diagonal weight of this row, accumulated from every term
+            getPauliMasksWeight(row, zMasks, coeffsRe, coeffsIm, numTerms, &weightRe, &weightIm);
+            
+            // real(weight rho)
+            addProductToCompensatedSum(&threadExpecVal, weightRe, stateReal[index]);
+            addProductToCompensatedSum(&threadExpecVal, -weightIm, stateImag[index]);
+        }
+        setThreadSum(expecValParts, threadExpecVal);
+    }
+    
+    return getThreadSumsValue(expecValParts, numThreadSums);
+}
+
+/** Adds the sum of numTerms Pauli products which share xMask (where each coefficient includes 
+ * its product's phase i^numY) upon the input state to outQureg, i.e. 
+ * out_i += w_{i ^ xMask} psi_{i ^ xMask}, where w_j = sum_t coeffs_t (-1)^|j & zMasks_t|.
+ * The input amplitudes psi_{i ^ xMask} are read from inStateVec, which is either the input 
+ * register's chunk (when xMask targets only local qubits), or the chunk differing from it 
+ * in the non-local bits of xMask. Each output amplitude is written by one thread, and the 
+ * input is unmodified.
+ */
+void statevec_applyPauliMasksLocal(
+    Qureg outQureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms,
+    ComplexArray inStateVec
+) {
+    long long int index, inIndex;
+    long long int numAmps = outQureg.numAmpsPerChunk;
+    long long int globalIndStart = outQureg.chunkId*outQureg.numAmpsPerChunk;
+    long long int localXMask = xMask & (numAmps - 1);
+    qreal *outReal = outQureg.stateVec.real;
+    qreal *outImag = outQureg.stateVec.imag;
+    qreal *inReal = inStateVec.real;
+    qreal *inImag = inStateVec.imag;
+    
+    qreal ampRe, ampIm, weightRe, weightIm;
+    
+# ifdef _OPENMP
+# pragma omp parallel \
+    default  (none) \
+    shared   (outReal,outImag, inReal,inImag, numAmps,globalIndStart,localXMask,xMask, \
+                zMasks,coeffsRe,coeffsIm,numTerms) \
+    private  (index,inIndex, ampRe,ampIm, weightRe,weightIm)
+# endif 
+    {
+# ifdef _OPENMP
+# pragma omp for schedule  (static)
+# endif
+        for (index=0; index < numAmps; index++) {
+            
+            // the diagonal weight of the input amplitude, accumulated from every term
+            getPauliMasksWeight((index + globalIndStart) ^ xMask, zMasks, coeffsRe, coeffsIm, numTerms, &weightRe, &weightIm);
+            
+            inIndex = index ^ localXMask;
+            ampRe = inReal[inIndex];
+            ampIm = inImag[inIndex];
+            
+            // out += weight amp
+            outReal[index] += weightRe*ampRe - weightIm*ampIm;
+            outImag[index] += weightRe*ampIm + weightIm*ampRe;
+        }
+    }
+}
+
 void agnostic_setDiagonalOpElems(DiagonalOp op, long long int startInd, qreal* real, qreal* imag, long long int numElems) {
     
     // local start/end indices of the given amplitudes, assuming they fit in this chunk
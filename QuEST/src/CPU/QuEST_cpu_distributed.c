@@ -13,6 +13,7 @@
 # include "QuEST_internal.h"
 # include "QuEST_precision.h"
 # include "QuEST_validation.h"
+# include "QuEST_pool.h"
 # include "mt19937ar.h"
 
 # include "QuEST_cpu_internal.h"
@@ -61,24 +62,17 @@ qreal densmatr_calcTotalProb(Qureg qureg) {
 	long long int localIndNextDiag = globalIndNextDiag % qureg.numAmpsPerChunk;
 	long long int index;
 	
-	qreal rankTotal = 0;
-	qreal y, t, c;
-	c = 0;
+	CompensatedSum rankSum = {0, 0};
 	
-	// iterates every local diagonal
-	for (index=localIndNextDiag; index < qureg.numAmpsPerChunk; index += diagSpacing) {
-		
-		// Kahan summation - brackets are important
-		y = qureg.stateVec.real[index] - c;
-		t = rankTotal + y;
-		c = ( t - rankTotal ) - y;
-		rankTotal = t;
-	}
+	// iterates every local diagonal, with compensated summation
+	for (index=localIndNextDiag; index < qureg.numAmpsPerChunk; index += diagSpacing)
+		addToCompensatedSum(&rankSum, qureg.stateVec.real[index]);
 	
 	// combine each node's sum of diagonals
-	qreal globalTotal;
+	qaccum rankTotal = getCompensatedSumValue(rankSum);
+	qaccum globalTotal;
 	if (qureg.numChunks > 1)
-		MPI_Allreduce(&rankTotal, &globalTotal, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+		MPI_Allreduce(&rankTotal, &globalTotal, 1, MPI_QuEST_ACCUM, MPI_SUM, MPI_COMM_WORLD);
 	else
 		globalTotal = rankTotal;
 	
@@ -86,36 +80,92 @@ qreal densmatr_calcTotalProb(Qureg qureg) {
 }
 
 qreal statevec_calcTotalProb(Qureg qureg){
-    // Implemented using Kahan summation for greater accuracy at a slight floating
-    //   point operation overhead. For more details see https://en.wikipedia.org/wiki/Kahan_summation_algorithm
-    qreal pTotal=0; 
-    qreal y, t, c;
-    qreal allRankTotals=0;
-    long long int index;
-    long long int numAmpsPerRank = qureg.numAmpsPerChunk;
-    c = 0.0;
-    for (index=0; index<numAmpsPerRank; index++){ 
-        // Perform pTotal+=qureg.stateVec.real[index]*qureg.stateVec.real[index]; by Kahan
-        y = qureg.stateVec.real[index]*qureg.stateVec.real[index] - c;
-        t = pTotal + y;
-        // Don't change the bracketing on the following line
-        c = ( t - pTotal ) - y;
-        pTotal = t;
-        // Perform pTotal+=qureg.stateVec.imag[index]*qureg.stateVec.imag[index]; by Kahan
-        y = qureg.stateVec.imag[index]*qureg.stateVec.imag[index] - c;
-        t = pTotal + y;
-        // Don't change the bracketing on the following line
-        c = ( t - pTotal ) - y;
-        pTotal = t;
-    } 
+    
+    qaccum pTotal = statevec_calcTotalProbLocal(qureg);
+    qaccum allRankTotals=0;
     if (qureg.numChunks>1)
-		MPI_Allreduce(&pTotal, &allRankTotals, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+		MPI_Allreduce(&pTotal, &allRankTotals, 1, MPI_QuEST_ACCUM, MPI_SUM, MPI_COMM_WORLD);
     else 
 		allRankTotals=pTotal;
 
     return allRankTotals;
 }
 
+void statevec_calcProbOfAllOutcomes(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs) {
+    
+    statevec_calcProbOfAllOutcomesLocal(qureg, qubits, numQubits, outcomeProbs);
+    if (qureg.numChunks == 1)
+        return;
+    
+    // multiple messages are required as MPI uses int rather than long long int for count
+    long long int numOutcomes = 1LL << numQubits;
+    for (long long int offset=0; offset < numOutcomes; offset += MPI_MAX_AMPS_IN_MSG) {
+        long long int count = (numOutcomes - offset < MPI_MAX_AMPS_IN_MSG)? numOutcomes - offset : MPI_MAX_AMPS_IN_MSG;
+        MPI_Allreduce(MPI_IN_PLACE, &outcomeProbs[offset], (int) count, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    }
+}
+
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+    
+    // every node learns the cumulative probability at the start of every chunk
+    qaccum rankProb = statevec_calcSampledProbLocal(qureg);
+    qaccum* allRankProbs = malloc(qureg.numChunks * sizeof *allRankProbs);
+    validateMemoryAllocation(allRankProbs != NULL, __func__);
+    MPI_Allgather(&rankProb, 1, MPI_QuEST_ACCUM, allRankProbs, 1, MPI_QuEST_ACCUM, MPI_COMM_WORLD);
+    
+    qaccum probOffset = 0;
+    qaccum probEnd = 0;
+    qaccum totalProb = 0;
+    for (int r=0; r < qureg.numChunks; r++) {
+        if (r == qureg.chunkId)
+            probOffset = totalProb;
+        totalProb += allRankProbs[r];
+        if (r == qureg.chunkId)
+            probEnd = totalProb;
+    }
+    free(allRankProbs);
+    
+    // each shot falls within exactly one chunk, which alone sets its outcome
+    for (int s=0; s < numShots; s++)
+        outcomes[s] = 0;
+    statevec_sampleOutcomesLocal(qureg, qubits, numQubits, numShots, probOffset, probEnd, totalProb, outcomes);
+    MPI_Allreduce(MPI_IN_PLACE, outcomes, numShots, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+}
+
+int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env, int* isComplete) {
+    
+    *isComplete = 0;
+    long long int fileSize = statevec_getStateFileSizeLocal(filename);
+    if (!syncQuESTSuccess(fileSize >= 0))
+        return 0;
+    
+    // the file is divided into an equal number of segments per node, and every node counts 
+    // the lines of only its own segments (one per thread of the most-threaded node)
+    int numSegsPerRank = getNumThreadSums();
+    MPI_Allreduce(MPI_IN_PLACE, &numSegsPerRank, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    int numSegs = numSegsPerRank * env.numRanks;
+    long long int segSize = fileSize/numSegs + 1;
+    long long int* numAmpLines = malloc(numSegs * sizeof *numAmpLines);
+    long long int* firstLineStarts = malloc(numSegs * sizeof *firstLineStarts);
+    validateMemoryAllocation(numAmpLines && firstLineStarts, __func__);
+    
+    int success = statevec_countStateFileLinesLocal(
+        filename, fileSize, segSize, env.rank * numSegsPerRank, numSegsPerRank, 
+        &numAmpLines[env.rank * numSegsPerRank], &firstLineStarts[env.rank * numSegsPerRank]);
+    
+    // every node learns the line counts of all segments, to locate its first amplitude
+    MPI_Allgather(MPI_IN_PLACE, numSegsPerRank, MPI_LONG_LONG, numAmpLines, numSegsPerRank, MPI_LONG_LONG, MPI_COMM_WORLD);
+    MPI_Allgather(MPI_IN_PLACE, numSegsPerRank, MPI_LONG_LONG, firstLineStarts, numSegsPerRank, MPI_LONG_LONG, MPI_COMM_WORLD);
+    
+    if (syncQuESTSuccess(success))
+        success = statevec_parseStateFileLinesLocal(
+            *qureg, filename, fileSize, segSize, numSegs, numAmpLines, firstLineStarts);
+    *isComplete = syncQuESTSuccess(success);
+    
+    free(numAmpLines);
+    free(firstLineStarts);
+    return 1;
+}
 
 static int isChunkToSkipInFindPZero(int chunkId, long long int chunkSize, int measureQubit);
 static int chunkIsUpper(int chunkId, long long int chunkSize, int targetQubit);
@@ -153,6 +203,7 @@ QuESTEnv createQuESTEnv(void) {
 	}
     
     validateNumRanks(env.numRanks, __func__);
+    pool_setup(&env);
     
 	seedQuESTDefault();
     
@@ -170,6 +221,8 @@ int syncQuESTSuccess(int successCode){
 }
 
 void destroyQuESTEnv(QuESTEnv env){
+    pool_free(env);
+    
     int finalized;
     MPI_Finalized(&finalized);
     if (!finalized) MPI_Finalize();
@@ -841,6 +894,88 @@ void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal
 
 }
 
+/** Returns how many of the row and column qubits of the targets are non-local, and sets 
+ * pairQubit to the last such qubit (else to -1). When at most one is non-local, each block of 
+ * elements differing in those qubits spans at most this chunk and its pair, as required by the 
+ * densmatr_applyMultiQubit*Local kernels
+ */
+static int getDensityMatrixPairQubit(Qureg qureg, int* targets, int numTargets, int* pairQubit) {
+    
+    int numQb = qureg.numQubitsRepresented;
+    int numNonLocal = 0;
+    *pairQubit = -1;
+    for (int t=0; t < numTargets; t++) {
+        if (!halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targets[t])) {
+            *pairQubit = targets[t];
+            numNonLocal++;
+        }
+        if (!halfMatrixBlockFitsInChunk(qureg.numAmpsPerChunk, targets[t] + numQb)) {
+            *pairQubit = targets[t] + numQb;
+            numNonLocal++;
+        }
+    }
+    return numNonLocal;
+}
+
+/** loads the amplitudes of the chunk differing from this one in pairQubit into pairStateVec */
+static void exchangeDensityMatrixPairChunk(Qureg qureg, int pairQubit) {
+    
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    int pairRank = flipBit(globalIndStart, pairQubit) / qureg.numAmpsPerChunk;
+    exchangeStateVectors(qureg, pairRank);
+}
+
+/** The map is applied to each block of elements differing in the row and column bits of the 
+ * targets. When at most one of these qubits is non-local, a block spans at most this chunk and 
+ * its pair, which are exchanged directly. Otherwise the superoperator is applied as a unitary
+ * upon the doubled register, which swaps the non-local qubits into the chunk.
+ */
+void densmatr_applyMultiQubitKrausSuperoperator(Qureg qureg, int* targets, int numTargets, ComplexMatrixN superOp) {
+    
+    int pairQubit;
+    int numNonLocal = getDensityMatrixPairQubit(qureg, targets, numTargets, &pairQubit);
+    
+    if (numNonLocal > 1) {
+        int numQb = qureg.numQubitsRepresented;
+        int allTargets[2*numTargets];
+        for (int t=0; t < numTargets; t++) {
+            allTargets[t] = targets[t];
+            allTargets[t + numTargets] = targets[t] + numQb;
+        }
+        statevec_multiControlledMultiQubitUnitary(qureg, 0, allTargets, 2*numTargets, superOp);
+        return;
+    }
+    
+    if (numNonLocal == 1)
+        exchangeDensityMatrixPairChunk(qureg, pairQubit);
+    densmatr_applyMultiQubitKrausSuperoperatorLocal(qureg, targets, numTargets, superOp, pairQubit, qureg.pairStateVec);
+}
+
+/** As for the Kraus map, U rho U^dagger is effected in one pass when at most one of the targets' 
+ * row and column qubits is non-local. Otherwise U and U^* are applied in turn, each swapping 
+ * its non-local qubits into the chunk.
+ */
+void densmatr_applyMultiQubitUnitary(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u) {
+    
+    int pairQubit;
+    int numNonLocal = getDensityMatrixPairQubit(qureg, targets, numTargets, &pairQubit);
+    
+    if (numNonLocal > 1) {
+        int shift = qureg.numQubitsRepresented;
+        statevec_multiQubitUnitary(qureg, targets, numTargets, u);
+        shiftIndices(targets, numTargets, shift);
+        setConjugateMatrixN(u);
+        statevec_multiQubitUnitary(qureg, targets, numTargets, u);
+        shiftIndices(targets, numTargets, -shift);
+        setConjugateMatrixN(u);
+        return;
+    }
+    
+    if (numNonLocal == 1)
+        exchangeDensityMatrixPairChunk(qureg, pairQubit);
+    densmatr_applyMultiQubitUnitaryLocal(qureg, targets, numTargets, u, pairQubit, qureg.pairStateVec);
+}
+
 void statevec_compactUnitary(Qureg qureg, int targetQubit, Complex alpha, Complex beta)
 {
     // flag to require memory exchange. 1: an entire block fits on one rank, 0: at most half a block fits on one rank
@@ -1369,6 +1504,27 @@ void statevec_swapQubitAmps(Qureg qureg, int qb1, int qb2) {
     statevec_swapQubitAmpsDistributed(qureg, pairRank, qb1, qb2);
 }
 
+void statevec_multiControlledMultiQubitNot(Qureg qureg, long long int ctrlMask, long long int targMask) {
+    
+    // perform locally if possible
+    long long int localMask = qureg.numAmpsPerChunk - 1;
+    if (!(targMask & ~localMask))
+        return statevec_multiControlledMultiQubitNotLocal(qureg, ctrlMask, targMask);
+    
+    // do nothing if this node contains no amplitudes satisfying the controls (nor does its pair)
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    long long int globalCtrlMask = ctrlMask & ~localMask;
+    if ((globalIndStart & globalCtrlMask) != globalCtrlMask)
+        return;
+    
+    // this chunk's amplitudes are swapped with those of the chunk differing in the non-local targets
+    int pairRank = (globalIndStart ^ (targMask & ~localMask)) / qureg.numAmpsPerChunk;
+    exchangeStateVectors(qureg, pairRank);
+    statevec_multiControlledMultiQubitNotDistributed(qureg, ctrlMask, targMask,
+            qureg.pairStateVec, // in
+            qureg.stateVec); // out
+}
+
 /** This calls swapQubitAmps only when it would involve a distributed communication;
  * if the qubit chunks already fit in the node, it operates the unitary direct.
  * Note the order of q1 and q2 in the call to twoQubitUnitaryLocal is important.
@@ -1478,6 +1634,15 @@ void statevec_multiControlledMultiQubitUnitary(Qureg qureg, long long int ctrlMa
             statevec_swapQubitAmps(qureg, targs[t], swapTargs[t]);
 }
 
+/** It is validated in the front-end that a block of 2^numBlockQubits amplitudes fits 
+ * within a node, so every block (and hence every unitary targeting only block qubits) 
+ * is local, and no communication is needed.
+ */
+void statevec_multiQubitUnitarySequence(Qureg qureg, int numBlockQubits, ComplexMatrixN* us, int* targs, int numUnitaries) {
+    
+    statevec_multiQubitUnitarySequenceLocal(qureg, numBlockQubits, us, targs, numUnitaries);
+}
+
 
 void copyDiagOpIntoMatrixPairState(Qureg qureg, DiagonalOp op) {
         
@@ -1555,4 +1720,66 @@ Complex densmatr_calcExpecDiagonalOp(Qureg qureg, DiagonalOp op) {
     globalVal.real = globalRe;
     globalVal.imag = globalIm;
     return globalVal;
-}
\ No newline at end of file
+}
+
+qreal statevec_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms) {
+    
+    // obtain the amplitudes of the chunk differing from this one in the non-local X or Y targets
+    long long int localMask = qureg.numAmpsPerChunk - 1;
+    ComplexArray pairStateVec = qureg.stateVec;
+    if (xMask & ~localMask) {
+        long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+        int pairRank = (globalIndStart ^ (xMask & ~localMask)) / qureg.numAmpsPerChunk;
+        exchangeStateVectors(qureg, pairRank);
+        pairStateVec = qureg.pairStateVec;
+    }
+    
+    qreal localVal = statevec_calcExpecPauliMasksLocal(qureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms, pairStateVec);
+    if (qureg.numChunks == 1)
+        return localVal;
+    
+    qreal globalVal;
+    MPI_Allreduce(&localVal, &globalVal, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    return globalVal;
+}
+
+qreal densmatr_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms) {
+    
+    qreal localVal = densmatr_calcExpecPauliMasksLocal(qureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms);
+    if (qureg.numChunks == 1)
+        return localVal;
+    
+    qreal globalVal;
+    MPI_Allreduce(&localVal, &globalVal, 1, MPI_QuEST_REAL, MPI_SUM, MPI_COMM_WORLD);
+    return globalVal;
+}
+
+void statevec_applyPauliMasks(Qureg inQureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms, Qureg outQureg) {
+    
+    // obtain the input amplitudes of the chunk differing from this one in the non-local X or Y 
+    // targets, in the pair buffer of inQureg (leaving its state unmodified)
+    long long int localMask = inQureg.numAmpsPerChunk - 1;
+    ComplexArray inStateVec = inQureg.stateVec;
+    if (xMask & ~localMask) {
+        long long int globalIndStart = inQureg.chunkId*inQureg.numAmpsPerChunk;
+        int pairRank = (globalIndStart ^ (xMask & ~localMask)) / inQureg.numAmpsPerChunk;
+        exchangeStateVectors(inQureg, pairRank);
+        inStateVec = inQureg.pairStateVec;
+    }
+    
+    statevec_applyPauliMasksLocal(outQureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms, inStateVec);
+}
+
+void statevec_multiRotatePauliMasks(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac) {
+    
+    // perform locally if possible
+    long long int localMask = qureg.numAmpsPerChunk - 1;
+    if (!(xMask & ~localMask))
+        return statevec_multiRotatePauliMasksLocal(qureg, xMask, zMask, diagFac, offDiagFac);
+    
+    // each amplitude is paired with one in the chunk differing in the non-local X or Y targets
+    long long int globalIndStart = qureg.chunkId*qureg.numAmpsPerChunk;
+    int pairRank = (globalIndStart ^ (xMask & ~localMask)) / qureg.numAmpsPerChunk;
+    exchangeStateVectors(qureg, pairRank);
+    statevec_multiRotatePauliMasksDistributed(qureg, xMask, zMask, diagFac, offDiagFac, qureg.pairStateVec);
+}
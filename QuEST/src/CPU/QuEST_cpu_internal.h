@@ -14,6 +14,11 @@
 # define QUEST_CPU_INTERNAL_H
 
 # include "QuEST_precision.h"
+# include <float.h>
+
+# ifdef _OPENMP
+# include <omp.h>
+# endif
 
 
 /*
@@ -53,6 +58,110 @@ static inline long long int insertTwoZeroBits(const long long int number, const
 }
 
 
+/*
+ * Reductions over amplitudes accumulate each thread's part into a CompensatedSum, and the 
+ * threads' parts are combined in order of thread index, so that (for a fixed number of threads) 
+ * the result does not depend on the scheduling of threads.
+ *
+ * When built with QuEST_COMPENSATED_SUMS (the COMPENSATED_SUMS CMake option), these are 
+ * compensated sums, which accumulate terms and products in a "double-double" sum of twice 
+ * the precision of qaccum, using only qaccum arithmetic (and so remaining vectorisable). 
+ * Sums of signed products, which may cancel, add each product exactly, whereas sums of 
+ * non-negative terms (like probabilities) need only add each rounded term exactly. These rely 
+ * on the exact IEEE rounding of each operation, so must not be compiled with -ffast-math or 
+ * similar. Otherwise, the sums are ordinary qaccum sums, and lo remains zero.
+ */
+
+# ifndef QuEST_COMPENSATED_SUMS
+# define QuEST_COMPENSATED_SUMS 0
+# endif
+
+/** Splits a qaccum significand into halves, for Dekker's TwoProduct */
+# if QuEST_PREC==4
+    # define COMPENSATED_SPLITTER ((qaccum) (1ULL << ((LDBL_MANT_DIG + 1)/2)) + 1)
+# else
+    # define COMPENSATED_SPLITTER ((qaccum) (1ULL << ((DBL_MANT_DIG + 1)/2)) + 1)
+# endif
+
+/** A sum represented exactly as the unevaluated hi + lo, where |lo| <= ulp(hi)/2 */
+typedef struct {
+    qaccum hi;
+    qaccum lo;
+} CompensatedSum;
+
+/** Adds term to sum, where the rounding error of hi + term is found exactly by Knuth's TwoSum */
+static inline void addToCompensatedSum(CompensatedSum* sum, const qaccum term) {
+# if QuEST_COMPENSATED_SUMS
+    qaccum t = sum->hi + term;
+    qaccum z = t - sum->hi;
+    sum->lo += (sum->hi - (t - z)) + (term - z);
+    sum->hi = t;
+# else
+    sum->hi += term;
+# endif
+}
+
+/** Adds a*b to sum, where the rounding error of a*b is found exactly by Dekker's TwoProduct */
+static inline void addProductToCompensatedSum(CompensatedSum* sum, const qaccum a, const qaccum b) {
+# if QuEST_COMPENSATED_SUMS
+    qaccum p = a*b;
+    qaccum aSplit = COMPENSATED_SPLITTER*a;
+    qaccum bSplit = COMPENSATED_SPLITTER*b;
+    qaccum aHi = aSplit - (aSplit - a);
+    qaccum bHi = bSplit - (bSplit - b);
+    qaccum aLo = a - aHi;
+    qaccum bLo = b - bHi;
+    addToCompensatedSum(sum, p);
+    sum->lo += ((aHi*bHi - p) + aHi*bLo + aLo*bHi) + aLo*bLo;
+# else
+    sum->hi += a*b;
+# endif
+}
+
+/** Adds the (e.g. another thread's) sum other to sum */
+static inline void combineCompensatedSums(CompensatedSum* sum, const CompensatedSum other) {
+    addToCompensatedSum(sum, other.hi);
+    sum->lo += other.lo;
+}
+
+static inline qaccum getCompensatedSumValue(const CompensatedSum sum) {
+    return sum.hi + sum.lo;
+}
+
+/** The number of per-thread sums a reduction must provide, one for every thread which may run it */
+static inline int getNumThreadSums(void) {
+# ifdef _OPENMP
+    return omp_get_max_threads();
+# else
+    return 1;
+# endif
+}
+
+/** Zeroes the per-thread sums of a reduction, before its parallel region */
+static inline void initThreadSums(CompensatedSum* threadSums, const int numThreadSums) {
+    for (int t=0; t < numThreadSums; t++)
+        threadSums[t] = (CompensatedSum) {0, 0};
+}
+
+/** Records the calling thread's part of a reduction in threadSums, at its thread index */
+static inline void setThreadSum(CompensatedSum* threadSums, const CompensatedSum threadSum) {
+# ifdef _OPENMP
+    threadSums[omp_get_thread_num()] = threadSum;
+# else
+    threadSums[0] = threadSum;
+# endif
+}
+
+/** Combines the numThreadSums per-thread sums in order of thread index. Threads which took no 
+ * part in the reduction must have left their sums zero */
+static inline qaccum getThreadSumsValue(const CompensatedSum* threadSums, const int numThreadSums) {
+    CompensatedSum sum = {0, 0};
+    for (int t=0; t < numThreadSums; t++)
+        combineCompensatedSums(&sum, threadSums[t]);
+    return getCompensatedSumValue(sum);
+}
+
+
 /*
  * density matrix operations
  */
@@ -91,6 +200,12 @@ void densmatr_applyDiagonalOpLocal(Qureg qureg, DiagonalOp op);
 
 Complex densmatr_calcExpecDiagonalOpLocal(Qureg qureg, DiagonalOp op);
 
+qreal densmatr_calcExpecPauliMasksLocal(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms);
+
+void densmatr_applyMultiQubitKrausSuperoperatorLocal(Qureg qureg, int* targets, int numTargets, ComplexMatrixN superOp, int pairQubit, ComplexArray pairStateVec);
+
+void densmatr_applyMultiQubitUnitaryLocal(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u, int pairQubit, ComplexArray pairStateVec);
+
 
 /*
  * state vector operations
@@ -178,6 +293,20 @@ qreal statevec_findProbabilityOfZeroLocal (Qureg qureg, int measureQubit);
 
 qreal statevec_findProbabilityOfZeroDistributed (Qureg qureg);
 
+qreal statevec_calcTotalProbLocal(Qureg qureg);
+
+qaccum statevec_calcSampledProbLocal(Qureg qureg);
+
+void statevec_calcProbOfAllOutcomesLocal(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs);
+
+void statevec_sampleOutcomesLocal(Qureg qureg, int* qubits, int numQubits, int numShots, qaccum probOffset, qaccum probEnd, qaccum totalProb, long long int* outcomes);
+
+long long int statevec_getStateFileSizeLocal(char* filename);
+
+int statevec_countStateFileLinesLocal(char* filename, long long int fileSize, long long int segSize, int firstSeg, int numSegs, long long int* numAmpLines, long long int* firstLineStarts);
+
+int statevec_parseStateFileLinesLocal(Qureg qureg, char* filename, long long int fileSize, long long int segSize, int numSegs, long long int* numAmpLines, long long int* firstLineStarts);
+
 void statevec_collapseToKnownProbOutcomeLocal(Qureg qureg, int measureQubit, int outcome, qreal totalProbability);
 
 void statevec_collapseToKnownProbOutcomeDistributedRenorm (Qureg qureg, int measureQubit, qreal totalProbability);
@@ -186,13 +315,27 @@ void statevec_collapseToOutcomeDistributedSetZero(Qureg qureg);
 
 void statevec_swapQubitAmpsLocal(Qureg qureg, int qb1, int qb2);
 
+void statevec_multiControlledMultiQubitNotLocal(Qureg qureg, long long int ctrlMask, long long int targMask);
+
+void statevec_multiControlledMultiQubitNotDistributed(Qureg qureg, long long int ctrlMask, long long int targMask, ComplexArray stateVecIn, ComplexArray stateVecOut);
+
 void statevec_swapQubitAmpsDistributed(Qureg qureg, int pairRank, int qb1, int qb2);
 
 void statevec_multiControlledTwoQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int q1, int q2, ComplexMatrix4 u);
 
 void statevec_multiControlledMultiQubitUnitaryLocal(Qureg qureg, long long int ctrlMask, int* targs, int numTargs, ComplexMatrixN u);
 
+void statevec_multiQubitUnitarySequenceLocal(Qureg qureg, int numBlockQubits, ComplexMatrixN* us, int* targs, int numUnitaries);
+
 Complex statevec_calcExpecDiagonalOpLocal(Qureg qureg, DiagonalOp op);
 
+qreal statevec_calcExpecPauliMasksLocal(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms, ComplexArray pairStateVec);
+
+void statevec_multiRotatePauliMasksLocal(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac);
+
+void statevec_multiRotatePauliMasksDistributed(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac, ComplexArray pairStateVec);
+
+void statevec_applyPauliMasksLocal(Qureg outQureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms, ComplexArray inStateVec);
+
 
 # endif // QUEST_CPU_INTERNAL_H
@@ -12,6 +12,8 @@
 # include "QuEST.h"
 # include "QuEST_internal.h"
 # include "QuEST_precision.h"
+# include "QuEST_validation.h"
+# include "QuEST_pool.h"
 # include "mt19937ar.h"
 
 # include "QuEST_cpu_internal.h"
@@ -54,6 +56,16 @@ void densmatr_mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal
     densmatr_mixTwoQubitDepolarisingLocal(qureg, qubit1, qubit2, delta, gamma);
 }
 
+void densmatr_applyMultiQubitKrausSuperoperator(Qureg qureg, int* targets, int numTargets, ComplexMatrixN superOp) {
+    
+    densmatr_applyMultiQubitKrausSuperoperatorLocal(qureg, targets, numTargets, superOp, -1, qureg.pairStateVec);
+}
+
+void densmatr_applyMultiQubitUnitary(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u) {
+    
+    densmatr_applyMultiQubitUnitaryLocal(qureg, targets, numTargets, u, -1, qureg.pairStateVec);
+}
+
 qreal densmatr_calcPurity(Qureg qureg) {
     
     return densmatr_calcPurityLocal(qureg);
@@ -117,55 +129,60 @@ Complex statevec_calcInnerProduct(Qureg bra, Qureg ket) {
 
 qreal densmatr_calcTotalProb(Qureg qureg) {
     
-    // computes the trace using Kahan summation
-    qreal pTotal=0;
-    qreal y, t, c;
-    c = 0;
+    // computes the trace using compensated summation
+    CompensatedSum pTotal = {0, 0};
     
     long long int numCols = 1LL << qureg.numQubitsRepresented;
     long long diagIndex;
     
     for (int col=0; col< numCols; col++) {
         diagIndex = col*(numCols + 1);
-        y = qureg.stateVec.real[diagIndex] - c;
-        t = pTotal + y;
-        c = ( t - pTotal ) - y; // brackets are important
-        pTotal = t;
+        addToCompensatedSum(&pTotal, qureg.stateVec.real[diagIndex]);
     }
     
     // does not check imaginary component, by design
         
-    return pTotal;
+    return getCompensatedSumValue(pTotal);
 }
 
 qreal statevec_calcTotalProb(Qureg qureg){
-    // implemented using Kahan summation for greater accuracy at a slight floating
-    // point operation overhead. For more details see https://en.wikipedia.org/wiki/Kahan_summation_algorithm
-    qreal pTotal=0; 
-    qreal y, t, c;
-    long long int index;
-    long long int numAmpsPerRank = qureg.numAmpsPerChunk;
-    c = 0.0;
-    for (index=0; index<numAmpsPerRank; index++){ 
-        // Perform pTotal+=qureg.stateVec.real[index]*qureg.stateVec.real[index]; by Kahan
-
-        y = qureg.stateVec.real[index]*qureg.stateVec.real[index] - c;
-        t = pTotal + y;
-        // Don't change the bracketing on the following line
-        c = ( t - pTotal ) - y;
-        pTotal = t;
-
-        // Perform pTotal+=qureg.stateVec.imag[index]*qureg.stateVec.imag[index]; by Kahan
-
-        y = qureg.stateVec.imag[index]*qureg.stateVec.imag[index] - c;
-        t = pTotal + y;
-        // Don't change the bracketing on the following line
-        c = ( t - pTotal ) - y;
-        pTotal = t;
-    } 
-    return pTotal;
+    
+    return statevec_calcTotalProbLocal(qureg);
+}
+
+void statevec_calcProbOfAllOutcomes(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs) {
+    
+    statevec_calcProbOfAllOutcomesLocal(qureg, qubits, numQubits, outcomeProbs);
 }
 
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+    
+    qaccum totalProb = statevec_calcSampledProbLocal(qureg);
+    statevec_sampleOutcomesLocal(qureg, qubits, numQubits, numShots, 0, totalProb, totalProb, outcomes);
+}
+
+int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env, int* isComplete) {
+    
+    *isComplete = 0;
+    long long int fileSize = statevec_getStateFileSizeLocal(filename);
+    if (fileSize < 0)
+        return 0;
+    
+    // one segment of the file per thread
+    int numSegs = getNumThreadSums();
+    long long int segSize = fileSize/numSegs + 1;
+    long long int* numAmpLines = malloc(numSegs * sizeof *numAmpLines);
+    long long int* firstLineStarts = malloc(numSegs * sizeof *firstLineStarts);
+    validateMemoryAllocation(numAmpLines && firstLineStarts, __func__);
+    
+    *isComplete = (
+        statevec_countStateFileLinesLocal(filename, fileSize, segSize, 0, numSegs, numAmpLines, firstLineStarts) &&
+        statevec_parseStateFileLinesLocal(*qureg, filename, fileSize, segSize, numSegs, numAmpLines, firstLineStarts));
+    
+    free(numAmpLines);
+    free(firstLineStarts);
+    return 1;
+}
 
 QuESTEnv createQuESTEnv(void) {
     // init MPI environment
@@ -173,6 +190,7 @@ QuESTEnv createQuESTEnv(void) {
     QuESTEnv env;
     env.rank=0;
     env.numRanks=1;
+    pool_setup(&env);
     
     seedQuESTDefault();
     
@@ -188,6 +206,7 @@ int syncQuESTSuccess(int successCode){
 }
 
 void destroyQuESTEnv(QuESTEnv env){
+    pool_free(env);
     // MPI finalize goes here in MPI version. Call this function anyway for consistency
 }
 
@@ -317,6 +336,16 @@ void statevec_multiControlledMultiQubitUnitary(Qureg qureg, long long int ctrlMa
     statevec_multiControlledMultiQubitUnitaryLocal(qureg, ctrlMask, targs, numTargs, u);
 }
 
+void statevec_multiQubitUnitarySequence(Qureg qureg, int numBlockQubits, ComplexMatrixN* us, int* targs, int numUnitaries)
+{
+    statevec_multiQubitUnitarySequenceLocal(qureg, numBlockQubits, us, targs, numUnitaries);
+}
+
+void statevec_multiControlledMultiQubitNot(Qureg qureg, long long int ctrlMask, long long int targMask)
+{
+    statevec_multiControlledMultiQubitNotLocal(qureg, ctrlMask, targMask);
+}
+
 void statevec_swapQubitAmps(Qureg qureg, int qb1, int qb2) 
 {
     statevec_swapQubitAmpsLocal(qureg, qb1, qb2);
@@ -346,3 +375,23 @@ Complex densmatr_calcExpecDiagonalOp(Qureg qureg, DiagonalOp op) {
     
     return densmatr_calcExpecDiagonalOpLocal(qureg, op);
 }
+
+qreal statevec_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms) {
+    
+    return statevec_calcExpecPauliMasksLocal(qureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms, qureg.stateVec);
+}
+
+qreal densmatr_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms) {
+    
+    return densmatr_calcExpecPauliMasksLocal(qureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms);
+}
+
+void statevec_multiRotatePauliMasks(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac) {
+    
+    statevec_multiRotatePauliMasksLocal(qureg, xMask, zMask, diagFac, offDiagFac);
+}
+
+void statevec_applyPauliMasks(Qureg inQureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms, Qureg outQureg) {
+    
+    statevec_applyPauliMasksLocal(outQureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms, inQureg.stateVec);
+}
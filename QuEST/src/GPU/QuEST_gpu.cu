@@ -10,6 +10,9 @@
 # include "QuEST.h"
 # include "QuEST_precision.h"
 # include "QuEST_internal.h"    // purely to resolve getQuESTDefaultSeedKey
+# include "QuEST_validation.h"
+# include "QuEST_pool.h"
+# include "QuEST_fusion.h"
 # include "mt19937ar.h"
 
 # include <stdlib.h>
@@ -272,7 +275,7 @@ void densmatr_initClassicalState(Qureg qureg, long long int stateInd)
         qureg.deviceStateVec.imag, densityInd);
 }
 
-void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
+void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env, enum memoryPolicy policy)
 {   
     // allocate CPU memory
     long long int numAmps = 1L << numQubits;
@@ -302,6 +305,7 @@ void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env)
     qureg->chunkId = env.rank;
     qureg->numChunks = env.numRanks;
     qureg->isDensityMatrix = 0;
+    qureg->memPolicy = policy; // recorded for clones, but host memory is only a staging buffer
 
     // allocate GPU memory
     cudaMalloc(&(qureg->deviceStateVec.real), qureg->numAmpsPerChunk*sizeof(*(qureg->deviceStateVec.real)));
@@ -414,6 +418,7 @@ QuESTEnv createQuESTEnv(void) {
     QuESTEnv env;
     env.rank=0;
     env.numRanks=1;
+    pool_setup(&env);
     
     seedQuESTDefault();
     
@@ -429,6 +434,7 @@ int syncQuESTSuccess(int successCode){
 }
 
 void destroyQuESTEnv(QuESTEnv env){
+    pool_free(env);
     // MPI finalize goes here in MPI version. Call this function anyway for consistency
 }
 
@@ -450,6 +456,7 @@ void getEnvironmentString(QuESTEnv env, Qureg qureg, char str[200]){
 
 void copyStateToGPU(Qureg qureg)
 {
+    fusion_flush(qureg);
     if (DEBUG) printf("Copying data to GPU\n");
     cudaMemcpy(qureg.deviceStateVec.real, qureg.stateVec.real, 
             qureg.numAmpsPerChunk*sizeof(*(qureg.deviceStateVec.real)), cudaMemcpyHostToDevice);
@@ -460,6 +467,7 @@ void copyStateToGPU(Qureg qureg)
 
 void copyStateFromGPU(Qureg qureg)
 {
+    fusion_flush(qureg);
     cudaDeviceSynchronize();
     if (DEBUG) printf("Copying data from GPU\n");
     cudaMemcpy(qureg.stateVec.real, qureg.deviceStateVec.real, 
@@ -655,8 +663,8 @@ void statevec_initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome)
     statevec_initStateOfSingleQubitKernel<<<CUDABlocks, threadsPerCUDABlock>>>(qureg->numAmpsPerChunk, qureg->deviceStateVec.real, qureg->deviceStateVec.imag, qubitId, outcome);
 }
 
-// returns 1 if successful, else 0
-int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env){
+// returns 1 if the file was opened, else 0
+int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env, int* isComplete){
     long long int chunkSize, stateVecSize;
     long long int indexInChunk, totalIndex;
 
@@ -669,23 +677,25 @@ int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv
     FILE *fp;
     char line[200];
 
+    *isComplete = 0;
     fp = fopen(filename, "r");
     if (fp == NULL)
         return 0;
     
+    int isParsed = 1;
     indexInChunk = 0; totalIndex = 0;
     while (fgets(line, sizeof(char)*200, fp) != NULL && totalIndex<stateVecSize){
         if (line[0]!='#'){
             int chunkId = totalIndex/chunkSize;
             if (chunkId==qureg->chunkId){
                 # if QuEST_PREC==1
-                    sscanf(line, "%f, %f", &(stateVecReal[indexInChunk]),
+                    isParsed = isParsed && 2 == sscanf(line, "%f, %f", &(stateVecReal[indexInChunk]),
                             &(stateVecImag[indexInChunk]));
                 # elif QuEST_PREC==2
-                    sscanf(line, "%lf, %lf", &(stateVecReal[indexInChunk]),
+                    isParsed = isParsed && 2 == sscanf(line, "%lf, %lf", &(stateVecReal[indexInChunk]),
                             &(stateVecImag[indexInChunk]));
                 # elif QuEST_PREC==4
-                    sscanf(line, "%lf, %lf", &(stateVecReal[indexInChunk]),
+                    isParsed = isParsed && 2 == sscanf(line, "%lf, %lf", &(stateVecReal[indexInChunk]),
                             &(stateVecImag[indexInChunk]));
                 # endif
                 indexInChunk += 1;
@@ -695,6 +705,7 @@ int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv
     }
     fclose(fp);
     copyStateToGPU(*qureg);
+    *isComplete = isParsed && totalIndex == stateVecSize;
     
     // indicate success
     return 1;
@@ -1025,6 +1036,248 @@ void statevec_multiControlledMultiQubitUnitary(Qureg qureg, long long int ctrlMa
     cudaFree(d_imAmps);
 }
 
+void statevec_multiQubitUnitarySequence(Qureg qureg, int numBlockQubits, ComplexMatrixN* us, int* targs, int numUnitaries)
+{
+    // CPU cache blocking doesn't apply to the GPU, so each unitary is applied in turn
+    for (int n=0; n < numUnitaries; n++) {
+        statevec_multiControlledMultiQubitUnitary(qureg, 0, targs, us[n].numQubits, us[n]);
+        targs += us[n].numQubits;
+    }
+}
+
+__global__ void densmatr_applyMultiQubitKrausSuperoperatorKernel(
+    Qureg qureg, int* blockQubits, int numBlockQubits, long long int* ampOffsets,
+    qreal* superOpRe, qreal* superOpIm, qreal* reAmps, qreal* imAmps, long long int numBlockAmps)
+{
+    // each thread modifies one block of elements differing in the targets' row and column bits
+    long long int thisTask = blockIdx.x*blockDim.x + threadIdx.x;
+    long long int numTasks = qureg.numAmpsPerChunk >> numBlockQubits;
+    if (thisTask>=numTasks) return;
+
+    long long int ind00 = insertZeroBits(thisTask, blockQubits, numBlockQubits);
+
+    qreal *reVec = qureg.deviceStateVec.real;
+    qreal *imVec = qureg.deviceStateVec.imag;
+
+    // each thread's block elements are recorded in shared arrays, with below stride and offset
+    size_t stride = gridDim.x*blockDim.x;
+    size_t offset = blockIdx.x*blockDim.x + threadIdx.x;
+
+    for (long long int c=0; c < numBlockAmps; c++) {
+        reAmps[c*stride+offset] = reVec[ind00 + ampOffsets[c]];
+        imAmps[c*stride+offset] = imVec[ind00 + ampOffsets[c]];
+    }
+
+    for (long long int r=0; r < numBlockAmps; r++) {
+        qreal reSum = 0;
+        qreal imSum = 0;
+        for (long long int c=0; c < numBlockAmps; c++) {
+            qreal reElem = superOpRe[c + r*numBlockAmps];
+            qreal imElem = superOpIm[c + r*numBlockAmps];
+            reSum += reAmps[c*stride+offset]*reElem - imAmps[c*stride+offset]*imElem;
+            imSum += reAmps[c*stride+offset]*imElem + imAmps[c*stride+offset]*reElem;
+        }
+        reVec[ind00 + ampOffsets[r]] = reSum;
+        imVec[ind00 + ampOffsets[r]] = imSum;
+    }
+}
+
+void densmatr_applyMultiQubitKrausSuperoperator(Qureg qureg, int* targets, int numTargets, ComplexMatrixN superOp)
+{
+    int numQb = qureg.numQubitsRepresented;
+    int numBlockQubits = 2*numTargets;
+    long long int numBlockAmps = 1LL << numBlockQubits;
+
+    // the row and column qubits of the targets, and the offset of each block element from the first
+    int* blockQubits = (int*) malloc(numBlockQubits * sizeof *blockQubits);
+    long long int* ampOffsets = (long long int*) malloc(numBlockAmps * sizeof *ampOffsets);
+    for (int t=0; t < numTargets; t++) {
+        blockQubits[t] = targets[t];
+        blockQubits[t + numTargets] = targets[t] + numQb;
+    }
+    for (long long int i=0; i < numBlockAmps; i++) {
+        ampOffsets[i] = 0;
+        for (int t=0; t < numBlockQubits; t++)
+            if ((i >> t) & 1)
+                ampOffsets[i] |= 1LL << blockQubits[t];
+    }
+
+    // flatten out the superOp.real and superOp.imag lists
+    qreal* superOpReFlat = (qreal*) malloc(numBlockAmps*numBlockAmps * sizeof *superOpReFlat);
+    qreal* superOpImFlat = (qreal*) malloc(numBlockAmps*numBlockAmps * sizeof *superOpImFlat);
+    long long int i = 0;
+    for (long long int r=0; r < numBlockAmps; r++)
+        for (long long int c=0; c < numBlockAmps; c++) {
+            superOpReFlat[i] = superOp.real[r][c];
+            superOpImFlat[i] = superOp.imag[r][c];
+            i++;
+        }
+
+    int *d_blockQubits;
+    long long int *d_ampOffsets;
+    qreal *d_superOpRe, *d_superOpIm;
+    size_t superOpMemSize = numBlockAmps*numBlockAmps * sizeof *d_superOpRe;
+    cudaMalloc(&d_blockQubits, numBlockQubits * sizeof *d_blockQubits);
+    cudaMalloc(&d_ampOffsets, numBlockAmps * sizeof *d_ampOffsets);
+    cudaMalloc(&d_superOpRe, superOpMemSize);
+    cudaMalloc(&d_superOpIm, superOpMemSize);
+    cudaMemcpy(d_blockQubits, blockQubits, numBlockQubits * sizeof *d_blockQubits, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ampOffsets, ampOffsets, numBlockAmps * sizeof *d_ampOffsets, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_superOpRe, superOpReFlat, superOpMemSize, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_superOpIm, superOpImFlat, superOpMemSize, cudaMemcpyHostToDevice);
+
+    // allocate device space for thread-local block elements
+    int threadsPerCUDABlock = 128;
+    int CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk>>numBlockQubits)/threadsPerCUDABlock);
+    size_t gridSize = (size_t) threadsPerCUDABlock * CUDABlocks;
+    qreal *d_reAmps, *d_imAmps;
+    cudaMalloc(&d_reAmps, numBlockAmps*gridSize * sizeof *d_reAmps);
+    cudaMalloc(&d_imAmps, numBlockAmps*gridSize * sizeof *d_imAmps);
+
+    densmatr_applyMultiQubitKrausSuperoperatorKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+        qureg, d_blockQubits, numBlockQubits, d_ampOffsets,
+        d_superOpRe, d_superOpIm, d_reAmps, d_imAmps, numBlockAmps);
+
+    free(blockQubits);
+    free(ampOffsets);
+    free(superOpReFlat);
+    free(superOpImFlat);
+    cudaFree(d_blockQubits);
+    cudaFree(d_ampOffsets);
+    cudaFree(d_superOpRe);
+    cudaFree(d_superOpIm);
+    cudaFree(d_reAmps);
+    cudaFree(d_imAmps);
+}
+
+__global__ void densmatr_applyMultiQubitUnitaryKernel(
+    Qureg qureg, int* blockQubits, int numBlockQubits, long long int* ampOffsets,
+    qreal* uRe, qreal* uIm, qreal* reAmps, qreal* imAmps, qreal* reProd, qreal* imProd, long long int dim)
+{
+    // each thread modifies one block of elements differing in the targets' row and column bits
+    long long int thisTask = blockIdx.x*blockDim.x + threadIdx.x;
+    long long int numTasks = qureg.numAmpsPerChunk >> numBlockQubits;
+    if (thisTask>=numTasks) return;
+
+    long long int ind00 = insertZeroBits(thisTask, blockQubits, numBlockQubits);
+
+    qreal *reVec = qureg.deviceStateVec.real;
+    qreal *imVec = qureg.deviceStateVec.imag;
+
+    // each thread's block B, and U B, are recorded in shared arrays, with below stride and offset
+    size_t stride = gridDim.x*blockDim.x;
+    size_t offset = blockIdx.x*blockDim.x + threadIdx.x;
+
+    // B[r][c] is element r + c*dim of the block
+    for (long long int i=0; i < dim*dim; i++) {
+        reAmps[i*stride+offset] = reVec[ind00 + ampOffsets[i]];
+        imAmps[i*stride+offset] = imVec[ind00 + ampOffsets[i]];
+    }
+
+    // (U B)[r][c] = sum_k U[r][k] B[k][c]
+    for (long long int c=0; c < dim; c++) {
+        for (long long int r=0; r < dim; r++) {
+            qreal reSum = 0;
+            qreal imSum = 0;
+            for (long long int k=0; k < dim; k++) {
+                long long int i = (k + c*dim)*stride+offset;
+                reSum += uRe[r*dim + k]*reAmps[i] - uIm[r*dim + k]*imAmps[i];
+                imSum += uRe[r*dim + k]*imAmps[i] + uIm[r*dim + k]*reAmps[i];
+            }
+            reProd[(r + c*dim)*stride+offset] = reSum;
+            imProd[(r + c*dim)*stride+offset] = imSum;
+        }
+    }
+
+    // (U B U^dagger)[r][c] = sum_k (U B)[r][k] conj(U[c][k])
+    for (long long int c=0; c < dim; c++) {
+        for (long long int r=0; r < dim; r++) {
+            qreal reSum = 0;
+            qreal imSum = 0;
+            for (long long int k=0; k < dim; k++) {
+                long long int i = (r + k*dim)*stride+offset;
+                reSum += reProd[i]*uRe[c*dim + k] + imProd[i]*uIm[c*dim + k];
+                imSum += imProd[i]*uRe[c*dim + k] - reProd[i]*uIm[c*dim + k];
+            }
+            reVec[ind00 + ampOffsets[r + c*dim]] = reSum;
+            imVec[ind00 + ampOffsets[r + c*dim]] = imSum;
+        }
+    }
+}
+
+void densmatr_applyMultiQubitUnitary(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u)
+{
+    int numQb = qureg.numQubitsRepresented;
+    int numBlockQubits = 2*numTargets;
+    long long int dim = 1LL << numTargets;
+    long long int numBlockAmps = dim*dim;
+
+    // the row and column qubits of the targets, and the offset of each block element from the first
+    int* blockQubits = (int*) malloc(numBlockQubits * sizeof *blockQubits);
+    long long int* ampOffsets = (long long int*) malloc(numBlockAmps * sizeof *ampOffsets);
+    for (int t=0; t < numTargets; t++) {
+        blockQubits[t] = targets[t];
+        blockQubits[t + numTargets] = targets[t] + numQb;
+    }
+    for (long long int i=0; i < numBlockAmps; i++) {
+        ampOffsets[i] = 0;
+        for (int t=0; t < numBlockQubits; t++)
+            if ((i >> t) & 1)
+                ampOffsets[i] |= 1LL << blockQubits[t];
+    }
+
+    // flatten out the u.real and u.imag lists
+    qreal* uReFlat = (qreal*) malloc(numBlockAmps * sizeof *uReFlat);
+    qreal* uImFlat = (qreal*) malloc(numBlockAmps * sizeof *uImFlat);
+    long long int i = 0;
+    for (long long int r=0; r < dim; r++)
+        for (long long int c=0; c < dim; c++) {
+            uReFlat[i] = u.real[r][c];
+            uImFlat[i] = u.imag[r][c];
+            i++;
+        }
+
+    int *d_blockQubits;
+    long long int *d_ampOffsets;
+    qreal *d_uRe, *d_uIm;
+    size_t uMemSize = numBlockAmps * sizeof *d_uRe;
+    cudaMalloc(&d_blockQubits, numBlockQubits * sizeof *d_blockQubits);
+    cudaMalloc(&d_ampOffsets, numBlockAmps * sizeof *d_ampOffsets);
+    cudaMalloc(&d_uRe, uMemSize);
+    cudaMalloc(&d_uIm, uMemSize);
+    cudaMemcpy(d_blockQubits, blockQubits, numBlockQubits * sizeof *d_blockQubits, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_ampOffsets, ampOffsets, numBlockAmps * sizeof *d_ampOffsets, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_uRe, uReFlat, uMemSize, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_uIm, uImFlat, uMemSize, cudaMemcpyHostToDevice);
+
+    // allocate device space for thread-local block elements and their products with U
+    int threadsPerCUDABlock = 128;
+    int CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk>>numBlockQubits)/threadsPerCUDABlock);
+    size_t gridSize = (size_t) threadsPerCUDABlock * CUDABlocks;
+    qreal *d_reAmps, *d_imAmps, *d_reProd, *d_imProd;
+    cudaMalloc(&d_reAmps, numBlockAmps*gridSize * sizeof *d_reAmps);
+    cudaMalloc(&d_imAmps, numBlockAmps*gridSize * sizeof *d_imAmps);
+    cudaMalloc(&d_reProd, numBlockAmps*gridSize * sizeof *d_reProd);
+    cudaMalloc(&d_imProd, numBlockAmps*gridSize * sizeof *d_imProd);
+
+    densmatr_applyMultiQubitUnitaryKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+        qureg, d_blockQubits, numBlockQubits, d_ampOffsets,
+        d_uRe, d_uIm, d_reAmps, d_imAmps, d_reProd, d_imProd, dim);
+
+    free(blockQubits);
+    free(ampOffsets);
+    free(uReFlat);
+    free(uImFlat);
+    cudaFree(d_blockQubits);
+    cudaFree(d_ampOffsets);
+    cudaFree(d_uRe);
+    cudaFree(d_uIm);
+    cudaFree(d_reAmps);
+    cudaFree(d_imAmps);
+    cudaFree(d_reProd);
+    cudaFree(d_imProd);
+}
+
 __global__ void statevec_multiControlledTwoQubitUnitaryKernel(Qureg qureg, long long int ctrlMask, int q1, int q2, ArgMatrix4 u){
     
     // decide the 4 amplitudes this thread will modify
@@ -1297,6 +1550,42 @@ void statevec_pauliX(Qureg qureg, int targetQubit)
     statevec_pauliXKernel<<<CUDABlocks, threadsPerCUDABlock>>>(qureg, targetQubit);
 }
 
+__global__ void statevec_multiControlledMultiQubitNotKernel(Qureg qureg, long long int ctrlMask, long long int targMask, int highTarg) {
+    
+    long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int index = blockIdx.x*blockDim.x + threadIdx.x;
+    if (index>=stateVecSize) return;
+    
+    // each pair is swapped once, by the thread of the amp with the highest target 0
+    if ((index & ctrlMask) != ctrlMask || extractBit(highTarg, index))
+        return;
+    
+    qreal *stateVecReal = qureg.deviceStateVec.real;
+    qreal *stateVecImag = qureg.deviceStateVec.imag;
+    
+    long long int indexLo = index ^ targMask;
+    qreal stateRealUp = stateVecReal[index];
+    qreal stateImagUp = stateVecImag[index];
+    
+    stateVecReal[index] = stateVecReal[indexLo];
+    stateVecImag[index] = stateVecImag[indexLo];
+    
+    stateVecReal[indexLo] = stateRealUp;
+    stateVecImag[indexLo] = stateImagUp;
+}
+
+void statevec_multiControlledMultiQubitNot(Qureg qureg, long long int ctrlMask, long long int targMask)
+{
+    int highTarg = 0;
+    while (targMask >> (highTarg+1))
+        highTarg++;
+    
+    int threadsPerCUDABlock, CUDABlocks;
+    threadsPerCUDABlock = 128;
+    CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk)/threadsPerCUDABlock);
+    statevec_multiControlledMultiQubitNotKernel<<<CUDABlocks, threadsPerCUDABlock>>>(qureg, ctrlMask, targMask, highTarg);
+}
+
 __global__ void statevec_pauliYKernel(Qureg qureg, int targetQubit, int conjFac){
 
     long long int sizeHalfBlock = 1LL << targetQubit;
@@ -1528,6 +1817,103 @@ void statevec_multiRotateZ(Qureg qureg, long long int mask, qreal angle)
     statevec_multiRotateZKernel<<<CUDABlocks, threadsPerCUDABlock>>>(qureg, mask, cosAngle, sinAngle);
 }
 
+__global__ void statevec_multiRotatePauliMasksKernel(
+    Qureg qureg, int pairBit, long long int xMask, long long int zMask, qreal diagFac, qreal offRe, qreal offIm
+) {
+    long long int numTasks = qureg.numAmpsPerChunk >> 1;
+    long long int thisTask = blockIdx.x*blockDim.x + threadIdx.x;
+    if (thisTask>=numTasks) return;
+    
+    qreal *stateVecReal = qureg.deviceStateVec.real;
+    qreal *stateVecImag = qureg.deviceStateVec.imag;
+    
+    long long int indexLo = insertZeroBit(thisTask, pairBit);
+    long long int indexHi = indexLo ^ xMask;
+    int signLo = getBitMaskParity(indexLo & zMask)? -1 : 1;
+    int signHi = getBitMaskParity(indexHi & zMask)? -1 : 1;
+    
+    qreal stateRealLo = stateVecReal[indexLo];
+    qreal stateImagLo = stateVecImag[indexLo];
+    qreal stateRealHi = stateVecReal[indexHi];
+    qreal stateImagHi = stateVecImag[indexHi];
+    
+    stateVecReal[indexLo] = diagFac*stateRealLo + signHi*(offRe*stateRealHi - offIm*stateImagHi);
+    stateVecImag[indexLo] = diagFac*stateImagLo + signHi*(offRe*stateImagHi + offIm*stateRealHi);
+    stateVecReal[indexHi] = diagFac*stateRealHi + signLo*(offRe*stateRealLo - offIm*stateImagLo);
+    stateVecImag[indexHi] = diagFac*stateImagHi + signLo*(offRe*stateImagLo + offIm*stateRealLo);
+}
+
+void statevec_multiRotatePauliMasks(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac) {
+    
+    // each pair is visited once, by the index with the highest bit of xMask as zero
+    int pairBit = 0;
+    while (xMask >> (pairBit + 1))
+        pairBit++;
+    
+    int threadsPerCUDABlock, CUDABlocks;
+    threadsPerCUDABlock = 128;
+    CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk>>1)/threadsPerCUDABlock);
+    statevec_multiRotatePauliMasksKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+        qureg, pairBit, xMask, zMask, diagFac, offDiagFac.real, offDiagFac.imag);
+}
+
+__global__ void statevec_applyDiagonalPhasesKernel(
+    Qureg qureg, 
+    long long int* phaseMasks, qreal* phaseAngles, int numPhaseTerms, 
+    long long int* parityMasks, qreal* parityAngles, int numParityTerms
+) {
+    long long int stateVecSize = qureg.numAmpsPerChunk;
+    long long int index = blockIdx.x*blockDim.x + threadIdx.x;
+    if (index>=stateVecSize) return;
+    
+    qreal *stateVecReal = qureg.deviceStateVec.real;
+    qreal *stateVecImag = qureg.deviceStateVec.imag;
+    
+    // accumulate the total phase of this basis state from every term
+    qreal angle = 0;
+    for (int t=0; t < numPhaseTerms; t++)
+        if ((index & phaseMasks[t]) == phaseMasks[t])
+            angle += phaseAngles[t];
+    for (int t=0; t < numParityTerms; t++)
+        angle += (getBitMaskParity(index & parityMasks[t]))? 
+            parityAngles[t]/2 : - parityAngles[t]/2;
+    
+    qreal cosAngle = cos(angle);
+    qreal sinAngle = sin(angle);
+    qreal stateReal = stateVecReal[index];
+    qreal stateImag = stateVecImag[index];
+    stateVecReal[index] = cosAngle*stateReal - sinAngle*stateImag;
+    stateVecImag[index] = sinAngle*stateReal + cosAngle*stateImag;
+}
+
+void statevec_applyDiagonalPhases(Qureg qureg, 
+    long long int* phaseMasks, qreal* phaseAngles, int numPhaseTerms, 
+    long long int* parityMasks, qreal* parityAngles, int numParityTerms)
+{
+    // copy the terms to the device (cudaMalloc of zero bytes is valid)
+    long long int *d_phaseMasks, *d_parityMasks;
+    qreal *d_phaseAngles, *d_parityAngles;
+    cudaMalloc(&d_phaseMasks,   numPhaseTerms  * sizeof *d_phaseMasks);
+    cudaMalloc(&d_phaseAngles,  numPhaseTerms  * sizeof *d_phaseAngles);
+    cudaMalloc(&d_parityMasks,  numParityTerms * sizeof *d_parityMasks);
+    cudaMalloc(&d_parityAngles, numParityTerms * sizeof *d_parityAngles);
+    cudaMemcpy(d_phaseMasks,   phaseMasks,   numPhaseTerms  * sizeof *d_phaseMasks,   cudaMemcpyHostToDevice);
+    cudaMemcpy(d_phaseAngles,  phaseAngles,  numPhaseTerms  * sizeof *d_phaseAngles,  cudaMemcpyHostToDevice);
+    cudaMemcpy(d_parityMasks,  parityMasks,  numParityTerms * sizeof *d_parityMasks,  cudaMemcpyHostToDevice);
+    cudaMemcpy(d_parityAngles, parityAngles, numParityTerms * sizeof *d_parityAngles, cudaMemcpyHostToDevice);
+    
+    int threadsPerCUDABlock, CUDABlocks;
+    threadsPerCUDABlock = 128;
+    CUDABlocks = ceil((qreal)(qureg.numAmpsPerChunk)/threadsPerCUDABlock);
+    statevec_applyDiagonalPhasesKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+        qureg, d_phaseMasks, d_phaseAngles, numPhaseTerms, d_parityMasks, d_parityAngles, numParityTerms);
+    
+    cudaFree(d_phaseMasks);
+    cudaFree(d_phaseAngles);
+    cudaFree(d_parityMasks);
+    cudaFree(d_parityAngles);
+}
+
 qreal densmatr_calcTotalProb(Qureg qureg) {
     
     // computes the trace using Kahan summation
@@ -1583,6 +1969,81 @@ qreal statevec_calcTotalProb(Qureg qureg){
     return pTotal;
 }
 
+void statevec_calcProbOfAllOutcomes(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs) {
+    
+    // the probabilities are swept on the host; every amplitude, or every diagonal element
+    copyStateFromGPU(qureg);
+    long long int spacing = (qureg.isDensityMatrix)? 1LL + (1LL << qureg.numQubitsRepresented) : 1;
+    long long int numBasis = (qureg.isDensityMatrix)? 1LL << qureg.numQubitsRepresented : qureg.numAmpsPerChunk;
+    qreal* re = qureg.stateVec.real;
+    qreal* im = qureg.stateVec.imag;
+    
+    qaccum* probs = (qaccum*) calloc(1LL << numQubits, sizeof *probs);
+    validateMemoryAllocation(probs != NULL, __func__);
+    for (long long int basis=0; basis < numBasis; basis++) {
+        long long int outcome = 0;
+        for (int q=0; q < numQubits; q++)
+            outcome |= ((basis >> qubits[q]) & 1LL) << q;
+        probs[outcome] += (qureg.isDensityMatrix)? re[basis*spacing] : (qaccum) re[basis]*re[basis] + (qaccum) im[basis]*im[basis];
+    }
+    for (long long int outcome=0; outcome < (1LL << numQubits); outcome++)
+        outcomeProbs[outcome] = probs[outcome];
+    
+    free(probs);
+}
+
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+    
+    // the probabilities are swept on the host; every amplitude, or every diagonal element
+    copyStateFromGPU(qureg);
+    long long int spacing = (qureg.isDensityMatrix)? 1LL + (1LL << qureg.numQubitsRepresented) : 1;
+    long long int numBasis = (qureg.isDensityMatrix)? 1LL << qureg.numQubitsRepresented : qureg.numAmpsPerChunk;
+    qreal* re = qureg.stateVec.real;
+    qreal* im = qureg.stateVec.imag;
+    
+    qaccum totalProb = 0;
+    for (long long int basis=0; basis < numBasis; basis++) {
+        qaccum prob = (qureg.isDensityMatrix)? re[basis*spacing] : (qaccum) re[basis]*re[basis] + (qaccum) im[basis]*im[basis];
+        if (prob > 0)
+            totalProb += prob;
+    }
+    
+    // the shots are sorted, so that all are assigned by a single sweep of the cumulative probability
+    SampledShot* shots = (SampledShot*) malloc(numShots * sizeof *shots);
+    validateMemoryAllocation(shots != NULL, __func__);
+    for (int s=0; s < numShots; s++) {
+        shots[s].prob = genrand_real2() * totalProb;
+        shots[s].index = s;
+    }
+    qsort(shots, numShots, sizeof *shots, compareSampledShots);
+    
+    qaccum cumProb = 0;
+    long long int lastBasis = 0;
+    int shot = 0;
+    for (long long int basis=0; basis < numBasis && shot < numShots; basis++) {
+        qaccum prob = (qureg.isDensityMatrix)? re[basis*spacing] : (qaccum) re[basis]*re[basis] + (qaccum) im[basis]*im[basis];
+        if (prob <= 0)
+            continue;
+        
+        cumProb += prob;
+        lastBasis = basis;
+        for (; shot < numShots && shots[shot].prob < cumProb; shot++) {
+            outcomes[shots[shot].index] = 0;
+            for (int q=0; q < numQubits; q++)
+                outcomes[shots[shot].index] |= ((basis >> qubits[q]) & 1LL) << q;
+        }
+    }
+    
+    // shots beyond the swept cumulative probability (by rounding) take the final outcome
+    for (; shot < numShots; shot++) {
+        outcomes[shots[shot].index] = 0;
+        for (int q=0; q < numQubits; q++)
+            outcomes[shots[shot].index] |= ((lastBasis >> qubits[q]) & 1LL) << q;
+    }
+    
+    free(shots);
+}
+
 __global__ void statevec_controlledPhaseFlipKernel(Qureg qureg, int idQubit1, int idQubit2)
 {
     long long int index;
@@ -3230,6 +3691,193 @@ Complex densmatr_calcExpecDiagonalOp(Qureg qureg, DiagonalOp op) {
     return expecVal;
 }
 
+/** the diagonal weight sum_t coeffs_t (-1)^|index & zMasks_t| of a group of Pauli products */
+__forceinline__ __device__ void getPauliMasksWeight(
+    long long int index, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms,
+    qreal* weightRe, qreal* weightIm
+) {
+    *weightRe = 0;
+    *weightIm = 0;
+    for (int t=0; t < numTerms; t++) {
+        if (getBitMaskParity(index & zMasks[t])) {
+            *weightRe -= coeffsRe[t];
+            *weightIm -= coeffsIm[t];
+        } else {
+            *weightRe += coeffsRe[t];
+            *weightIm += coeffsIm[t];
+        }
+    }
+}
+
+/** computes the real term of w_i conj(vec_{i ^ xMask}) vec_i */
+__global__ void statevec_calcExpecPauliMasksKernel(
+    qreal* vecReal, qreal* vecImag, long long int xMask, 
+    long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms,
+    long long int numTermsToSum, qreal* reducedArray) 
+{
+    long long int index = blockIdx.x*blockDim.x + threadIdx.x;
+    if (index >= numTermsToSum) return;
+    
+    qreal weightRe, weightIm;
+    getPauliMasksWeight(index, zMasks, coeffsRe, coeffsIm, numTerms, &weightRe, &weightIm);
+    
+    long long int pairIndex = index ^ xMask;
+    qreal braRe = vecReal[pairIndex];
+    qreal braIm = vecImag[pairIndex];
+    qreal ketRe = vecReal[index];
+    qreal ketIm = vecImag[index];
+    qreal expecVal = weightRe * (braRe*ketRe + braIm*ketIm) - weightIm * (braRe*ketIm - braIm*ketRe);
+    
+    // array of each thread's collected sum term, to be summed
+    extern __shared__ qreal tempReductionArray[];
+    tempReductionArray[threadIdx.x] = expecVal;
+    __syncthreads();
+    
+    // every second thread reduces
+    if (threadIdx.x<blockDim.x/2)
+        reduceBlock(tempReductionArray, reducedArray, blockDim.x);
+}
+
+/** computes the real term of w_i rho_{i, i ^ xMask}, one per column */
+__global__ void densmatr_calcExpecPauliMasksKernel(
+    qreal* matReal, qreal* matImag, long long int xMask, 
+    long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms,
+    int numQubits, long long int numTermsToSum, qreal* reducedArray) 
+{
+    long long int col = blockIdx.x*blockDim.x + threadIdx.x;
+    if (col >= numTermsToSum) return;
+    
+    long long int row = col ^ xMask;
+    long long int matInd = row + (col << numQubits);
+    
+    qreal weightRe, weightIm;
+    getPauliMasksWeight(row, zMasks, coeffsRe, coeffsIm, numTerms, &weightRe, &weightIm);
+    qreal expecVal = weightRe * matReal[matInd] - weightIm * matImag[matInd];
+    
+    // array of each thread's collected sum term, to be summed
+    extern __shared__ qreal tempReductionArray[];
+    tempReductionArray[threadIdx.x] = expecVal;
+    __syncthreads();
+    
+    // every second thread reduces
+    if (threadIdx.x<blockDim.x/2)
+        reduceBlock(tempReductionArray, reducedArray, blockDim.x);
+}
+
+/** sums the expected value of a group of Pauli products sharing xMask, using the kernels above */
+qreal calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms) {
+    
+    // copy the terms to the device
+    long long int *d_zMasks;
+    qreal *d_coeffsRe, *d_coeffsIm;
+    cudaMalloc(&d_zMasks,   numTerms * sizeof *d_zMasks);
+    cudaMalloc(&d_coeffsRe, numTerms * sizeof *d_coeffsRe);
+    cudaMalloc(&d_coeffsIm, numTerms * sizeof *d_coeffsIm);
+    cudaMemcpy(d_zMasks,   zMasks,   numTerms * sizeof *d_zMasks,   cudaMemcpyHostToDevice);
+    cudaMemcpy(d_coeffsRe, coeffsRe, numTerms * sizeof *d_coeffsRe, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_coeffsIm, coeffsIm, numTerms * sizeof *d_coeffsIm, cudaMemcpyHostToDevice);
+    
+    long long int numValuesToReduce = (qureg.isDensityMatrix)? 
+        (1LL << qureg.numQubitsRepresented) : qureg.numAmpsPerChunk;
+    int valuesPerCUDABlock, numCUDABlocks, sharedMemSize;
+    int maxReducedPerLevel = REDUCE_SHARED_SIZE;
+    int firstTime = 1;
+    
+    while (numValuesToReduce > 1) {
+        if (numValuesToReduce < maxReducedPerLevel) {
+            valuesPerCUDABlock = numValuesToReduce;
+            numCUDABlocks = 1;
+        }
+        else {
+            valuesPerCUDABlock = maxReducedPerLevel;
+            numCUDABlocks = ceil((qreal)numValuesToReduce/valuesPerCUDABlock);
+        }
+        sharedMemSize = valuesPerCUDABlock*sizeof(qreal);
+        if (firstTime) {
+            if (qureg.isDensityMatrix)
+                densmatr_calcExpecPauliMasksKernel<<<numCUDABlocks, valuesPerCUDABlock, sharedMemSize>>>(
+                    qureg.deviceStateVec.real, qureg.deviceStateVec.imag, xMask,
+                    d_zMasks, d_coeffsRe, d_coeffsIm, numTerms,
+                    qureg.numQubitsRepresented, numValuesToReduce, 
+                    qureg.firstLevelReduction);
+            else
+                statevec_calcExpecPauliMasksKernel<<<numCUDABlocks, valuesPerCUDABlock, sharedMemSize>>>(
+                    qureg.deviceStateVec.real, qureg.deviceStateVec.imag, xMask,
+                    d_zMasks, d_coeffsRe, d_coeffsIm, numTerms,
+                    numValuesToReduce, 
+                    qureg.firstLevelReduction);
+            firstTime = 0;
+        } else {
+            cudaDeviceSynchronize();    
+            copySharedReduceBlock<<<numCUDABlocks, valuesPerCUDABlock/2, sharedMemSize>>>(
+                    qureg.firstLevelReduction, 
+                    qureg.secondLevelReduction, valuesPerCUDABlock); 
+            cudaDeviceSynchronize();    
+            swapDouble(&(qureg.firstLevelReduction), &(qureg.secondLevelReduction));
+        }
+        numValuesToReduce = numValuesToReduce/maxReducedPerLevel;
+    }
+    
+    qreal expecVal;
+    cudaMemcpy(&expecVal, qureg.firstLevelReduction, sizeof(qreal), cudaMemcpyDeviceToHost);
+    
+    cudaFree(d_zMasks);
+    cudaFree(d_coeffsRe);
+    cudaFree(d_coeffsIm);
+    return expecVal;
+}
+
+qreal statevec_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms) {
+    
+    return calcExpecPauliMasks(qureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms);
+}
+
+qreal densmatr_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms) {
+    
+    return calcExpecPauliMasks(qureg, xMask, zMasks, coeffsRe, coeffsIm, numTerms);
+}
+
+/** out_i += w_{i ^ xMask} in_{i ^ xMask}, with each output amplitude written by one thread */
+__global__ void statevec_applyPauliMasksKernel(
+    Qureg inQureg, Qureg outQureg, long long int xMask, 
+    long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms
+) {
+    long long int index = blockIdx.x*blockDim.x + threadIdx.x;
+    if (index >= outQureg.numAmpsPerChunk) return;
+    
+    long long int inIndex = index ^ xMask;
+    qreal weightRe, weightIm;
+    getPauliMasksWeight(inIndex, zMasks, coeffsRe, coeffsIm, numTerms, &weightRe, &weightIm);
+    
+    qreal ampRe = inQureg.deviceStateVec.real[inIndex];
+    qreal ampIm = inQureg.deviceStateVec.imag[inIndex];
+    outQureg.deviceStateVec.real[index] += weightRe*ampRe - weightIm*ampIm;
+    outQureg.deviceStateVec.imag[index] += weightRe*ampIm + weightIm*ampRe;
+}
+
+void statevec_applyPauliMasks(Qureg inQureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms, Qureg outQureg) {
+    
+    // copy the terms to the device
+    long long int *d_zMasks;
+    qreal *d_coeffsRe, *d_coeffsIm;
+    cudaMalloc(&d_zMasks,   numTerms * sizeof *d_zMasks);
+    cudaMalloc(&d_coeffsRe, numTerms * sizeof *d_coeffsRe);
+    cudaMalloc(&d_coeffsIm, numTerms * sizeof *d_coeffsIm);
+    cudaMemcpy(d_zMasks,   zMasks,   numTerms * sizeof *d_zMasks,   cudaMemcpyHostToDevice);
+    cudaMemcpy(d_coeffsRe, coeffsRe, numTerms * sizeof *d_coeffsRe, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_coeffsIm, coeffsIm, numTerms * sizeof *d_coeffsIm, cudaMemcpyHostToDevice);
+    
+    int threadsPerCUDABlock, CUDABlocks;
+    threadsPerCUDABlock = 128;
+    CUDABlocks = ceil((qreal)(outQureg.numAmpsPerChunk)/threadsPerCUDABlock);
+    statevec_applyPauliMasksKernel<<<CUDABlocks, threadsPerCUDABlock>>>(
+        inQureg, outQureg, xMask, d_zMasks, d_coeffsRe, d_coeffsIm, numTerms);
+    
+    cudaFree(d_zMasks);
+    cudaFree(d_coeffsRe);
+    cudaFree(d_coeffsIm);
+}
+
 void agnostic_setDiagonalOpElems(DiagonalOp op, long long int startInd, qreal* real, qreal* imag, long long int numElems) {
 
     // update both RAM and VRAM, for consistency
@@ -20,6 +20,8 @@
 # include "QuEST_internal.h"
 # include "QuEST_validation.h"
 # include "QuEST_qasm.h"
+# include "QuEST_fusion.h"
+# include "QuEST_pool.h"
 
 # include <stdlib.h>
 # include <string.h>
@@ -33,16 +35,32 @@ extern "C" {
  * state-vector management
  */
 
-Qureg createQureg(int numQubits, QuESTEnv env) {
-    validateNumQubitsInQureg(numQubits, env.numRanks, __func__);
+/** Allocates a Qureg of the given dimensions, or recycles one from env's pool, with a
+ * QASM logger and fusion buffer but uninitialised amplitudes */
+static Qureg allocQureg(int numQubitsRepresented, int isDensityMatrix, QuESTEnv env, enum memoryPolicy policy) {
+    
+    int numQubitsInStateVec = (isDensityMatrix)? 2*numQubitsRepresented : numQubitsRepresented;
     
     Qureg qureg;
-    statevec_createQureg(&qureg, numQubits, env);
-    qureg.isDensityMatrix = 0;
-    qureg.numQubitsRepresented = numQubits;
-    qureg.numQubitsInStateVec = numQubits;
+    int isRecycled = pool_takeQureg(env, &qureg, numQubitsInStateVec, policy);
+    if (!isRecycled)
+        statevec_createQureg(&qureg, numQubitsInStateVec, env, policy);
+    qureg.isDensityMatrix = isDensityMatrix;
+    qureg.numQubitsRepresented = numQubitsRepresented;
+    qureg.numQubitsInStateVec = numQubitsInStateVec;
+    
+    if (isRecycled)
+        qasm_reset(&qureg);
+    else
+        qasm_setup(&qureg);
+    fusion_setup(&qureg);
+    return qureg;
+}
+
+Qureg createQureg(int numQubits, QuESTEnv env) {
+    validateNumQubitsInQureg(numQubits, env.numRanks, __func__);
     
-    qasm_setup(&qureg);
+    Qureg qureg = allocQureg(numQubits, 0, env, MEMORY_DEFAULT);
     initZeroState(qureg); // safe call to public function
     return qureg;
 }
@@ -50,35 +68,56 @@ Qureg createQureg(int numQubits, QuESTEnv env) {
 Qureg createDensityQureg(int numQubits, QuESTEnv env) {
     validateNumQubitsInQureg(2*numQubits, env.numRanks, __func__);
     
-    Qureg qureg;
-    statevec_createQureg(&qureg, 2*numQubits, env);
-    qureg.isDensityMatrix = 1;
-    qureg.numQubitsRepresented = numQubits;
-    qureg.numQubitsInStateVec = 2*numQubits;
+    Qureg qureg = allocQureg(numQubits, 1, env, MEMORY_DEFAULT);
+    initZeroState(qureg); // safe call to public function
+    return qureg;
+}
+
+Qureg createQuregWithPolicy(int numQubits, QuESTEnv env, enum memoryPolicy policy) {
+    validateNumQubitsInQureg(numQubits, env.numRanks, __func__);
+    validateMemoryPolicy(policy, __func__);
     
-    qasm_setup(&qureg);
+    Qureg qureg = allocQureg(numQubits, 0, env, policy);
+    initZeroState(qureg); // safe call to public function
+    return qureg;
+}
+
+Qureg createDensityQuregWithPolicy(int numQubits, QuESTEnv env, enum memoryPolicy policy) {
+    validateNumQubitsInQureg(2*numQubits, env.numRanks, __func__);
+    validateMemoryPolicy(policy, __func__);
+    
+    Qureg qureg = allocQureg(numQubits, 1, env, policy);
     initZeroState(qureg); // safe call to public function
     return qureg;
 }
 
 Qureg createCloneQureg(Qureg qureg, QuESTEnv env) {
+    fusion_flush(qureg);
 
-    Qureg newQureg;
-    statevec_createQureg(&newQureg, qureg.numQubitsInStateVec, env);
-    newQureg.isDensityMatrix = qureg.isDensityMatrix;
-    newQureg.numQubitsRepresented = qureg.numQubitsRepresented;
-    newQureg.numQubitsInStateVec = qureg.numQubitsInStateVec;
-    
-    qasm_setup(&newQureg);
+    Qureg newQureg = allocQureg(qureg.numQubitsRepresented, qureg.isDensityMatrix, env, qureg.memPolicy);
     statevec_cloneQureg(newQureg, qureg);
     return newQureg;
 }
 
 void destroyQureg(Qureg qureg, QuESTEnv env) {
+    fusion_free(qureg);
+    
+    // keep the amplitudes and QASM logger for reuse, if pooling
+    if (pool_giveQureg(env, qureg))
+        return;
+    
     statevec_destroyQureg(qureg, env);
     qasm_free(qureg);
 }
 
+void startQuregPool(QuESTEnv env) {
+    pool_start(env);
+}
+
+void stopQuregPool(QuESTEnv env) {
+    pool_stop(env);
+}
+
 
 /*
  * QASM
@@ -106,23 +145,48 @@ void writeRecordedQASMToFile(Qureg qureg, char* filename) {
 }
 
 
+/*
+ * gate fusion
+ */
+
+void startGateFusion(Qureg qureg, int maxNumQubits) {
+    validateNumFusedQubits(qureg, maxNumQubits, __func__);
+    
+    fusion_start(qureg, maxNumQubits, 0);
+}
+
+void startBlockedGateFusion(Qureg qureg, int maxNumQubits, int numBlockQubits) {
+    validateNumFusedQubits(qureg, maxNumQubits, __func__);
+    validateNumFusionBlockQubits(qureg, maxNumQubits, numBlockQubits, __func__);
+    
+    fusion_start(qureg, maxNumQubits, numBlockQubits);
+}
+
+void stopGateFusion(Qureg qureg) {
+    fusion_stop(qureg);
+}
+
+
 /*
  * state initialisation
  */
 
 void initZeroState(Qureg qureg) {
+    fusion_discard(qureg);
     statevec_initZeroState(qureg); // valid for both statevec and density matrices
     
     qasm_recordInitZero(qureg);
 }
 
 void initBlankState(Qureg qureg) {
+    fusion_discard(qureg);
     statevec_initBlankState(qureg);
     
     qasm_recordComment(qureg, "Here, the register was initialised to an unphysical all-zero-amplitudes 'state'.");
 }
 
 void initPlusState(Qureg qureg) {
+    fusion_discard(qureg);
     if (qureg.isDensityMatrix)
         densmatr_initPlusState(qureg);
     else
@@ -134,6 +198,8 @@ void initPlusState(Qureg qureg) {
 void initClassicalState(Qureg qureg, long long int stateInd) {
     validateStateIndex(qureg, stateInd, __func__);
     
+    fusion_discard(qureg);
+    
     if (qureg.isDensityMatrix)
         densmatr_initClassicalState(qureg, stateInd);
     else
@@ -146,6 +212,9 @@ void initPureState(Qureg qureg, Qureg pure) {
     validateSecondQuregStateVec(pure, __func__);
     validateMatchingQuregDims(qureg, pure, __func__);
 
+    fusion_discard(qureg);
+    fusion_flush(pure);
+    
     if (qureg.isDensityMatrix)
         densmatr_initPureState(qureg, pure);
     else
@@ -157,6 +226,8 @@ void initPureState(Qureg qureg, Qureg pure) {
 void initStateFromAmps(Qureg qureg, qreal* reals, qreal* imags) {
     validateStateVecQureg(qureg, __func__);
     
+    fusion_discard(qureg);
+    
     statevec_setAmps(qureg, 0, reals, imags, qureg.numAmpsTotal);
     
     qasm_recordComment(qureg, "Here, the register was initialised to an undisclosed given pure state.");
@@ -166,6 +237,9 @@ void cloneQureg(Qureg targetQureg, Qureg copyQureg) {
     validateMatchingQuregTypes(targetQureg, copyQureg, __func__);
     validateMatchingQuregDims(targetQureg, copyQureg, __func__);
     
+    fusion_discard(targetQureg);
+    fusion_flush(copyQureg);
+    
     statevec_cloneQureg(targetQureg, copyQureg);
 }
 
@@ -177,9 +251,11 @@ void cloneQureg(Qureg targetQureg, Qureg copyQureg) {
 void hadamard(Qureg qureg, int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_hadamard(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_hadamard(qureg, targetQubit+qureg.numQubitsRepresented);
+    if (!fusion_addGate(qureg, GATE_HADAMARD, NULL, 0, targetQubit, 0)) {
+        if (qureg.isDensityMatrix)
+            densmatr_hadamard(qureg, targetQubit);
+        else
+            statevec_hadamard(qureg, targetQubit);
     }
     
     qasm_recordGate(qureg, GATE_HADAMARD, targetQubit);
@@ -188,9 +264,11 @@ void hadamard(Qureg qureg, int targetQubit) {
 void rotateX(Qureg qureg, int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_rotateX(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_rotateX(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
+    if (!fusion_addGate(qureg, GATE_ROTATE_X, NULL, 0, targetQubit, angle)) {
+        if (qureg.isDensityMatrix)
+            densmatr_rotateX(qureg, targetQubit, angle);
+        else
+            statevec_rotateX(qureg, targetQubit, angle);
     }
     
     qasm_recordParamGate(qureg, GATE_ROTATE_X, targetQubit, angle);
@@ -199,9 +277,11 @@ void rotateX(Qureg qureg, int targetQubit, qreal angle) {
 void rotateY(Qureg qureg, int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_rotateY(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_rotateY(qureg, targetQubit+qureg.numQubitsRepresented, angle);
+    if (!fusion_addGate(qureg, GATE_ROTATE_Y, NULL, 0, targetQubit, angle)) {
+        if (qureg.isDensityMatrix)
+            densmatr_rotateY(qureg, targetQubit, angle);
+        else
+            statevec_rotateY(qureg, targetQubit, angle);
     }
     
     qasm_recordParamGate(qureg, GATE_ROTATE_Y, targetQubit, angle);
@@ -210,9 +290,11 @@ void rotateY(Qureg qureg, int targetQubit, qreal angle) {
 void rotateZ(Qureg qureg, int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_rotateZ(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_rotateZ(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
+    if (!fusion_addGate(qureg, GATE_ROTATE_Z, NULL, 0, targetQubit, angle)) {
+        statevec_rotateZ(qureg, targetQubit, angle);
+        if (qureg.isDensityMatrix) {
+            statevec_rotateZ(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
+        }
     }
     
     qasm_recordParamGate(qureg, GATE_ROTATE_Z, targetQubit, angle);
@@ -221,10 +303,12 @@ void rotateZ(Qureg qureg, int targetQubit, qreal angle) {
 void controlledRotateX(Qureg qureg, int controlQubit, int targetQubit, qreal angle) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     
-    statevec_controlledRotateX(qureg, controlQubit, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateX(qureg, controlQubit+shift, targetQubit+shift, -angle);
+    if (!fusion_addGate(qureg, GATE_ROTATE_X, (int[]) {controlQubit}, 1, targetQubit, angle)) {
+        statevec_controlledRotateX(qureg, controlQubit, targetQubit, angle);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledRotateX(qureg, controlQubit+shift, targetQubit+shift, -angle);
+        }
     }
     
     qasm_recordControlledParamGate(qureg, GATE_ROTATE_X, controlQubit, targetQubit, angle);
@@ -233,10 +317,12 @@ void controlledRotateX(Qureg qureg, int controlQubit, int targetQubit, qreal ang
 void controlledRotateY(Qureg qureg, int controlQubit, int targetQubit, qreal angle) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     
-    statevec_controlledRotateY(qureg, controlQubit, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateY(qureg, controlQubit+shift, targetQubit+shift, angle); // rotateY is real
+    if (!fusion_addGate(qureg, GATE_ROTATE_Y, (int[]) {controlQubit}, 1, targetQubit, angle)) {
+        statevec_controlledRotateY(qureg, controlQubit, targetQubit, angle);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledRotateY(qureg, controlQubit+shift, targetQubit+shift, angle); // rotateY is real
+        }
     }
 
     qasm_recordControlledParamGate(qureg, GATE_ROTATE_Y, controlQubit, targetQubit, angle);
@@ -245,10 +331,12 @@ void controlledRotateY(Qureg qureg, int controlQubit, int targetQubit, qreal ang
 void controlledRotateZ(Qureg qureg, int controlQubit, int targetQubit, qreal angle) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     
-    statevec_controlledRotateZ(qureg, controlQubit, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateZ(qureg, controlQubit+shift, targetQubit+shift, -angle);
+    if (!fusion_addGate(qureg, GATE_ROTATE_Z, (int[]) {controlQubit}, 1, targetQubit, angle)) {
+        statevec_controlledRotateZ(qureg, controlQubit, targetQubit, angle);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledRotateZ(qureg, controlQubit+shift, targetQubit+shift, -angle);
+        }
     }
     
     qasm_recordControlledParamGate(qureg, GATE_ROTATE_Z, controlQubit, targetQubit, angle);
@@ -258,10 +346,11 @@ void twoQubitUnitary(Qureg qureg, int targetQubit1, int targetQubit2, ComplexMat
     validateMultiTargets(qureg, (int []) {targetQubit1, targetQubit2}, 2, __func__);
     validateTwoQubitUnitaryMatrix(qureg, u, __func__);
     
-    statevec_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_twoQubitUnitary(qureg, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
+    if (!fusion_addTwoQubitUnitary(qureg, NULL, 0, targetQubit1, targetQubit2, u)) {
+        if (qureg.isDensityMatrix)
+            densmatr_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
+        else
+            statevec_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
     }
     
     qasm_recordComment(qureg, "Here, an undisclosed 2-qubit unitary was applied.");
@@ -271,10 +360,12 @@ void controlledTwoQubitUnitary(Qureg qureg, int controlQubit, int targetQubit1,
     validateMultiControlsMultiTargets(qureg, (int[]) {controlQubit}, 1, (int[]) {targetQubit1, targetQubit2}, 2, __func__);
     validateTwoQubitUnitaryMatrix(qureg, u, __func__);
     
-    statevec_controlledTwoQubitUnitary(qureg, controlQubit, targetQubit1, targetQubit2, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledTwoQubitUnitary(qureg, controlQubit+shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
+    if (!fusion_addTwoQubitUnitary(qureg, (int[]) {controlQubit}, 1, targetQubit1, targetQubit2, u)) {
+        statevec_controlledTwoQubitUnitary(qureg, controlQubit, targetQubit1, targetQubit2, u);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledTwoQubitUnitary(qureg, controlQubit+shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
+        }
     }
 
     qasm_recordComment(qureg, "Here, an undisclosed controlled 2-qubit unitary was applied.");
@@ -284,11 +375,13 @@ void multiControlledTwoQubitUnitary(Qureg qureg, int* controlQubits, int numCont
     validateMultiControlsMultiTargets(qureg, controlQubits, numControlQubits, (int[]) {targetQubit1, targetQubit2}, 2, __func__);
     validateTwoQubitUnitaryMatrix(qureg, u, __func__);
     
-    long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
-    statevec_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask, targetQubit1, targetQubit2, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask<<shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
+    if (!fusion_addTwoQubitUnitary(qureg, controlQubits, numControlQubits, targetQubit1, targetQubit2, u)) {
+        long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
+        statevec_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask, targetQubit1, targetQubit2, u);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_multiControlledTwoQubitUnitary(qureg, ctrlQubitsMask<<shift, targetQubit1+shift, targetQubit2+shift, getConjugateMatrix4(u));
+        }
     }
     
     qasm_recordComment(qureg, "Here, an undisclosed multi-controlled 2-qubit unitary was applied.");
@@ -298,14 +391,11 @@ void multiQubitUnitary(Qureg qureg, int* targs, int numTargs, ComplexMatrixN u)
     validateMultiTargets(qureg, targs, numTargs, __func__);
     validateMultiQubitUnitaryMatrix(qureg, u, numTargs, __func__);
     
-    statevec_multiQubitUnitary(qureg, targs, numTargs, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        shiftIndices(targs, numTargs, shift);
-        setConjugateMatrixN(u);
-        statevec_multiQubitUnitary(qureg, targs, numTargs, u);
-        shiftIndices(targs, numTargs, -shift);
-        setConjugateMatrixN(u);
+    if (!fusion_addMultiQubitUnitary(qureg, NULL, 0, targs, numTargs, u)) {
+        if (qureg.isDensityMatrix)
+            densmatr_multiQubitUnitary(qureg, targs, numTargs, u);
+        else
+            statevec_multiQubitUnitary(qureg, targs, numTargs, u);
     }
     
     qasm_recordComment(qureg, "Here, an undisclosed multi-qubit unitary was applied.");
@@ -315,14 +405,16 @@ void controlledMultiQubitUnitary(Qureg qureg, int ctrl, int* targs, int numTargs
     validateMultiControlsMultiTargets(qureg, (int[]) {ctrl}, 1, targs, numTargs, __func__);
     validateMultiQubitUnitaryMatrix(qureg, u, numTargs, __func__);
     
-    statevec_controlledMultiQubitUnitary(qureg, ctrl, targs, numTargs, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        shiftIndices(targs, numTargs, shift);
-        setConjugateMatrixN(u);
-        statevec_controlledMultiQubitUnitary(qureg, ctrl+shift, targs, numTargs, u);
-        shiftIndices(targs, numTargs, -shift);
-        setConjugateMatrixN(u);
+    if (!fusion_addMultiQubitUnitary(qureg, (int[]) {ctrl}, 1, targs, numTargs, u)) {
+        statevec_controlledMultiQubitUnitary(qureg, ctrl, targs, numTargs, u);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            shiftIndices(targs, numTargs, shift);
+            setConjugateMatrixN(u);
+            statevec_controlledMultiQubitUnitary(qureg, ctrl+shift, targs, numTargs, u);
+            shiftIndices(targs, numTargs, -shift);
+            setConjugateMatrixN(u);
+        }
     }
     
     qasm_recordComment(qureg, "Here, an undisclosed controlled multi-qubit unitary was applied.");
@@ -332,15 +424,17 @@ void multiControlledMultiQubitUnitary(Qureg qureg, int* ctrls, int numCtrls, int
     validateMultiControlsMultiTargets(qureg, ctrls, numCtrls, targs, numTargs, __func__);
     validateMultiQubitUnitaryMatrix(qureg, u, numTargs, __func__);
     
-    long long int ctrlMask = getQubitBitMask(ctrls, numCtrls);
-    statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask, targs, numTargs, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        shiftIndices(targs, numTargs, shift);
-        setConjugateMatrixN(u);
-        statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask<<shift, targs, numTargs, u);
-        shiftIndices(targs, numTargs, -shift);
-        setConjugateMatrixN(u);
+    if (!fusion_addMultiQubitUnitary(qureg, ctrls, numCtrls, targs, numTargs, u)) {
+        long long int ctrlMask = getQubitBitMask(ctrls, numCtrls);
+        statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask, targs, numTargs, u);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            shiftIndices(targs, numTargs, shift);
+            setConjugateMatrixN(u);
+            statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask<<shift, targs, numTargs, u);
+            shiftIndices(targs, numTargs, -shift);
+            setConjugateMatrixN(u);
+        }
     }
     
     qasm_recordComment(qureg, "Here, an undisclosed multi-controlled multi-qubit unitary was applied.");
@@ -350,9 +444,11 @@ void unitary(Qureg qureg, int targetQubit, ComplexMatrix2 u) {
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_unitary(qureg, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        statevec_unitary(qureg, targetQubit+qureg.numQubitsRepresented, getConjugateMatrix2(u));
+    if (!fusion_addUnitary(qureg, NULL, 0, targetQubit, u)) {
+        if (qureg.isDensityMatrix)
+            densmatr_unitary(qureg, targetQubit, u);
+        else
+            statevec_unitary(qureg, targetQubit, u);
     }
     
     qasm_recordUnitary(qureg, u, targetQubit);
@@ -362,10 +458,12 @@ void controlledUnitary(Qureg qureg, int controlQubit, int targetQubit, ComplexMa
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    statevec_controlledUnitary(qureg, controlQubit, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledUnitary(qureg, controlQubit+shift, targetQubit+shift, getConjugateMatrix2(u));
+    if (!fusion_addUnitary(qureg, (int[]) {controlQubit}, 1, targetQubit, u)) {
+        statevec_controlledUnitary(qureg, controlQubit, targetQubit, u);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledUnitary(qureg, controlQubit+shift, targetQubit+shift, getConjugateMatrix2(u));
+        }
     }
     
     qasm_recordControlledUnitary(qureg, u, controlQubit, targetQubit);
@@ -375,12 +473,14 @@ void multiControlledUnitary(Qureg qureg, int* controlQubits, int numControlQubit
     validateMultiControlsTarget(qureg, controlQubits, numControlQubits, targetQubit, __func__);
     validateOneQubitUnitaryMatrix(u, __func__);
     
-    long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
-    long long int ctrlFlipMask = 0;
-    statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_multiControlledUnitary(qureg, ctrlQubitsMask<<shift, ctrlFlipMask<<shift, targetQubit+shift, getConjugateMatrix2(u));
+    if (!fusion_addUnitary(qureg, controlQubits, numControlQubits, targetQubit, u)) {
+        long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
+        long long int ctrlFlipMask = 0;
+        statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_multiControlledUnitary(qureg, ctrlQubitsMask<<shift, ctrlFlipMask<<shift, targetQubit+shift, getConjugateMatrix2(u));
+        }
     }
     
     qasm_recordMultiControlledUnitary(qureg, u, controlQubits, numControlQubits, targetQubit);
@@ -391,6 +491,8 @@ void multiStateControlledUnitary(Qureg qureg, int* controlQubits, int* controlSt
     validateOneQubitUnitaryMatrix(u, __func__);
     validateControlState(controlState, numControlQubits, __func__);
 
+    fusion_flush(qureg);
+    
     long long int ctrlQubitsMask = getQubitBitMask(controlQubits, numControlQubits);
     long long int ctrlFlipMask = getControlFlipMask(controlQubits, controlState, numControlQubits);
     statevec_multiControlledUnitary(qureg, ctrlQubitsMask, ctrlFlipMask, targetQubit, u);
@@ -406,10 +508,11 @@ void compactUnitary(Qureg qureg, int targetQubit, Complex alpha, Complex beta) {
     validateTarget(qureg, targetQubit, __func__);
     validateUnitaryComplexPair(alpha, beta, __func__);
     
-    statevec_compactUnitary(qureg, targetQubit, alpha, beta);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_compactUnitary(qureg, targetQubit+shift, getConjugateScalar(alpha), getConjugateScalar(beta));
+    if (!fusion_addCompactUnitary(qureg, NULL, 0, targetQubit, alpha, beta)) {
+        if (qureg.isDensityMatrix)
+            densmatr_compactUnitary(qureg, targetQubit, alpha, beta);
+        else
+            statevec_compactUnitary(qureg, targetQubit, alpha, beta);
     }
 
     qasm_recordCompactUnitary(qureg, alpha, beta, targetQubit);
@@ -419,12 +522,14 @@ void controlledCompactUnitary(Qureg qureg, int controlQubit, int targetQubit, Co
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     validateUnitaryComplexPair(alpha, beta, __func__);
     
-    statevec_controlledCompactUnitary(qureg, controlQubit, targetQubit, alpha, beta);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledCompactUnitary(qureg, 
-            controlQubit+shift, targetQubit+shift, 
-            getConjugateScalar(alpha), getConjugateScalar(beta));
+    if (!fusion_addCompactUnitary(qureg, (int[]) {controlQubit}, 1, targetQubit, alpha, beta)) {
+        statevec_controlledCompactUnitary(qureg, controlQubit, targetQubit, alpha, beta);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledCompactUnitary(qureg, 
+                controlQubit+shift, targetQubit+shift, 
+                getConjugateScalar(alpha), getConjugateScalar(beta));
+        }
     }
     
     qasm_recordControlledCompactUnitary(qureg, alpha, beta, controlQubit, targetQubit);
@@ -433,9 +538,11 @@ void controlledCompactUnitary(Qureg qureg, int controlQubit, int targetQubit, Co
 void pauliX(Qureg qureg, int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_pauliX(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_pauliX(qureg, targetQubit+qureg.numQubitsRepresented);
+    if (!fusion_addGate(qureg, GATE_SIGMA_X, NULL, 0, targetQubit, 0)) {
+        statevec_pauliX(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_pauliX(qureg, targetQubit+qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_SIGMA_X, targetQubit);
@@ -444,9 +551,11 @@ void pauliX(Qureg qureg, int targetQubit) {
 void pauliY(Qureg qureg, int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_pauliY(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_pauliYConj(qureg, targetQubit + qureg.numQubitsRepresented);
+    if (!fusion_addGate(qureg, GATE_SIGMA_Y, NULL, 0, targetQubit, 0)) {
+        statevec_pauliY(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_pauliYConj(qureg, targetQubit + qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_SIGMA_Y, targetQubit);
@@ -455,9 +564,11 @@ void pauliY(Qureg qureg, int targetQubit) {
 void pauliZ(Qureg qureg, int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_pauliZ(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_pauliZ(qureg, targetQubit+qureg.numQubitsRepresented);
+    if (!fusion_addGate(qureg, GATE_SIGMA_Z, NULL, 0, targetQubit, 0)) {
+        statevec_pauliZ(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_pauliZ(qureg, targetQubit+qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_SIGMA_Z, targetQubit);
@@ -466,9 +577,11 @@ void pauliZ(Qureg qureg, int targetQubit) {
 void sGate(Qureg qureg, int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_sGate(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_sGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+    if (!fusion_addGate(qureg, GATE_S, NULL, 0, targetQubit, 0)) {
+        statevec_sGate(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_sGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_S, targetQubit);
@@ -477,9 +590,11 @@ void sGate(Qureg qureg, int targetQubit) {
 void tGate(Qureg qureg, int targetQubit) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_tGate(qureg, targetQubit);
-    if (qureg.isDensityMatrix) {
-        statevec_tGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+    if (!fusion_addGate(qureg, GATE_T, NULL, 0, targetQubit, 0)) {
+        statevec_tGate(qureg, targetQubit);
+        if (qureg.isDensityMatrix) {
+            statevec_tGateConj(qureg, targetQubit+qureg.numQubitsRepresented);
+        }
     }
     
     qasm_recordGate(qureg, GATE_T, targetQubit);
@@ -488,9 +603,11 @@ void tGate(Qureg qureg, int targetQubit) {
 void phaseShift(Qureg qureg, int targetQubit, qreal angle) {
     validateTarget(qureg, targetQubit, __func__);
     
-    statevec_phaseShift(qureg, targetQubit, angle);
-    if (qureg.isDensityMatrix) {
-        statevec_phaseShift(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
+    if (!fusion_addGate(qureg, GATE_PHASE_SHIFT, NULL, 0, targetQubit, angle)) {
+        statevec_phaseShift(qureg, targetQubit, angle);
+        if (qureg.isDensityMatrix) {
+            statevec_phaseShift(qureg, targetQubit+qureg.numQubitsRepresented, -angle);
+        }
     }
     
     qasm_recordParamGate(qureg, GATE_PHASE_SHIFT, targetQubit, angle);
@@ -499,10 +616,12 @@ void phaseShift(Qureg qureg, int targetQubit, qreal angle) {
 void controlledPhaseShift(Qureg qureg, int idQubit1, int idQubit2, qreal angle) {
     validateControlTarget(qureg, idQubit1, idQubit2, __func__);
     
-    statevec_controlledPhaseShift(qureg, idQubit1, idQubit2, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledPhaseShift(qureg, idQubit1+shift, idQubit2+shift, -angle);
+    if (!fusion_addGate(qureg, GATE_PHASE_SHIFT, (int[]) {idQubit1}, 1, idQubit2, angle)) {
+        statevec_controlledPhaseShift(qureg, idQubit1, idQubit2, angle);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledPhaseShift(qureg, idQubit1+shift, idQubit2+shift, -angle);
+        }
     }
     
     qasm_recordControlledParamGate(qureg, GATE_PHASE_SHIFT, idQubit1, idQubit2, angle);
@@ -511,12 +630,14 @@ void controlledPhaseShift(Qureg qureg, int idQubit1, int idQubit2, qreal angle)
 void multiControlledPhaseShift(Qureg qureg, int *controlQubits, int numControlQubits, qreal angle) {
     validateMultiQubits(qureg, controlQubits, numControlQubits, __func__);
     
-    statevec_multiControlledPhaseShift(qureg, controlQubits, numControlQubits, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        shiftIndices(controlQubits, numControlQubits, shift);
-        statevec_multiControlledPhaseShift(qureg, controlQubits, numControlQubits, -angle);
-        shiftIndices(controlQubits, numControlQubits, -shift);
+    if (!fusion_addGate(qureg, GATE_PHASE_SHIFT, controlQubits, numControlQubits-1, controlQubits[numControlQubits-1], angle)) {
+        statevec_multiControlledPhaseShift(qureg, controlQubits, numControlQubits, angle);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            shiftIndices(controlQubits, numControlQubits, shift);
+            statevec_multiControlledPhaseShift(qureg, controlQubits, numControlQubits, -angle);
+            shiftIndices(controlQubits, numControlQubits, -shift);
+        }
     }
     
     qasm_recordMultiControlledParamGate(qureg, GATE_PHASE_SHIFT, controlQubits, numControlQubits-1, controlQubits[numControlQubits-1], angle);
@@ -525,10 +646,12 @@ void multiControlledPhaseShift(Qureg qureg, int *controlQubits, int numControlQu
 void controlledNot(Qureg qureg, int controlQubit, int targetQubit) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     
-    statevec_controlledNot(qureg, controlQubit, targetQubit);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledNot(qureg, controlQubit+shift, targetQubit+shift);
+    if (!fusion_addGate(qureg, GATE_SIGMA_X, (int[]) {controlQubit}, 1, targetQubit, 0)) {
+        statevec_controlledNot(qureg, controlQubit, targetQubit);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledNot(qureg, controlQubit+shift, targetQubit+shift);
+        }
     }
     
     qasm_recordControlledGate(qureg, GATE_SIGMA_X, controlQubit, targetQubit);
@@ -537,10 +660,12 @@ void controlledNot(Qureg qureg, int controlQubit, int targetQubit) {
 void controlledPauliY(Qureg qureg, int controlQubit, int targetQubit) {
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     
-    statevec_controlledPauliY(qureg, controlQubit, targetQubit);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledPauliYConj(qureg, controlQubit+shift, targetQubit+shift);
+    if (!fusion_addGate(qureg, GATE_SIGMA_Y, (int[]) {controlQubit}, 1, targetQubit, 0)) {
+        statevec_controlledPauliY(qureg, controlQubit, targetQubit);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledPauliYConj(qureg, controlQubit+shift, targetQubit+shift);
+        }
     }
     
     qasm_recordControlledGate(qureg, GATE_SIGMA_Y, controlQubit, targetQubit);
@@ -549,10 +674,12 @@ void controlledPauliY(Qureg qureg, int controlQubit, int targetQubit) {
 void controlledPhaseFlip(Qureg qureg, int idQubit1, int idQubit2) {
     validateControlTarget(qureg, idQubit1, idQubit2, __func__);
     
-    statevec_controlledPhaseFlip(qureg, idQubit1, idQubit2);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledPhaseFlip(qureg, idQubit1+shift, idQubit2+shift);
+    if (!fusion_addGate(qureg, GATE_SIGMA_Z, (int[]) {idQubit1}, 1, idQubit2, 0)) {
+        statevec_controlledPhaseFlip(qureg, idQubit1, idQubit2);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledPhaseFlip(qureg, idQubit1+shift, idQubit2+shift);
+        }
     }
     
     qasm_recordControlledGate(qureg, GATE_SIGMA_Z, idQubit1, idQubit2);
@@ -561,25 +688,46 @@ void controlledPhaseFlip(Qureg qureg, int idQubit1, int idQubit2) {
 void multiControlledPhaseFlip(Qureg qureg, int *controlQubits, int numControlQubits) {
     validateMultiQubits(qureg, controlQubits, numControlQubits, __func__);
     
-    statevec_multiControlledPhaseFlip(qureg, controlQubits, numControlQubits);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        shiftIndices(controlQubits, numControlQubits, shift);
+    if (!fusion_addGate(qureg, GATE_SIGMA_Z, controlQubits, numControlQubits-1, controlQubits[numControlQubits-1], 0)) {
         statevec_multiControlledPhaseFlip(qureg, controlQubits, numControlQubits);
-        shiftIndices(controlQubits, numControlQubits, -shift);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            shiftIndices(controlQubits, numControlQubits, shift);
+            statevec_multiControlledPhaseFlip(qureg, controlQubits, numControlQubits);
+            shiftIndices(controlQubits, numControlQubits, -shift);
+        }
     }
     
     qasm_recordMultiControlledGate(qureg, GATE_SIGMA_Z, controlQubits, numControlQubits-1, controlQubits[numControlQubits-1]);
 }
 
+void multiControlledMultiQubitNot(Qureg qureg, int* ctrls, int numCtrls, int* targs, int numTargs) {
+    validateMultiControlsMultiTargets(qureg, ctrls, numCtrls, targs, numTargs, __func__);
+    
+    fusion_flush(qureg);
+    
+    long long int ctrlMask = getQubitBitMask(ctrls, numCtrls);
+    long long int targMask = getQubitBitMask(targs, numTargs);
+    statevec_multiControlledMultiQubitNot(qureg, ctrlMask, targMask);
+    if (qureg.isDensityMatrix) {
+        int shift = qureg.numQubitsRepresented;
+        statevec_multiControlledMultiQubitNot(qureg, ctrlMask<<shift, targMask<<shift);
+    }
+    
+    // the NOTs upon distinct targets commute, and are recorded individually
+    for (int t=0; t < numTargs; t++)
+        qasm_recordMultiControlledGate(qureg, GATE_SIGMA_X, ctrls, numCtrls, targs[t]);
+}
+
 void rotateAroundAxis(Qureg qureg, int rotQubit, qreal angle, Vector axis) {
     validateTarget(qureg, rotQubit, __func__);
     validateVector(axis, __func__);
     
-    statevec_rotateAroundAxis(qureg, rotQubit, angle, axis);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_rotateAroundAxisConj(qureg, rotQubit+shift, angle, axis);
+    if (!fusion_addAxisRotation(qureg, NULL, 0, rotQubit, angle, axis)) {
+        if (qureg.isDensityMatrix)
+            densmatr_rotateAroundAxis(qureg, rotQubit, angle, axis);
+        else
+            statevec_rotateAroundAxis(qureg, rotQubit, angle, axis);
     }
     
     qasm_recordAxisRotation(qureg, angle, axis, rotQubit);
@@ -589,10 +737,12 @@ void controlledRotateAroundAxis(Qureg qureg, int controlQubit, int targetQubit,
     validateControlTarget(qureg, controlQubit, targetQubit, __func__);
     validateVector(axis, __func__);
     
-    statevec_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, axis);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_controlledRotateAroundAxisConj(qureg, controlQubit+shift, targetQubit+shift, angle, axis);
+    if (!fusion_addAxisRotation(qureg, (int[]) {controlQubit}, 1, targetQubit, angle, axis)) {
+        statevec_controlledRotateAroundAxis(qureg, controlQubit, targetQubit, angle, axis);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_controlledRotateAroundAxisConj(qureg, controlQubit+shift, targetQubit+shift, angle, axis);
+        }
     }
     
     qasm_recordControlledAxisRotation(qureg, angle, axis, controlQubit, targetQubit);
@@ -601,10 +751,12 @@ void controlledRotateAroundAxis(Qureg qureg, int controlQubit, int targetQubit,
 void swapGate(Qureg qureg, int qb1, int qb2) {
     validateUniqueTargets(qureg, qb1, qb2, __func__);
 
-    statevec_swapQubitAmps(qureg, qb1, qb2);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_swapQubitAmps(qureg, qb1+shift, qb2+shift);
+    if (!fusion_addSwapGate(qureg, GATE_SWAP, qb1, qb2)) {
+        statevec_swapQubitAmps(qureg, qb1, qb2);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_swapQubitAmps(qureg, qb1+shift, qb2+shift);
+        }
     }
 
     qasm_recordControlledGate(qureg, GATE_SWAP, qb1, qb2);
@@ -614,10 +766,11 @@ void sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
     validateUniqueTargets(qureg, qb1, qb2, __func__);
     validateMultiQubitMatrixFitsInNode(qureg, 2, __func__); // uses 2qb unitary in QuEST_common
 
-    statevec_sqrtSwapGate(qureg, qb1, qb2);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_sqrtSwapGateConj(qureg, qb1+shift, qb2+shift);
+    if (!fusion_addSwapGate(qureg, GATE_SQRT_SWAP, qb1, qb2)) {
+        if (qureg.isDensityMatrix)
+            densmatr_sqrtSwapGate(qureg, qb1, qb2);
+        else
+            statevec_sqrtSwapGate(qureg, qb1, qb2);
     }
 
     qasm_recordControlledGate(qureg, GATE_SQRT_SWAP, qb1, qb2);
@@ -627,10 +780,12 @@ void multiRotateZ(Qureg qureg, int* qubits, int numQubits, qreal angle) {
     validateMultiTargets(qureg, qubits, numQubits, __func__);
     
     long long int mask = getQubitBitMask(qubits, numQubits);
-    statevec_multiRotateZ(qureg, mask, angle);
-    if (qureg.isDensityMatrix) {
-        int shift = qureg.numQubitsRepresented;
-        statevec_multiRotateZ(qureg, mask << shift, -angle);
+    if (!fusion_addMultiRotateZ(qureg, mask, angle)) {
+        statevec_multiRotateZ(qureg, mask, angle);
+        if (qureg.isDensityMatrix) {
+            int shift = qureg.numQubitsRepresented;
+            statevec_multiRotateZ(qureg, mask << shift, -angle);
+        }
     }
     
     // @TODO: create actual QASM
@@ -643,6 +798,8 @@ void multiRotatePauli(Qureg qureg, int* targetQubits, enum pauliOpType* targetPa
     validateMultiTargets(qureg, targetQubits, numTargets, __func__);
     validatePauliCodes(targetPaulis, numTargets, __func__);
     
+    fusion_flush(qureg);
+    
     int conj=0;
     statevec_multiRotatePauli(qureg, targetQubits, targetPaulis, numTargets, angle, conj);
     if (qureg.isDensityMatrix) {
@@ -679,6 +836,8 @@ qreal getRealAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    fusion_flush(qureg);
+    
     return statevec_getRealAmp(qureg, index);
 }
 
@@ -686,6 +845,8 @@ qreal getImagAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    fusion_flush(qureg);
+    
     return statevec_getImagAmp(qureg, index);
 }
 
@@ -693,6 +854,8 @@ qreal getProbAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    fusion_flush(qureg);
+    
     return statevec_getProbAmp(qureg, index);
 }
 
@@ -700,6 +863,8 @@ Complex getAmp(Qureg qureg, long long int index) {
     validateStateVecQureg(qureg, __func__);
     validateAmpIndex(qureg, index, __func__);
     
+    fusion_flush(qureg);
+    
     Complex amp;
     amp.real = statevec_getRealAmp(qureg, index);
     amp.imag = statevec_getImagAmp(qureg, index);
@@ -711,6 +876,8 @@ Complex getDensityAmp(Qureg qureg, long long int row, long long int col) {
     validateAmpIndex(qureg, row, __func__);
     validateAmpIndex(qureg, col, __func__);
     
+    fusion_flush(qureg);
+    
     long long ind = row + col*(1LL << qureg.numQubitsRepresented);
     Complex amp;
     amp.real = statevec_getRealAmp(qureg, ind);
@@ -727,6 +894,8 @@ qreal collapseToOutcome(Qureg qureg, int measureQubit, int outcome) {
     validateTarget(qureg, measureQubit, __func__);
     validateOutcome(outcome, __func__);
     
+    fusion_flush(qureg);
+    
     qreal outcomeProb;
     if (qureg.isDensityMatrix) {
         outcomeProb = densmatr_calcProbOfOutcome(qureg, measureQubit, outcome);
@@ -745,6 +914,8 @@ qreal collapseToOutcome(Qureg qureg, int measureQubit, int outcome) {
 int measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
     validateTarget(qureg, measureQubit, __func__);
 
+    fusion_flush(qureg);
+    
     int outcome;
     if (qureg.isDensityMatrix)
         outcome = densmatr_measureWithStats(qureg, measureQubit, outcomeProb);
@@ -758,6 +929,8 @@ int measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb) {
 int measure(Qureg qureg, int measureQubit) {
     validateTarget(qureg, measureQubit, __func__);
     
+    fusion_flush(qureg);
+    
     int outcome;
     qreal discardedProb;
     if (qureg.isDensityMatrix)
@@ -775,6 +948,9 @@ void mixDensityMatrix(Qureg combineQureg, qreal otherProb, Qureg otherQureg) {
     validateMatchingQuregDims(combineQureg, otherQureg, __func__);
     validateProb(otherProb, __func__);
     
+    fusion_flush(combineQureg);
+    fusion_flush(otherQureg);
+    
     densmatr_mixDensityMatrix(combineQureg, otherProb, otherQureg);
 }
 
@@ -782,12 +958,15 @@ void setAmps(Qureg qureg, long long int startInd, qreal* reals, qreal* imags, lo
     validateStateVecQureg(qureg, __func__);
     validateNumAmps(qureg, startInd, numAmps, __func__);
     
+    fusion_flush(qureg);
+    
     statevec_setAmps(qureg, startInd, reals, imags, numAmps);
     
     qasm_recordComment(qureg, "Here, some amplitudes in the statevector were manually edited.");
 }
 
 void setDensityAmps(Qureg qureg, qreal* reals, qreal* imags) {
+    fusion_discard(qureg);
     long long int numAmps = qureg.numAmpsTotal; 
     statevec_setAmps(qureg, 0, reals, imags, numAmps);
     
@@ -800,6 +979,10 @@ void setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg qureg2, Co
     validateMatchingQuregDims(qureg1, qureg2,  __func__);
     validateMatchingQuregDims(qureg1, out, __func__);
 
+    fusion_flush(qureg1);
+    fusion_flush(qureg2);
+    fusion_flush(out);
+    
     statevec_setWeightedQureg(fac1, qureg1, fac2, qureg2, facOut, out);
 
     qasm_recordComment(out, "Here, the register was modified to an undisclosed and possibly unphysical state (setWeightedQureg).");
@@ -811,6 +994,9 @@ void applyPauliSum(Qureg inQureg, enum pauliOpType* allPauliCodes, qreal* termCo
     validateNumPauliSumTerms(numSumTerms, __func__);
     validatePauliCodes(allPauliCodes, numSumTerms*inQureg.numQubitsRepresented, __func__);
     
+    fusion_flush(inQureg);
+    fusion_discard(outQureg);
+    
     statevec_applyPauliSum(inQureg, allPauliCodes, termCoeffs, numSumTerms, outQureg);
     
     qasm_recordComment(outQureg, "Here, the register was modified to an undisclosed and possibly unphysical state (applyPauliSum).");
@@ -822,6 +1008,9 @@ void applyPauliHamil(Qureg inQureg, PauliHamil hamil, Qureg outQureg) {
     validatePauliHamil(hamil, __func__);
     validateMatchingQuregPauliHamilDims(inQureg, hamil, __func__);
     
+    fusion_flush(inQureg);
+    fusion_discard(outQureg);
+    
     statevec_applyPauliSum(inQureg, hamil.pauliCodes, hamil.termCoeffs, hamil.numSumTerms, outQureg);
     
     qasm_recordComment(outQureg, "Here, the register was modified to an undisclosed and possibly unphysical state (applyPauliHamil).");
@@ -832,18 +1021,50 @@ void applyTrotterCircuit(Qureg qureg, PauliHamil hamil, qreal time, int order, i
     validatePauliHamil(hamil, __func__);
     validateMatchingQuregPauliHamilDims(qureg, hamil, __func__);
     
+    fusion_flush(qureg);
+    
     qasm_recordComment(qureg, 
         "Beginning of Trotter circuit (time %g, order %d, %d repetitions).",
         time, order, reps);
         
-    agnostic_applyTrotterCircuit(qureg, hamil, time, order, reps);
+    TrotterPlan plan = agnostic_createTrotterPlan(hamil, time, order, reps);
+    agnostic_applyTrotterPlan(qureg, plan);
+    destroyTrotterPlan(plan);
 
     qasm_recordComment(qureg, "End of Trotter circuit");
 }
 
+TrotterPlan createTrotterPlan(PauliHamil hamil, qreal time, int order, int reps) {
+    validateTrotterParams(order, reps, __func__);
+    validatePauliHamil(hamil, __func__);
+    
+    return agnostic_createTrotterPlan(hamil, time, order, reps);
+}
+
+void applyTrotterPlan(Qureg qureg, TrotterPlan plan) {
+    validateMatchingQuregTrotterPlanDims(qureg, plan, __func__);
+    
+    fusion_flush(qureg);
+    
+    qasm_recordComment(qureg, "Beginning of Trotter circuit (%d rotations).", plan.numTerms);
+    
+    agnostic_applyTrotterPlan(qureg, plan);
+    
+    qasm_recordComment(qureg, "End of Trotter circuit");
+}
+
+void destroyTrotterPlan(TrotterPlan plan) {
+    
+    free(plan.xMasks);
+    free(plan.zMasks);
+    free(plan.angles);
+}
+
 void applyMatrix2(Qureg qureg, int targetQubit, ComplexMatrix2 u) {
     validateTarget(qureg, targetQubit, __func__);
     
+    fusion_flush(qureg);
+    
     // actually just left-multiplies any complex matrix
     statevec_unitary(qureg, targetQubit, u);
 
@@ -854,6 +1075,8 @@ void applyMatrix4(Qureg qureg, int targetQubit1, int targetQubit2, ComplexMatrix
     validateMultiTargets(qureg, (int []) {targetQubit1, targetQubit2}, 2, __func__);
     validateMultiQubitMatrixFitsInNode(qureg, 2, __func__);
     
+    fusion_flush(qureg);
+    
     // actually just left-multiplies any complex matrix
     statevec_twoQubitUnitary(qureg, targetQubit1, targetQubit2, u);
 
@@ -864,6 +1087,8 @@ void applyMatrixN(Qureg qureg, int* targs, int numTargs, ComplexMatrixN u) {
     validateMultiTargets(qureg, targs, numTargs, __func__);
     validateMultiQubitMatrix(qureg, u, numTargs, __func__);
     
+    fusion_flush(qureg);
+    
     // actually just left-multiplies any complex matrix
     statevec_multiQubitUnitary(qureg, targs, numTargs, u);
     
@@ -875,6 +1100,8 @@ void applyMultiControlledMatrixN(Qureg qureg, int* ctrls, int numCtrls, int* tar
     validateMultiControlsMultiTargets(qureg, ctrls, numCtrls, targs, numTargs, __func__);
     validateMultiQubitMatrix(qureg, u, numTargs, __func__);
     
+    fusion_flush(qureg);
+    
     // actually just left-multiplies any complex matrix
     long long int ctrlMask = getQubitBitMask(ctrls, numCtrls);
     statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask, targs, numTargs, u);
@@ -887,6 +1114,8 @@ void applyMultiControlledMatrixN(Qureg qureg, int* ctrls, int numCtrls, int* tar
 void applyDiagonalOp(Qureg qureg, DiagonalOp op) {
     validateDiagonalOp(qureg, op, __func__);
 
+    fusion_flush(qureg);
+    
     if (qureg.isDensityMatrix)
         densmatr_applyDiagonalOp(qureg, op);
     else
@@ -901,6 +1130,7 @@ void applyDiagonalOp(Qureg qureg, DiagonalOp op) {
  */
 
 qreal calcTotalProb(Qureg qureg) {
+    fusion_flush(qureg);
     if (qureg.isDensityMatrix)  
             return densmatr_calcTotalProb(qureg);
         else
@@ -912,6 +1142,9 @@ Complex calcInnerProduct(Qureg bra, Qureg ket) {
     validateStateVecQureg(ket, __func__);
     validateMatchingQuregDims(bra, ket,  __func__);
     
+    fusion_flush(bra);
+    fusion_flush(ket);
+    
     return statevec_calcInnerProduct(bra, ket);
 }
 
@@ -920,6 +1153,9 @@ qreal calcDensityInnerProduct(Qureg rho1, Qureg rho2) {
     validateDensityMatrQureg(rho2, __func__);
     validateMatchingQuregDims(rho1, rho2, __func__);
     
+    fusion_flush(rho1);
+    fusion_flush(rho2);
+    
     return densmatr_calcInnerProduct(rho1, rho2);
 }
 
@@ -927,15 +1163,38 @@ qreal calcProbOfOutcome(Qureg qureg, int measureQubit, int outcome) {
     validateTarget(qureg, measureQubit, __func__);
     validateOutcome(outcome, __func__);
     
+    fusion_flush(qureg);
+    
     if (qureg.isDensityMatrix)
         return densmatr_calcProbOfOutcome(qureg, measureQubit, outcome);
     else
         return statevec_calcProbOfOutcome(qureg, measureQubit, outcome);
 }
 
+void calcProbOfAllOutcomes(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs) {
+    validateMultiQubits(qureg, qubits, numQubits, __func__);
+    
+    fusion_flush(qureg);
+    
+    // valid for both statevec and density matrices
+    statevec_calcProbOfAllOutcomes(qureg, qubits, numQubits, outcomeProbs);
+}
+
+void sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes) {
+    validateMultiQubits(qureg, qubits, numQubits, __func__);
+    validateNumShots(numShots, __func__);
+    
+    fusion_flush(qureg);
+    
+    // valid for both statevec and density matrices
+    statevec_sampleOutcomes(qureg, qubits, numQubits, numShots, outcomes);
+}
+
 qreal calcPurity(Qureg qureg) {
     validateDensityMatrQureg(qureg, __func__);
     
+    fusion_flush(qureg);
+    
     return densmatr_calcPurity(qureg);
 }
 
@@ -943,6 +1202,9 @@ qreal calcFidelity(Qureg qureg, Qureg pureState) {
     validateSecondQuregStateVec(pureState, __func__);
     validateMatchingQuregDims(qureg, pureState, __func__);
     
+    fusion_flush(qureg);
+    fusion_flush(pureState);
+    
     if (qureg.isDensityMatrix)
         return densmatr_calcFidelity(qureg, pureState);
     else
@@ -955,7 +1217,9 @@ qreal calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauli
     validateMatchingQuregTypes(qureg, workspace, __func__);
     validateMatchingQuregDims(qureg, workspace, __func__);
     
-    return statevec_calcExpecPauliProd(qureg, targetQubits, pauliCodes, numTargets, workspace);
+    fusion_flush(qureg);
+    
+    return statevec_calcExpecPauliProd(qureg, targetQubits, pauliCodes, numTargets);
 }
 
 qreal calcExpecPauliSum(Qureg qureg, enum pauliOpType* allPauliCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace) {
@@ -964,7 +1228,9 @@ qreal calcExpecPauliSum(Qureg qureg, enum pauliOpType* allPauliCodes, qreal* ter
     validateMatchingQuregTypes(qureg, workspace, __func__);
     validateMatchingQuregDims(qureg, workspace, __func__);
     
-    return statevec_calcExpecPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms, workspace);
+    fusion_flush(qureg);
+    
+    return statevec_calcExpecPauliSum(qureg, allPauliCodes, termCoeffs, numSumTerms);
 }
 
 qreal calcExpecPauliHamil(Qureg qureg, PauliHamil hamil, Qureg workspace) {
@@ -973,12 +1239,16 @@ qreal calcExpecPauliHamil(Qureg qureg, PauliHamil hamil, Qureg workspace) {
     validatePauliHamil(hamil, __func__);
     validateMatchingQuregPauliHamilDims(qureg, hamil, __func__);
     
-    return statevec_calcExpecPauliSum(qureg, hamil.pauliCodes, hamil.termCoeffs, hamil.numSumTerms, workspace);
+    fusion_flush(qureg);
+    
+    return statevec_calcExpecPauliSum(qureg, hamil.pauliCodes, hamil.termCoeffs, hamil.numSumTerms);
 }
 
 Complex calcExpecDiagonalOp(Qureg qureg, DiagonalOp op) {
     validateDiagonalOp(qureg, op, __func__);
     
+    fusion_flush(qureg);
+    
     if (qureg.isDensityMatrix)
         return densmatr_calcExpecDiagonalOp(qureg, op);
     else
@@ -990,6 +1260,9 @@ qreal calcHilbertSchmidtDistance(Qureg a, Qureg b) {
     validateDensityMatrQureg(b, __func__);
     validateMatchingQuregDims(a, b, __func__);
     
+    fusion_flush(a);
+    fusion_flush(b);
+    
     return densmatr_calcHilbertSchmidtDistance(a, b);
 }
 
@@ -1003,6 +1276,8 @@ void mixDephasing(Qureg qureg, int targetQubit, qreal prob) {
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitDephaseProb(prob, __func__);
     
+    fusion_flush(qureg);
+    
     densmatr_mixDephasing(qureg, targetQubit, 2*prob);
     qasm_recordComment(qureg, 
         "Here, a phase (Z) error occured on qubit %d with probability %g", targetQubit, prob);
@@ -1013,6 +1288,8 @@ void mixTwoQubitDephasing(Qureg qureg, int qubit1, int qubit2, qreal prob) {
     validateUniqueTargets(qureg, qubit1, qubit2, __func__);
     validateTwoQubitDephaseProb(prob, __func__);
 
+    fusion_flush(qureg);
+    
     ensureIndsIncrease(&qubit1, &qubit2);
     densmatr_mixTwoQubitDephasing(qureg, qubit1, qubit2, (4*prob)/3.0);
     qasm_recordComment(qureg,
@@ -1025,6 +1302,8 @@ void mixDepolarising(Qureg qureg, int targetQubit, qreal prob) {
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitDepolProb(prob, __func__);
     
+    fusion_flush(qureg);
+    
     densmatr_mixDepolarising(qureg, targetQubit, (4*prob)/3.0);
     qasm_recordComment(qureg,
         "Here, a homogeneous depolarising error (X, Y, or Z) occured on "
@@ -1036,6 +1315,8 @@ void mixDamping(Qureg qureg, int targetQubit, qreal prob) {
     validateTarget(qureg, targetQubit, __func__);
     validateOneQubitDampingProb(prob, __func__);
     
+    fusion_flush(qureg);
+    
     densmatr_mixDamping(qureg, targetQubit, prob);
 }
 
@@ -1044,6 +1325,8 @@ void mixTwoQubitDepolarising(Qureg qureg, int qubit1, int qubit2, qreal prob) {
     validateUniqueTargets(qureg, qubit1, qubit2, __func__);
     validateTwoQubitDepolProb(prob, __func__);
     
+    fusion_flush(qureg);
+    
     ensureIndsIncrease(&qubit1, &qubit2);
     densmatr_mixTwoQubitDepolarising(qureg, qubit1, qubit2, (16*prob)/15.0);
     qasm_recordComment(qureg,
@@ -1056,6 +1339,8 @@ void mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal probZ) {
     validateTarget(qureg, qubit, __func__);
     validateOneQubitPauliProbs(probX, probY, probZ, __func__);
     
+    fusion_flush(qureg);
+    
     densmatr_mixPauli(qureg, qubit, probX, probY, probZ);
     qasm_recordComment(qureg,
         "Here, X, Y and Z errors occured on qubit %d with probabilities "
@@ -1067,6 +1352,8 @@ void mixKrausMap(Qureg qureg, int target, ComplexMatrix2 *ops, int numOps) {
     validateTarget(qureg, target, __func__);
     validateOneQubitKrausMap(qureg, ops, numOps, __func__);
     
+    fusion_flush(qureg);
+    
     densmatr_mixKrausMap(qureg, target, ops, numOps);
     qasm_recordComment(qureg, 
         "Here, an undisclosed Kraus map was effected on qubit %d", target);
@@ -1077,6 +1364,8 @@ void mixTwoQubitKrausMap(Qureg qureg, int target1, int target2, ComplexMatrix4 *
     validateMultiTargets(qureg, (int[]) {target1,target2}, 2, __func__);
     validateTwoQubitKrausMap(qureg, ops, numOps, __func__);
     
+    fusion_flush(qureg);
+    
     densmatr_mixTwoQubitKrausMap(qureg, target1, target2, ops, numOps);
     qasm_recordComment(qureg, 
         "Here, an undisclosed two-qubit Kraus map was effected on qubits %d and %d", target1, target2);
@@ -1087,6 +1376,8 @@ void mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMat
     validateMultiTargets(qureg, targets, numTargets, __func__);
     validateMultiQubitKrausMap(qureg, numTargets, ops, numOps, __func__);
     
+    fusion_flush(qureg);
+    
     densmatr_mixMultiQubitKrausMap(qureg, targets, numTargets, ops, numOps);
     qasm_recordComment(qureg,
         "Here, an undisclosed %d-qubit Kraus map was applied to undisclosed qubits", numTargets);
@@ -1302,26 +1593,59 @@ void setDiagonalOpElems(DiagonalOp op, long long int startInd, qreal* real, qrea
 
 int compareStates(Qureg qureg1, Qureg qureg2, qreal precision) {
     validateMatchingQuregDims(qureg1, qureg2, __func__);
+    fusion_flush(qureg1);
+    fusion_flush(qureg2);
     return statevec_compareStates(qureg1, qureg2, precision);
 }
 
 void initDebugState(Qureg qureg) {
+    fusion_discard(qureg);
     statevec_initDebugState(qureg);
 }
 
 void initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env) {
-    int success = statevec_initStateFromSingleFile(qureg, filename, env);
-    validateFileOpened(success, filename, __func__);
+    fusion_discard(*qureg);
+    int isComplete;
+    int opened = statevec_initStateFromSingleFile(qureg, filename, env, &isComplete);
+    validateFileOpened(opened, filename, __func__);
+    validateStateFile(isComplete, filename, __func__);
 }
 
 void initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome) {
     validateStateVecQureg(*qureg, __func__);
     validateTarget(*qureg, qubitId, __func__);
     validateOutcome(outcome, __func__);
+    fusion_discard(*qureg);
     statevec_initStateOfSingleQubit(qureg, qubitId, outcome);
 }
 
+void saveQuregCheckpoint(Qureg qureg, char* filename, QuESTEnv env) {
+    fusion_flush(qureg);
+    int success = statevec_saveCheckpoint(qureg, filename);
+    validateFileWritten(success, filename, __func__);
+}
+
+void loadQuregCheckpoint(Qureg qureg, char* filename, QuESTEnv env) {
+    CheckpointHeader header;
+    int isValid = 0;
+    int opened = statevec_readCheckpointHeader(filename, &header, &isValid);
+    
+    // every node reads the header, but all must agree it is valid before any proceeds
+    opened = syncQuESTSuccess(opened);
+    isValid = syncQuESTSuccess(opened && isValid);
+    validateFileOpened(opened, filename, __func__);
+    validateCheckpointFile(isValid, filename, __func__);
+    validateMatchingQuregCheckpointDims(qureg, header.numQubitsRepresented, header.isDensityMatrix, filename, __func__);
+    
+    fusion_discard(qureg);
+    int success = syncQuESTSuccess(statevec_loadCheckpoint(qureg, filename, header));
+    validateFileRead(success, filename, __func__);
+    
+    qasm_recordComment(qureg, "Here, the register was loaded from an undisclosed checkpoint.");
+}
+
 void reportStateToScreen(Qureg qureg, QuESTEnv env, int reportRank)  {
+    fusion_flush(qureg);
     statevec_reportStateToScreen(qureg, env, reportRank);
 }
 
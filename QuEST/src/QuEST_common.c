@@ -15,11 +15,17 @@
  * @author Balint Koczor (Kraus maps, mixPauli, Windows compatibility)
  */
 
+// expose fseeko() despite -std=c99
+# if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+# define _DEFAULT_SOURCE
+# endif
+
 # include "QuEST.h"
 # include "QuEST_internal.h"
 # include "QuEST_precision.h"
 # include "QuEST_validation.h"
 # include "QuEST_qasm.h"
+# include "QuEST_fusion.h"
 # include "mt19937ar.h"
 
 #if defined(_WIN32) && ! defined(__MINGW32__)
@@ -34,6 +40,7 @@
 # include <sys/types.h> 
 # include <stdio.h>
 # include <stdlib.h>
+# include <string.h>
 
 
 #ifdef __cplusplus
@@ -152,6 +159,12 @@ void shiftIndices(int* indices, int numIndices, int shift) {
         indices[j] += shift;
 }
 
+int compareSampledShots(const void* a, const void* b) {
+    qaccum probA = ((const SampledShot*) a)->prob;
+    qaccum probB = ((const SampledShot*) b)->prob;
+    return (probA > probB) - (probA < probB);
+}
+
 int generateMeasurementOutcome(qreal zeroProb, qreal *outcomeProb) {
     
     // randomly choose outcome
@@ -214,6 +227,8 @@ void seedQuEST(unsigned long int *seedArray, int numSeeds){
 }
 
 void reportState(Qureg qureg){
+    fusion_flush(qureg);
+    
     FILE *state;
     char filename[100];
     long long int index;
@@ -231,6 +246,218 @@ void reportState(Qureg qureg){
     fclose(state);
 }
 
+/* Checkpoint files contain a serialised CheckpointHeader, padded to CHECKPOINT_HEADER_SIZE bytes 
+ * so that every rank's amplitudes begin at a sector-aligned offset, followed by the real components 
+ * of all amplitudes (in order of their global index), then all imaginary components. Each rank
+ * hence reads and writes its chunk as two large sequential transfers, independent of how many
+ * ranks wrote the file. The header is portable, but the amplitudes are in the writer's native 
+ * byte order (which the header records), so a reader of the other byte order rejects the file.
+ */
+# define CHECKPOINT_MAGIC "QuESTchk"
+# define CHECKPOINT_VERSION 2
+# define CHECKPOINT_HEADER_SIZE 4096
+
+/* the number of bytes of the serialised header fields: the magic, six 32-bit fields, the 64-bit 
+ * numAmpsTotal and the 32-bit isBigEndian */
+# define CHECKPOINT_HEADER_FIELDS_SIZE 44
+
+/* the number of amplitude components converted at a time when loading a checkpoint of another precision */
+# define CHECKPOINT_CONVERT_BUFFER_SIZE (1<<16)
+
+static int seekCheckpoint(FILE* file, long long int offset) {
+# ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+# else
+    return fseeko(file, (off_t) offset, SEEK_SET) == 0;
+# endif
+}
+
+static long long int getCheckpointComponentOffset(long long int numAmpsTotal, int qrealSize, int isImag, long long int index) {
+    return CHECKPOINT_HEADER_SIZE + (isImag*numAmpsTotal + index) * (long long int) qrealSize;
+}
+
+static int isBigEndianMachine(void) {
+    unsigned int one = 1;
+    return *((unsigned char*) &one) == 0;
+}
+
+static unsigned char* putCheckpointField(unsigned char* bytes, unsigned long long int value, int numBytes) {
+    for (int b=0; b < numBytes; b++)
+        bytes[b] = (unsigned char) (value >> (8*b));
+    return bytes + numBytes;
+}
+
+static const unsigned char* getCheckpointField(const unsigned char* bytes, unsigned long long int* value, int numBytes) {
+    *value = 0;
+    for (int b=0; b < numBytes; b++)
+        *value |= ((unsigned long long int) bytes[b]) << (8*b);
+    return bytes + numBytes;
+}
+
+/* serialises the header fields little-endian at fixed width, into CHECKPOINT_HEADER_FIELDS_SIZE bytes */
+static void encodeCheckpointHeader(CheckpointHeader header, unsigned char* bytes) {
+    memcpy(bytes, header.magic, sizeof header.magic);
+    bytes += sizeof header.magic;
+    bytes = putCheckpointField(bytes, (unsigned int) header.version, 4);
+    bytes = putCheckpointField(bytes, (unsigned int) header.precision, 4);
+    bytes = putCheckpointField(bytes, (unsigned int) header.qrealSize, 4);
+    bytes = putCheckpointField(bytes, (unsigned int) header.numQubitsRepresented, 4);
+    bytes = putCheckpointField(bytes, (unsigned int) header.isDensityMatrix, 4);
+    bytes = putCheckpointField(bytes, (unsigned int) header.numChunks, 4);
+    bytes = putCheckpointField(bytes, (unsigned long long int) header.numAmpsTotal, 8);
+    bytes = putCheckpointField(bytes, (unsigned int) header.isBigEndian, 4);
+}
+
+static void decodeCheckpointHeader(const unsigned char* bytes, CheckpointHeader* header) {
+    unsigned long long int value;
+    memcpy(header->magic, bytes, sizeof header->magic);
+    bytes += sizeof header->magic;
+    bytes = getCheckpointField(bytes, &value, 4); header->version = (int) value;
+    bytes = getCheckpointField(bytes, &value, 4); header->precision = (int) value;
+    bytes = getCheckpointField(bytes, &value, 4); header->qrealSize = (int) value;
+    bytes = getCheckpointField(bytes, &value, 4); header->numQubitsRepresented = (int) value;
+    bytes = getCheckpointField(bytes, &value, 4); header->isDensityMatrix = (int) value;
+    bytes = getCheckpointField(bytes, &value, 4); header->numChunks = (int) value;
+    bytes = getCheckpointField(bytes, &value, 8); header->numAmpsTotal = (long long int) value;
+    bytes = getCheckpointField(bytes, &value, 4); header->isBigEndian = (int) value;
+}
+
+/* returns 1 if successful, else 0 */
+static int writeCheckpointChunk(FILE* file, Qureg qureg) {
+    long long int startInd = qureg.chunkId * qureg.numAmpsPerChunk;
+    size_t numAmps = (size_t) qureg.numAmpsPerChunk;
+    
+    return (
+        seekCheckpoint(file, getCheckpointComponentOffset(qureg.numAmpsTotal, sizeof(qreal), 0, startInd)) &&
+        fwrite(qureg.stateVec.real, sizeof(qreal), numAmps, file) == numAmps &&
+        seekCheckpoint(file, getCheckpointComponentOffset(qureg.numAmpsTotal, sizeof(qreal), 1, startInd)) &&
+        fwrite(qureg.stateVec.imag, sizeof(qreal), numAmps, file) == numAmps);
+}
+
+/* reads numElems components of size qrealSize into elems, converting them to qreal. Returns 1 if successful, else 0 */
+static int readCheckpointComponents(FILE* file, qreal* elems, long long int numElems, int qrealSize) {
+    
+    if (qrealSize == sizeof(qreal))
+        return fread(elems, sizeof(qreal), (size_t) numElems, file) == (size_t) numElems;
+    
+    void* buffer = malloc(CHECKPOINT_CONVERT_BUFFER_SIZE * (size_t) qrealSize);
+    if (buffer == NULL)
+        return 0;
+    
+    int success = 1;
+    for (long long int start=0; start < numElems && success; start += CHECKPOINT_CONVERT_BUFFER_SIZE) {
+        long long int numInBuffer = numElems - start;
+        if (numInBuffer > CHECKPOINT_CONVERT_BUFFER_SIZE)
+            numInBuffer = CHECKPOINT_CONVERT_BUFFER_SIZE;
+        
+        success = fread(buffer, qrealSize, (size_t) numInBuffer, file) == (size_t) numInBuffer;
+        for (long long int i=0; i < numInBuffer && success; i++) {
+            if (qrealSize == sizeof(float))
+                elems[start + i] = (qreal) ((float*) buffer)[i];
+            else if (qrealSize == sizeof(double))
+                elems[start + i] = (qreal) ((double*) buffer)[i];
+            else
+                elems[start + i] = (qreal) ((long double*) buffer)[i];
+        }
+    }
+    
+    free(buffer);
+    return success;
+}
+
+int statevec_saveCheckpoint(Qureg qureg, char* filename) {
+    copyStateFromGPU(qureg);
+    
+    // the first rank creates (or truncates) the file and writes the header, before others open it
+    int success = 1;
+    if (qureg.chunkId == 0) {
+        CheckpointHeader header;
+        memset(&header, 0, sizeof header);
+        memcpy(header.magic, CHECKPOINT_MAGIC, sizeof header.magic);
+        header.version = CHECKPOINT_VERSION;
+        header.precision = QuEST_PREC;
+        header.qrealSize = sizeof(qreal);
+        header.numQubitsRepresented = qureg.numQubitsRepresented;
+        header.isDensityMatrix = qureg.isDensityMatrix;
+        header.numChunks = qureg.numChunks;
+        header.numAmpsTotal = qureg.numAmpsTotal;
+        header.isBigEndian = isBigEndianMachine();
+        
+        unsigned char bytes[CHECKPOINT_HEADER_FIELDS_SIZE];
+        encodeCheckpointHeader(header, bytes);
+        FILE* file = fopen(filename, "wb");
+        success = (file != NULL) && fwrite(bytes, sizeof bytes, 1, file) == 1;
+        if (file != NULL)
+            success = (fclose(file) == 0) && success;
+    }
+    if (!syncQuESTSuccess(success))
+        return 0;
+    
+    // every rank then writes its own chunk, in parallel, without stdio buffering
+    FILE* file = fopen(filename, "r+b");
+    success = (file != NULL);
+    if (success) {
+        setvbuf(file, NULL, _IONBF, 0);
+        success = writeCheckpointChunk(file, qureg);
+        success = (fclose(file) == 0) && success;
+    }
+    return syncQuESTSuccess(success);
+}
+
+int statevec_readCheckpointHeader(char* filename, CheckpointHeader* header, int* isValid) {
+    
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL)
+        return 0;
+    
+    unsigned char bytes[CHECKPOINT_HEADER_FIELDS_SIZE];
+    *isValid = (fread(bytes, sizeof bytes, 1, file) == 1);
+    if (*isValid)
+        decodeCheckpointHeader(bytes, header);
+    *isValid = *isValid && (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof header->magic) == 0);
+    *isValid = *isValid && (header->version == CHECKPOINT_VERSION);
+    *isValid = *isValid && (header->isBigEndian == isBigEndianMachine());
+    *isValid = *isValid && (
+        header->qrealSize == sizeof(float) || 
+        header->qrealSize == sizeof(double) || 
+        header->qrealSize == sizeof(long double));
+    *isValid = *isValid && (header->isDensityMatrix == 0 || header->isDensityMatrix == 1);
+    
+    // the number of amplitudes must be representable before it is compared
+    int numQubitsInStateVec = (*isValid && header->isDensityMatrix)? 
+        2*header->numQubitsRepresented : header->numQubitsRepresented;
+    *isValid = *isValid && (header->numQubitsRepresented > 0 && numQubitsInStateVec < 63);
+    *isValid = *isValid && (header->numAmpsTotal == 1LL << numQubitsInStateVec);
+    
+    // the file must contain every amplitude
+    *isValid = *isValid && seekCheckpoint(file, getCheckpointComponentOffset(
+        header->numAmpsTotal, header->qrealSize, 2, 0) - 1);
+    *isValid = *isValid && (fgetc(file) != EOF);
+    
+    fclose(file);
+    return 1;
+}
+
+int statevec_loadCheckpoint(Qureg qureg, char* filename, CheckpointHeader header) {
+    
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL)
+        return 0;
+    setvbuf(file, NULL, _IONBF, 0);
+    
+    // each rank reads its own chunk, regardless of the number of ranks which wrote the file
+    long long int startInd = qureg.chunkId * qureg.numAmpsPerChunk;
+    int success = (
+        seekCheckpoint(file, getCheckpointComponentOffset(header.numAmpsTotal, header.qrealSize, 0, startInd)) &&
+        readCheckpointComponents(file, qureg.stateVec.real, qureg.numAmpsPerChunk, header.qrealSize) &&
+        seekCheckpoint(file, getCheckpointComponentOffset(header.numAmpsTotal, header.qrealSize, 1, startInd)) &&
+        readCheckpointComponents(file, qureg.stateVec.imag, qureg.numAmpsPerChunk, header.qrealSize));
+    fclose(file);
+    
+    copyStateToGPU(qureg);
+    return success;
+}
+
 void reportQuregParams(Qureg qureg){
     long long int numAmps = 1LL << qureg.numQubitsInStateVec;
     long long int numAmpsPerRank = numAmps/qureg.numChunks;
@@ -381,7 +608,7 @@ qreal statevec_calcFidelity(Qureg qureg, Qureg pureState) {
     return innerProdMag;
 }
 
-void statevec_sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
+static ComplexMatrix4 getSqrtSwapMatrix(void) {
     
     ComplexMatrix4 u = (ComplexMatrix4) {.real={{0}}, .imag={{0}}};
     u.real[0][0]=1;
@@ -390,128 +617,241 @@ void statevec_sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
     u.real[1][2] = .5; u.imag[1][2] =-.5;
     u.real[2][1] = .5; u.imag[2][1] =-.5;
     u.real[2][2] = .5; u.imag[2][2] = .5;
+    return u;
+}
+
+void statevec_sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
     
-    statevec_twoQubitUnitary(qureg, qb1, qb2, u);
+    statevec_twoQubitUnitary(qureg, qb1, qb2, getSqrtSwapMatrix());
 }
 
 void statevec_sqrtSwapGateConj(Qureg qureg, int qb1, int qb2) {
     
-    ComplexMatrix4 u = (ComplexMatrix4) {.real={{0}}, .imag={{0}}};
-    u.real[0][0]=1;
-    u.real[3][3]=1;
-    u.real[1][1] = .5; u.imag[1][1] =-.5;
-    u.real[1][2] = .5; u.imag[1][2] = .5;
-    u.real[2][1] = .5; u.imag[2][1] = .5;
-    u.real[2][2] = .5; u.imag[2][2] =-.5;
-    
-    statevec_twoQubitUnitary(qureg, qb1, qb2, u);
+    statevec_twoQubitUnitary(qureg, qb1, qb2, getConjugateMatrix4(getSqrtSwapMatrix()));
 }
 
-/** applyConj=1 will apply conjugate operation, else applyConj=0 */
-void statevec_multiRotatePauli(
-    Qureg qureg, int* targetQubits, enum pauliOpType* targetPaulis, int numTargets, qreal angle,
-    int applyConj
+/* A Pauli product maps |i> to i^numY (-1)^|i & zMask| |i ^ xMask>, where xMask 
+ * contains the X and Y targets, and zMask the Y and Z targets 
+ */
+void getPauliProdMasks(int* targetQubits, enum pauliOpType* pauliCodes, int numTargets, 
+    long long int* xMask, long long int* zMask, int* numY
 ) {
-    qreal fac = 1/sqrt(2);
-    Complex uRxAlpha = {.real = fac, .imag = 0}; // Rx(pi/2)* rotates Z -> Y
-    Complex uRxBeta = {.real = 0, .imag = (applyConj)? fac : -fac};
-    Complex uRyAlpha = {.real = fac, .imag = 0}; // Ry(-pi/2) rotates Z -> X
-    Complex uRyBeta = {.real = -fac, .imag = 0};
-    
-    // mask may be modified to remove superfluous Identity ops
-    long long int mask = getQubitBitMask(targetQubits, numTargets);
-    
-    // rotate basis so that exp(Z) will effect exp(Y) and exp(X)
+    *xMask = 0;
+    *zMask = 0;
+    *numY = 0;
     for (int t=0; t < numTargets; t++) {
-        if (targetPaulis[t] == PAULI_I)
-            mask -= 1LL << targetQubits[t]; // remove target from mask
-        if (targetPaulis[t] == PAULI_X)
-            statevec_compactUnitary(qureg, targetQubits[t], uRyAlpha, uRyBeta);
-        if (targetPaulis[t] == PAULI_Y)
-            statevec_compactUnitary(qureg, targetQubits[t], uRxAlpha, uRxBeta);
-        // (targetPaulis[t] == 3) is Z basis
+        long long int bit = 1LL << targetQubits[t];
+        if (pauliCodes[t] == PAULI_X || pauliCodes[t] == PAULI_Y)
+            *xMask |= bit;
+        if (pauliCodes[t] == PAULI_Z || pauliCodes[t] == PAULI_Y)
+            *zMask |= bit;
+        if (pauliCodes[t] == PAULI_Y)
+            (*numY)++;
     }
+}
+
+/* the coefficient c i^numY of a Pauli product, so that its action is diagonal but for xMask */
+static void getPauliProdCoeff(qreal coeff, int numY, qreal* coeffRe, qreal* coeffIm) {
+    switch (numY % 4) {
+        case 0:  *coeffRe =  coeff; *coeffIm = 0;      break;
+        case 1:  *coeffRe = 0;      *coeffIm =  coeff; break;
+        case 2:  *coeffRe = -coeff; *coeffIm = 0;      break;
+        default: *coeffRe = 0;      *coeffIm = -coeff; break;
+    }
+}
+
+typedef struct {
+    long long int xMask, zMask;
+    qreal coeffRe, coeffIm;
+} PauliMaskTerm;
+
+static int comparePauliMaskTerms(const void* a, const void* b) {
+    const PauliMaskTerm* t1 = (const PauliMaskTerm*) a;
+    const PauliMaskTerm* t2 = (const PauliMaskTerm*) b;
+    if (t1->xMask != t2->xMask)
+        return (t1->xMask < t2->xMask)? -1 : 1;
+    if (t1->zMask != t2->zMask)
+        return (t1->zMask < t2->zMask)? -1 : 1;
+    return 0;
+}
+
+/* Encodes each term of a Pauli sum (upon every qubit) as its X and Z masks and its coefficient 
+ * c i^numY, then orders the terms by X mask, so that terms sharing an X mask (and so acting upon
+ * the same amplitude pairs) are contiguous. Terms with identical masks are merged into one, 
+ * by summing their coefficients. The output arrays must have length numSumTerms, and the 
+ * number of distinct terms written is returned, or -1 if memory for sorting could not be allocated.
+ */
+int getPauliSumMaskGroups(enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, int numQubits,
+    long long int* xMasks, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm
+) {
+    int targs[numQubits];
+    for (int q=0; q < numQubits; q++)
+        targs[q] = q;
     
-    // does nothing if there are no qubits to 'rotate'
-    if (mask != 0)
-        statevec_multiRotateZ(qureg, mask, (applyConj)? -angle : angle);
+    PauliMaskTerm* terms = malloc(numSumTerms * sizeof *terms);
+    if (terms == NULL)
+        return -1;
+    for (int t=0; t < numSumTerms; t++) {
+        int numY;
+        getPauliProdMasks(targs, &allCodes[t*numQubits], numQubits, &terms[t].xMask, &terms[t].zMask, &numY);
+        getPauliProdCoeff(termCoeffs[t], numY, &terms[t].coeffRe, &terms[t].coeffIm);
+    }
+    qsort(terms, numSumTerms, sizeof *terms, comparePauliMaskTerms);
     
-    // undo X and Y basis rotations
-    uRxBeta.imag *= -1;
-    uRyBeta.real *= -1;
-    for (int t=0; t < numTargets; t++) {
-        if (targetPaulis[t] == PAULI_X)
-            statevec_compactUnitary(qureg, targetQubits[t], uRyAlpha, uRyBeta);
-        if (targetPaulis[t] == PAULI_Y)
-            statevec_compactUnitary(qureg, targetQubits[t], uRxAlpha, uRxBeta);
+    int numDistinct = 0;
+    for (int t=0; t < numSumTerms; t++) {
+        int isRepeat = numDistinct > 0 && 
+            xMasks[numDistinct-1] == terms[t].xMask && zMasks[numDistinct-1] == terms[t].zMask;
+        if (isRepeat) {
+            coeffsRe[numDistinct-1] += terms[t].coeffRe;
+            coeffsIm[numDistinct-1] += terms[t].coeffIm;
+        } else {
+            xMasks[numDistinct] = terms[t].xMask;
+            zMasks[numDistinct] = terms[t].zMask;
+            coeffsRe[numDistinct] = terms[t].coeffRe;
+            coeffsIm[numDistinct] = terms[t].coeffIm;
+            numDistinct++;
+        }
     }
+    
+    free(terms);
+    return numDistinct;
 }
 
-/* produces both pauli|qureg> or pauli * qureg (as a density matrix) */
-void statevec_applyPauliProd(Qureg workspace, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets) {
+/* allocates the output arrays of getPauliSumMaskGroups (which the caller must free) and populates 
+ * them, else frees every buffer and reports an error if memory could not be allocated 
+ */
+static int createPauliSumMaskGroups(enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, int numQubits,
+    long long int** xMasks, long long int** zMasks, qreal** coeffsRe, qreal** coeffsIm, const char* caller
+) {
+    *xMasks = malloc(numSumTerms * sizeof **xMasks);
+    *zMasks = malloc(numSumTerms * sizeof **zMasks);
+    *coeffsRe = malloc(numSumTerms * sizeof **coeffsRe);
+    *coeffsIm = malloc(numSumTerms * sizeof **coeffsIm);
+    
+    int numTerms = -1;
+    if (*xMasks && *zMasks && *coeffsRe && *coeffsIm)
+        numTerms = getPauliSumMaskGroups(
+            allCodes, termCoeffs, numSumTerms, numQubits, *xMasks, *zMasks, *coeffsRe, *coeffsIm);
     
-    for (int i=0; i < numTargets; i++) {
-        // (pauliCodes[i] == PAULI_I) applies no operation
-        if (pauliCodes[i] == PAULI_X)
-            statevec_pauliX(workspace, targetQubits[i]);
-        if (pauliCodes[i] == PAULI_Y)
-            statevec_pauliY(workspace, targetQubits[i]);
-        if (pauliCodes[i] == PAULI_Z)
-            statevec_pauliZ(workspace, targetQubits[i]);
+    if (numTerms < 0) {
+        free(*xMasks);
+        free(*zMasks);
+        free(*coeffsRe);
+        free(*coeffsIm);
     }
+    validateMemoryAllocation(numTerms >= 0, caller);
+    return numTerms;
 }
 
-// <pauli> = <qureg|pauli|qureg> = qureg . pauli(qureg)
-qreal statevec_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets, Qureg workspace) {
+/** applies exp(-i angle/2 P) for the Pauli product P with the given masks, 
+ * or its conjugate if applyConj=1 
+ */
+static void multiRotatePauliMasks(
+    Qureg qureg, long long int xMask, long long int zMask, int numY, qreal angle, int applyConj
+) {
+    // a product of only Z (and identity) operators is diagonal, and does nothing if all identity
+    if (xMask == 0) {
+        if (zMask != 0)
+            statevec_multiRotateZ(qureg, zMask, (applyConj)? -angle : angle);
+        return;
+    }
     
-    statevec_cloneQureg(workspace, qureg);
-    statevec_applyPauliProd(workspace, targetQubits, pauliCodes, numTargets);
+    // exp(-i angle/2 P) = cos(angle/2) I - i sin(angle/2) P, and -i = i^3
+    Complex offDiagFac;
+    getPauliProdCoeff(sin(angle/2), numY + 3, &offDiagFac.real, &offDiagFac.imag);
+    if (applyConj)
+        offDiagFac.imag *= -1;
+    
+    statevec_multiRotatePauliMasks(qureg, xMask, zMask, cos(angle/2), offDiagFac);
+}
+
+/** applyConj=1 will apply conjugate operation, else applyConj=0 */
+void statevec_multiRotatePauli(
+    Qureg qureg, int* targetQubits, enum pauliOpType* targetPaulis, int numTargets, qreal angle,
+    int applyConj
+) {
+    long long int xMask, zMask;
+    int numY;
+    getPauliProdMasks(targetQubits, targetPaulis, numTargets, &xMask, &zMask, &numY);
+    multiRotatePauliMasks(qureg, xMask, zMask, numY, angle, applyConj);
+}
+
+/* <pauli> = <qureg|pauli|qureg> or Trace(pauli qureg), computed in a single 
+ * read-only pass over qureg without modifying it, nor needing a workspace
+ */
+qreal statevec_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets) {
+    
+    long long int xMask, zMask;
+    int numY;
+    getPauliProdMasks(targetQubits, pauliCodes, numTargets, &xMask, &zMask, &numY);
+    
+    qreal coeffRe, coeffIm;
+    getPauliProdCoeff(1, numY, &coeffRe, &coeffIm);
     
-    // compute the expected value
-    qreal value;
     if (qureg.isDensityMatrix)
-        value = densmatr_calcTotalProb(workspace); // Trace(ops qureg)
+        return densmatr_calcExpecPauliMasks(qureg, xMask, &zMask, &coeffRe, &coeffIm, 1);
     else
-        value = statevec_calcInnerProduct(workspace, qureg).real; // <qureg|ops|qureg>
-                
-    return value;
+        return statevec_calcExpecPauliMasks(qureg, xMask, &zMask, &coeffRe, &coeffIm, 1);
 }
 
-qreal statevec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace) {
+/* terms are grouped by their X masks, and each group is evaluated in a single pass,
+ * so that the number of passes is the number of distinct X masks, not terms 
+ */
+qreal statevec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms) {
+    
+    long long int *xMasks, *zMasks;
+    qreal *coeffsRe, *coeffsIm;
+    int numTerms = createPauliSumMaskGroups(allCodes, termCoeffs, numSumTerms, qureg.numQubitsRepresented, 
+        &xMasks, &zMasks, &coeffsRe, &coeffsIm, __func__);
     
-    int numQb = qureg.numQubitsRepresented;
-    int targs[numQb];
-    for (int q=0; q < numQb; q++)
-        targs[q] = q;
-        
     qreal value = 0;
-    for (int t=0; t < numSumTerms; t++)
-        value += termCoeffs[t] * statevec_calcExpecPauliProd(qureg, targs, &allCodes[t*numQb], numQb, workspace);
+    int groupEnd;
+    for (int groupStart=0; groupStart < numTerms; groupStart=groupEnd) {
+        for (groupEnd=groupStart; groupEnd < numTerms && xMasks[groupEnd] == xMasks[groupStart]; groupEnd++)
+            ;
         
+        if (qureg.isDensityMatrix)
+            value += densmatr_calcExpecPauliMasks(qureg, xMasks[groupStart], &zMasks[groupStart], 
+                &coeffsRe[groupStart], &coeffsIm[groupStart], groupEnd - groupStart);
+        else
+            value += statevec_calcExpecPauliMasks(qureg, xMasks[groupStart], &zMasks[groupStart], 
+                &coeffsRe[groupStart], &coeffsIm[groupStart], groupEnd - groupStart);
+    }
+    
+    free(xMasks);
+    free(zMasks);
+    free(coeffsRe);
+    free(coeffsIm);
     return value;
 }
 
+/* outQureg = sum_t c_t paulis_t(inQureg), where terms sharing an X mask are applied together 
+ * in a single pass, and inQureg is only read
+ */
 void statevec_applyPauliSum(Qureg inQureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, Qureg outQureg) {
     
-    int numQb = inQureg.numQubitsRepresented;
-    int targs[numQb];
-    for (int q=0; q < numQb; q++)
-        targs[q] = q;
-        
+    long long int *xMasks, *zMasks;
+    qreal *coeffsRe, *coeffsIm;
+    int numTerms = createPauliSumMaskGroups(allCodes, termCoeffs, numSumTerms, inQureg.numQubitsRepresented, 
+        &xMasks, &zMasks, &coeffsRe, &coeffsIm, __func__);
+    
     statevec_initBlankState(outQureg);
     
-    for (int t=0; t < numSumTerms; t++) {
-        Complex coef = (Complex) {.real=termCoeffs[t], .imag=0};
-        Complex iden = (Complex) {.real=1, .imag=0};
-        Complex zero = (Complex) {.real=0, .imag=0};
-        
-        // outQureg += coef paulis(inQureg)
-        statevec_applyPauliProd(inQureg, targs, &allCodes[t*numQb], numQb);
-        statevec_setWeightedQureg(coef, inQureg, iden, outQureg, zero, outQureg); 
+    int groupEnd;
+    for (int groupStart=0; groupStart < numTerms; groupStart=groupEnd) {
+        for (groupEnd=groupStart; groupEnd < numTerms && xMasks[groupEnd] == xMasks[groupStart]; groupEnd++)
+            ;
         
-        // undero paulis(inQureg), exploiting XX=YY=ZZ=I
-        statevec_applyPauliProd(inQureg, targs, &allCodes[t*numQb], numQb);
+        // (a density matrix is left-multiplied, as if a statevector with the paulis on its lower qubits)
+        statevec_applyPauliMasks(inQureg, xMasks[groupStart], &zMasks[groupStart], 
+            &coeffsRe[groupStart], &coeffsIm[groupStart], groupEnd - groupStart, outQureg);
     }
+    
+    free(xMasks);
+    free(zMasks);
+    free(coeffsRe);
+    free(coeffsIm);
 }
 
 void statevec_twoQubitUnitary(Qureg qureg, int targetQubit1, int targetQubit2, ComplexMatrix4 u) {
@@ -560,7 +900,7 @@ void statevec_controlledMultiQubitUnitary(Qureg qureg, int ctrl, int* targets, i
                             ops[n].imag[i][j]*ops[n].real[k][l];  \
                     } 
 
-void populateKrausSuperOperator2(ComplexMatrix4* superOp, ComplexMatrix2* ops, int numOps) {
+void populateKrausSuperOperator2(ComplexMatrixN* superOp, ComplexMatrix2* ops, int numOps) {
     int opDim = 2;
     macro_populateKrausOperator(superOp, ops, numOps, opDim);
 }
@@ -573,37 +913,6 @@ void populateKrausSuperOperatorN(ComplexMatrixN* superOp, ComplexMatrixN* ops, i
     macro_populateKrausOperator(superOp, ops, numOps, opDim);
 }
 
-void densmatr_applyKrausSuperoperator(Qureg qureg, int target, ComplexMatrix4 superOp) {
-        
-    long long int ctrlMask = 0;
-    statevec_multiControlledTwoQubitUnitary(qureg, ctrlMask, target, target + qureg.numQubitsRepresented, superOp);
-}
-
-void densmatr_applyTwoQubitKrausSuperoperator(Qureg qureg, int target1, int target2, ComplexMatrixN superOp) {
-
-    long long int ctrlMask = 0;
-    int numQb = qureg.numQubitsRepresented;
-    int allTargets[4] = {target1, target2, target1+numQb, target2+numQb};
-    statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask, allTargets, 4, superOp);
-}
-
-void densmatr_applyMultiQubitKrausSuperoperator(Qureg qureg, int *targets, int numTargets, ComplexMatrixN superOp) {
-    long long int ctrlMask = 0;
-    int allTargets[2*numTargets];
-    for (int t=0; t < numTargets; t++) {
-        allTargets[t] = targets[t];
-        allTargets[t+numTargets] = targets[t] + qureg.numQubitsRepresented;
-    }
-    statevec_multiControlledMultiQubitUnitary(qureg, ctrlMask, allTargets, 2*numTargets, superOp);
-}
-
-void densmatr_mixKrausMap(Qureg qureg, int target, ComplexMatrix2 *ops, int numOps) {
-        
-    ComplexMatrix4 superOp; 
-    populateKrausSuperOperator2(&superOp, ops, numOps);
-    densmatr_applyKrausSuperoperator(qureg, target, superOp);
-}
-
 ComplexMatrixN bindArraysToStackComplexMatrixN(
     int numQubits, qreal re[][1<<numQubits], qreal im[][1<<numQubits], 
     qreal** reStorage, qreal** imStorage
@@ -632,12 +941,21 @@ ComplexMatrixN bindArraysToStackComplexMatrixN(
     qreal imArr_[1<<(numQubits)][1<<(numQubits)]; \
     macro_initialiseStackComplexMatrixN(matrix, (numQubits), reArr_, imArr_);
 
+void densmatr_mixKrausMap(Qureg qureg, int target, ComplexMatrix2 *ops, int numOps) {
+    
+    ComplexMatrixN superOp;
+    macro_allocStackComplexMatrixN(superOp, 2);
+    populateKrausSuperOperator2(&superOp, ops, numOps);
+    densmatr_applyMultiQubitKrausSuperoperator(qureg, &target, 1, superOp);
+}
+
 void densmatr_mixTwoQubitKrausMap(Qureg qureg, int target1, int target2, ComplexMatrix4 *ops, int numOps) {
     
     ComplexMatrixN superOp;
     macro_allocStackComplexMatrixN(superOp, 4);
     populateKrausSuperOperator4(&superOp, ops, numOps);
-    densmatr_applyTwoQubitKrausSuperoperator(qureg, target1, target2, superOp);
+    int targets[2] = {target1, target2};
+    densmatr_applyMultiQubitKrausSuperoperator(qureg, targets, 2, superOp);
 }
 
 void densmatr_mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps) {
@@ -673,6 +991,86 @@ void densmatr_mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, C
     }
 }
 
+/* Unitaries upon at most this many targets are applied to density matrices as U rho U^dagger in 
+ * a single pass over the state. Beyond it, the per-element cost of multiplying each 4^numTargets 
+ * block by U and U^dagger outgrows the memory traffic saved, so U and U^* are applied in turn.
+ */
+#define MAX_NUM_FUSED_DENSMATR_TARGETS 3
+
+void densmatr_multiQubitUnitary(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u) {
+    
+    if (numTargets <= MAX_NUM_FUSED_DENSMATR_TARGETS) {
+        densmatr_applyMultiQubitUnitary(qureg, targets, numTargets, u);
+        return;
+    }
+    
+    int shift = qureg.numQubitsRepresented;
+    statevec_multiQubitUnitary(qureg, targets, numTargets, u);
+    shiftIndices(targets, numTargets, shift);
+    setConjugateMatrixN(u);
+    statevec_multiQubitUnitary(qureg, targets, numTargets, u);
+    shiftIndices(targets, numTargets, -shift);
+    setConjugateMatrixN(u);
+}
+
+void densmatr_unitary(Qureg qureg, int targetQubit, ComplexMatrix2 u) {
+    
+    ComplexMatrixN m;
+    macro_initialiseStackComplexMatrixN(m, 1, u.real, u.imag);
+    densmatr_applyMultiQubitUnitary(qureg, &targetQubit, 1, m);
+}
+
+void densmatr_twoQubitUnitary(Qureg qureg, int targetQubit1, int targetQubit2, ComplexMatrix4 u) {
+    
+    ComplexMatrixN m;
+    macro_initialiseStackComplexMatrixN(m, 2, u.real, u.imag);
+    int targets[2] = {targetQubit1, targetQubit2};
+    densmatr_applyMultiQubitUnitary(qureg, targets, 2, m);
+}
+
+void densmatr_compactUnitary(Qureg qureg, int targetQubit, Complex alpha, Complex beta) {
+    
+    ComplexMatrix2 u = {
+        .real = {{alpha.real, -beta.real}, {beta.real, alpha.real}},
+        .imag = {{alpha.imag,  beta.imag}, {beta.imag, -alpha.imag}}
+    };
+    densmatr_unitary(qureg, targetQubit, u);
+}
+
+void densmatr_rotateAroundAxis(Qureg qureg, int rotQubit, qreal angle, Vector axis) {
+    
+    Complex alpha, beta;
+    getComplexPairFromRotation(angle, axis, &alpha, &beta);
+    densmatr_compactUnitary(qureg, rotQubit, alpha, beta);
+}
+
+void densmatr_rotateX(Qureg qureg, int rotQubit, qreal angle) {
+    
+    Vector unitAxis = {1, 0, 0};
+    densmatr_rotateAroundAxis(qureg, rotQubit, angle, unitAxis);
+}
+
+void densmatr_rotateY(Qureg qureg, int rotQubit, qreal angle) {
+    
+    Vector unitAxis = {0, 1, 0};
+    densmatr_rotateAroundAxis(qureg, rotQubit, angle, unitAxis);
+}
+
+void densmatr_hadamard(Qureg qureg, int targetQubit) {
+    
+    qreal fac = 1/sqrt(2);
+    ComplexMatrix2 u = {
+        .real = {{fac, fac}, {fac, -fac}},
+        .imag = {{0}}
+    };
+    densmatr_unitary(qureg, targetQubit, u);
+}
+
+void densmatr_sqrtSwapGate(Qureg qureg, int qb1, int qb2) {
+    
+    densmatr_twoQubitUnitary(qureg, qb1, qb2, getSqrtSwapMatrix());
+}
+
 void densmatr_mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal probZ) {
     
     // convert pauli probabilities into Kraus map
@@ -695,88 +1093,266 @@ void densmatr_mixPauli(Qureg qureg, int qubit, qreal probX, qreal probY, qreal p
     densmatr_mixKrausMap(qureg, qubit, ops, numOps);
 }
 
-void applyExponentiatedPauliHamil(Qureg qureg, PauliHamil hamil, qreal fac, int reverse) {
+static int getNumSetBits(long long int mask) {
+    int num = 0;
+    for (; mask != 0; mask &= mask - 1)
+        num++;
+    return num;
+}
+
+/* two Pauli products commute if they differ by anti-commuting X/Y/Z upon an even number of qubits */
+static int isCommutingPauliProd(long long int xMask1, long long int zMask1, long long int xMask2, long long int zMask2) {
+    return (getNumSetBits((xMask1 & zMask2) ^ (zMask1 & xMask2)) % 2) == 0;
+}
+
+typedef struct {
+    TrotterPlan plan;
+    int capacity;
+    // the Hamiltonian terms as masks, and their coefficients
+    long long int *xMasks, *zMasks;
+    qreal *coeffs;
+    int numHamilTerms;
+} TrotterPlanBuilder;
+
+/* frees the builder's buffers (including the unfinished plan) and reports an error, 
+ * unless every reallocation of the plan succeeded */
+static void validateTrotterPlanBuilderAlloc(TrotterPlanBuilder* b, int isAllocated, const char* caller) {
+    if (!isAllocated) {
+        free(b->xMasks);
+        free(b->zMasks);
+        free(b->plan.xMasks);
+        free(b->plan.zMasks);
+        free(b->plan.angles);
+    }
+    validateMemoryAllocation(isAllocated, caller);
+}
+
+/* Appends the rotation exp(-i angle/2 P) to the plan. The preceding rotations are searched 
+ * backward (no further than the number of Hamiltonian terms) while they commute with P, so that
+ * P can be exactly merged into an earlier rotation of the same product, or moved beside the 
+ * nearest earlier diagonal rotation if P is itself diagonal. 
+ */
+static void appendTrotterPlanTerm(TrotterPlanBuilder* b, long long int xMask, long long int zMask, qreal angle) {
     
-    /* applies a first-order one-repetition approximation of exp(-i fac H)
-     * to qureg. Letting H = sum_j c_j h_j, it does this via 
-     * exp(-i fac H) ~ prod_j exp(-i fac c_j h_j), where each inner exp 
-     * is performed with multiRotatePauli (with pre-factor 2).
-     */
-     
-    // prepare targets for multiRotatePauli 
-    // (all qubits; actual targets are determined by Pauli codes)
-    int vecTargs[hamil.numQubits];
-    int densTargs[hamil.numQubits];
-    for (int q=0; q<hamil.numQubits; q++) {
-        vecTargs[q] = q;
-        densTargs[q] = q + hamil.numQubits;
+    TrotterPlan* plan = &b->plan;
+    int insertInd = plan->numTerms;
+    int foundDiag = 0;
+    
+    int stopInd = plan->numTerms - b->numHamilTerms;
+    if (stopInd < 0)
+        stopInd = 0;
+    
+    for (int t=plan->numTerms-1; t >= stopInd; t--) {
+        if (plan->xMasks[t] == xMask && plan->zMasks[t] == zMask) {
+            plan->angles[t] += angle;
+            return;
+        }
+        if (xMask == 0 && plan->xMasks[t] == 0 && !foundDiag) {
+            insertInd = t + 1;
+            foundDiag = 1;
+        }
+        if (!isCommutingPauliProd(xMask, zMask, plan->xMasks[t], plan->zMasks[t]))
+            break;
     }
+    
+    if (plan->numTerms == b->capacity) {
+        b->capacity *= 2;
+        
+        // a failed realloc leaves the original buffer intact (and to be freed)
+        long long int* newXMasks = realloc(plan->xMasks, b->capacity * sizeof *plan->xMasks);
+        if (newXMasks != NULL)
+            plan->xMasks = newXMasks;
+        long long int* newZMasks = realloc(plan->zMasks, b->capacity * sizeof *plan->zMasks);
+        if (newZMasks != NULL)
+            plan->zMasks = newZMasks;
+        qreal* newAngles = realloc(plan->angles, b->capacity * sizeof *plan->angles);
+        if (newAngles != NULL)
+            plan->angles = newAngles;
+        validateTrotterPlanBuilderAlloc(b, newXMasks && newZMasks && newAngles, __func__);
+    }
+    
+    int numMoved = plan->numTerms - insertInd;
+    memmove(&plan->xMasks[insertInd+1], &plan->xMasks[insertInd], numMoved * sizeof *plan->xMasks);
+    memmove(&plan->zMasks[insertInd+1], &plan->zMasks[insertInd], numMoved * sizeof *plan->zMasks);
+    memmove(&plan->angles[insertInd+1], &plan->angles[insertInd], numMoved * sizeof *plan->angles);
+    plan->xMasks[insertInd] = xMask;
+    plan->zMasks[insertInd] = zMask;
+    plan->angles[insertInd] = angle;
+    plan->numTerms++;
+}
 
-    for (int i=0; i<hamil.numSumTerms; i++) {
+static void appendExponentiatedPauliHamil(TrotterPlanBuilder* b, qreal fac, int reverse) {
+    
+    /* appends a first-order one-repetition approximation of exp(-i fac H).
+     * Letting H = sum_j c_j h_j, it does this via exp(-i fac H) ~ prod_j exp(-i fac c_j h_j), 
+     * where each inner exp is a multiRotatePauli (with pre-factor 2). Identity terms 
+     * effect only a global phase, and are omitted.
+     */
+    for (int i=0; i<b->numHamilTerms; i++) {
         
         int t=i;
         if (reverse)
-            t=hamil.numSumTerms-1-i;
-            
-        qreal angle = 2*fac*hamil.termCoeffs[t];
+            t=b->numHamilTerms-1-i;
         
-        statevec_multiRotatePauli(
-            qureg, vecTargs, &(hamil.pauliCodes[t*hamil.numQubits]), 
-            hamil.numQubits, angle, 0);
-        
-        if (qureg.isDensityMatrix)
-            statevec_multiRotatePauli(
-                qureg, densTargs, &(hamil.pauliCodes[t*hamil.numQubits]), 
-                hamil.numQubits, angle, 1);
-        
-        // record qasm      
-        char buff[1024];
-        int b=0;
-        for (int q=0; q<hamil.numQubits; q++) {
-            enum pauliOpType op = hamil.pauliCodes[q + t*hamil.numQubits];
+        if (b->xMasks[t] == 0 && b->zMasks[t] == 0)
+            continue;
             
-            char p = 'I';
-            if (op == PAULI_X) p = 'X';
-            if (op == PAULI_Y) p = 'Y';
-            if (op == PAULI_Z) p = 'Z';
-            buff[b++] = p;
-            buff[b++] = ' ';
-        }
-        buff[b] = '\0';
-        
-        qasm_recordComment(qureg, 
-            "Here, a multiRotatePauli with angle %g and paulis %s was applied.",
-            angle, buff);
+        appendTrotterPlanTerm(b, b->xMasks[t], b->zMasks[t], 2*fac*b->coeffs[t]);
     }
 }
 
-void applySymmetrizedTrotterCircuit(Qureg qureg, PauliHamil hamil, qreal time, int order) {
+static void appendSymmetrizedTrotterCircuit(TrotterPlanBuilder* b, qreal time, int order) {
     
     if (order == 1) {
-        applyExponentiatedPauliHamil(qureg, hamil, time, 0);
+        appendExponentiatedPauliHamil(b, time, 0);
     }
     else if (order == 2) {
-        applyExponentiatedPauliHamil(qureg, hamil, time/2., 0);
-        applyExponentiatedPauliHamil(qureg, hamil, time/2., 1);
+        appendExponentiatedPauliHamil(b, time/2., 0);
+        appendExponentiatedPauliHamil(b, time/2., 1);
     }
     else {
         qreal p = 1. / (4 - pow(4, 1./(order-1)));
         int lower = order-2;
-        applySymmetrizedTrotterCircuit(qureg, hamil, p*time, lower);
-        applySymmetrizedTrotterCircuit(qureg, hamil, p*time, lower);
-        applySymmetrizedTrotterCircuit(qureg, hamil, (1-4*p)*time, lower);
-        applySymmetrizedTrotterCircuit(qureg, hamil, p*time, lower);
-        applySymmetrizedTrotterCircuit(qureg, hamil, p*time, lower);
+        appendSymmetrizedTrotterCircuit(b, p*time, lower);
+        appendSymmetrizedTrotterCircuit(b, p*time, lower);
+        appendSymmetrizedTrotterCircuit(b, (1-4*p)*time, lower);
+        appendSymmetrizedTrotterCircuit(b, p*time, lower);
+        appendSymmetrizedTrotterCircuit(b, p*time, lower);
     }
 }
 
-void agnostic_applyTrotterCircuit(Qureg qureg, PauliHamil hamil, qreal time, int order, int reps) {
+TrotterPlan agnostic_createTrotterPlan(PauliHamil hamil, qreal time, int order, int reps) {
+    
+    TrotterPlanBuilder b;
+    b.numHamilTerms = hamil.numSumTerms;
+    b.coeffs = hamil.termCoeffs;
+    b.xMasks = malloc(hamil.numSumTerms * sizeof *b.xMasks);
+    b.zMasks = malloc(hamil.numSumTerms * sizeof *b.zMasks);
+    
+    b.capacity = hamil.numSumTerms;
+    b.plan.numQubits = hamil.numQubits;
+    b.plan.numTerms = 0;
+    b.plan.xMasks = malloc(b.capacity * sizeof *b.plan.xMasks);
+    b.plan.zMasks = malloc(b.capacity * sizeof *b.plan.zMasks);
+    b.plan.angles = malloc(b.capacity * sizeof *b.plan.angles);
     
-    if (time == 0)
+    // every buffer is checked before any is written
+    int isAllocated = b.xMasks && b.zMasks && b.plan.xMasks && b.plan.zMasks && b.plan.angles;
+    if (!isAllocated) {
+        free(b.xMasks);
+        free(b.zMasks);
+        free(b.plan.xMasks);
+        free(b.plan.zMasks);
+        free(b.plan.angles);
+    }
+    validateMemoryAllocation(isAllocated, __func__);
+    
+    int targs[hamil.numQubits];
+    for (int q=0; q<hamil.numQubits; q++)
+        targs[q] = q;
+    for (int t=0; t<hamil.numSumTerms; t++) {
+        int numY;
+        getPauliProdMasks(targs, &hamil.pauliCodes[t*hamil.numQubits], hamil.numQubits, 
+            &b.xMasks[t], &b.zMasks[t], &numY);
+    }
+    
+    if (time != 0)
+        for (int r=0; r<reps; r++)
+            appendSymmetrizedTrotterCircuit(&b, time/reps, order);
+    
+    free(b.xMasks);
+    free(b.zMasks);
+    return b.plan;
+}
+
+static void recordTrotterPlanTerm(Qureg qureg, TrotterPlan plan, int t) {
+    
+    // avoid formatting the comment when it will not be recorded
+    if (!qureg.qasmLog->isLogging)
         return;
     
-    for (int r=0; r<reps; r++)
-        applySymmetrizedTrotterCircuit(qureg, hamil, time/reps, order);
+    char buff[2*plan.numQubits + 1];
+    int b=0;
+    for (int q=0; q<plan.numQubits; q++) {
+        int isX = (plan.xMasks[t] >> q) & 1;
+        int isZ = (plan.zMasks[t] >> q) & 1;
+        
+        char p = 'I';
+        if (isX && isZ) p = 'Y';
+        else if (isX)   p = 'X';
+        else if (isZ)   p = 'Z';
+        buff[b++] = p;
+        buff[b++] = ' ';
+    }
+    buff[b] = '\0';
+    
+    qasm_recordComment(qureg, 
+        "Here, a multiRotatePauli with angle %g and paulis %s was applied.",
+        plan.angles[t], buff);
+}
+
+/* each run of consecutive diagonal rotations in the plan is applied in a single pass */
+void agnostic_applyTrotterPlan(Qureg qureg, TrotterPlan plan) {
+    
+    int shift = plan.numQubits;
+    int numPerTerm = (qureg.isDensityMatrix)? 2 : 1;
+    
+    // find the longest run of diagonal rotations
+    int maxRunLen = 0;
+    int runLen = 0;
+    for (int t=0; t<plan.numTerms; t++) {
+        runLen = (plan.xMasks[t] == 0)? runLen + 1 : 0;
+        if (runLen > maxRunLen)
+            maxRunLen = runLen;
+    }
+    long long int* parityMasks = NULL;
+    qreal* parityAngles = NULL;
+    if (maxRunLen > 0) {
+        parityMasks = malloc(numPerTerm * maxRunLen * sizeof *parityMasks);
+        parityAngles = malloc(numPerTerm * maxRunLen * sizeof *parityAngles);
+        if (!parityMasks || !parityAngles) {
+            free(parityMasks);
+            free(parityAngles);
+        }
+        validateMemoryAllocation(parityMasks && parityAngles, __func__);
+    }
+    
+    int t=0;
+    while (t < plan.numTerms) {
+        
+        if (plan.xMasks[t] != 0) {
+            long long int xMask = plan.xMasks[t];
+            long long int zMask = plan.zMasks[t];
+            int numY = getNumSetBits(xMask & zMask);
+            
+            multiRotatePauliMasks(qureg, xMask, zMask, numY, plan.angles[t], 0);
+            if (qureg.isDensityMatrix)
+                multiRotatePauliMasks(qureg, xMask << shift, zMask << shift, numY, plan.angles[t], 1);
+            
+            recordTrotterPlanTerm(qureg, plan, t);
+            t++;
+            continue;
+        }
+        
+        int numParityTerms = 0;
+        for (; t < plan.numTerms && plan.xMasks[t] == 0; t++) {
+            parityMasks[numParityTerms] = plan.zMasks[t];
+            parityAngles[numParityTerms++] = plan.angles[t];
+            if (qureg.isDensityMatrix) {
+                parityMasks[numParityTerms] = plan.zMasks[t] << shift;
+                parityAngles[numParityTerms++] = - plan.angles[t];
+            }
+            recordTrotterPlanTerm(qureg, plan, t);
+        }
+        
+        if (numParityTerms == 1)
+            statevec_multiRotateZ(qureg, parityMasks[0], parityAngles[0]);
+        else
+            statevec_applyDiagonalPhases(qureg, NULL, NULL, 0, parityMasks, parityAngles, numParityTerms);
+    }
+    
+    free(parityMasks);
+    free(parityAngles);
 }
 
 #ifdef __cplusplus
@@ -31,8 +31,9 @@ void initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome);
  */
 void initStateDebug(Qureg qureg);
 
-/** Initialises the wavefunction amplitudes according to those specified in a file.
- * For debugging purpsoses 
+/** Initialises the wavefunction amplitudes according to those specified in a file,
+ * which must contain a line "real, imag" for every amplitude, in order. Lines beginning 
+ * with '#' are ignored. For debugging purpsoses 
  */
 void initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env);
 
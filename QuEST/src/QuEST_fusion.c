@@ -0,0 +1,624 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Greedy fusion of consecutive unitaries into a single dense multi-qubit matrix.
+ * Gates are left-multiplied onto a pending matrix (kept in a GateFusionBuffer
+ * attached to the Qureg) until a gate would grow it beyond maxNumQubits, at which
+ * point the pending matrix is applied to the state with one multi-qubit unitary,
+ * i.e. one pass over the state-vector, and a new matrix is begun.
+ *
+ * The qubits of the pending matrix are stored in the order of its index bits;
+ * qubits newly touched by a gate are appended, which embeds the existing matrix
+ * as the block-diagonal (Id (x) M) without re-ordering its elements.
+ *
+ * When cache blocking is enabled, completed matrices upon only low qubits are
+ * instead copied into a queue, which is applied to one cache-sized block of the
+ * state at a time by statevec_multiQubitUnitarySequence, when the queue fills
+ * or a matrix upon a high qubit (or any other state access) forces a flush.
+ *
+ * Diagonal gates not upon only the pending qubits are accumulated as phase terms,
+ * which take effect after the pending matrix (and queue), and are applied in a
+ * single pass by statevec_applyDiagonalPhases. Since diagonal gates commute, a
+ * diagonal gate upon only pending qubits can still be fused into the pending
+ * matrix, but any other gate must first apply the accumulated terms.
+ */
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+# include "QuEST_internal.h"
+# include "QuEST_fusion.h"
+# include "QuEST_validation.h"
+
+# include <math.h>
+# include <stdio.h>
+# include <stdlib.h>
+
+/** The maximum number of fused matrices queued for a cache-blocked application */
+# define MAX_NUM_QUEUED_MATRICES 32
+
+/** The maximum number of each kind of diagonal term accumulated before they are applied */
+# define MAX_NUM_DIAGONAL_TERMS 64
+
+void fusion_setup(Qureg* qureg) {
+
+    GateFusionBuffer *buf = malloc(sizeof *buf);
+    validateMemoryAllocation(buf != NULL, __func__);
+
+    buf->isFusing = 0;
+    buf->maxNumQubits = 0;
+    buf->numQubits = 0;
+    buf->qubits = NULL;
+    buf->real = NULL;
+    buf->imag = NULL;
+    buf->workReal = NULL;
+    buf->workImag = NULL;
+    buf->realRows = NULL;
+    buf->imagRows = NULL;
+    buf->numBlockQubits = 0;
+    buf->numQueued = 0;
+    buf->numQueuedQubits = 0;
+    buf->queuedNumQubits = NULL;
+    buf->queuedQubits = NULL;
+    buf->queuedReal = NULL;
+    buf->queuedImag = NULL;
+    buf->queuedRealRows = NULL;
+    buf->queuedImagRows = NULL;
+    buf->numPhaseTerms = 0;
+    buf->numParityTerms = 0;
+    buf->phaseMasks = NULL;
+    buf->phaseAngles = NULL;
+    buf->parityMasks = NULL;
+    buf->parityAngles = NULL;
+    qureg->fusionBuffer = buf;
+}
+
+static void freeFusionMatrices(GateFusionBuffer* buf) {
+    free(buf->qubits);
+    free(buf->real);
+    free(buf->imag);
+    free(buf->workReal);
+    free(buf->workImag);
+    free(buf->realRows);
+    free(buf->imagRows);
+    free(buf->queuedNumQubits);
+    free(buf->queuedQubits);
+    free(buf->queuedReal);
+    free(buf->queuedImag);
+    free(buf->queuedRealRows);
+    free(buf->queuedImagRows);
+    free(buf->phaseMasks);
+    free(buf->phaseAngles);
+    free(buf->parityMasks);
+    free(buf->parityAngles);
+    buf->qubits = NULL;
+    buf->real = NULL;
+    buf->imag = NULL;
+    buf->workReal = NULL;
+    buf->workImag = NULL;
+    buf->realRows = NULL;
+    buf->imagRows = NULL;
+    buf->queuedNumQubits = NULL;
+    buf->queuedQubits = NULL;
+    buf->queuedReal = NULL;
+    buf->queuedImag = NULL;
+    buf->queuedRealRows = NULL;
+    buf->queuedImagRows = NULL;
+    buf->phaseMasks = NULL;
+    buf->phaseAngles = NULL;
+    buf->parityMasks = NULL;
+    buf->parityAngles = NULL;
+}
+
+void fusion_free(Qureg qureg) {
+    freeFusionMatrices(qureg.fusionBuffer);
+    free(qureg.fusionBuffer);
+}
+
+/** sets the pending matrix to the 0-qubit identity */
+static void clearPendingMatrix(GateFusionBuffer* buf) {
+    buf->numQubits = 0;
+    buf->real[0] = 1;
+    buf->imag[0] = 0;
+}
+
+void fusion_start(Qureg qureg, int maxNumQubits, int numBlockQubits) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+
+    // apply any pending gates before the buffers are resized
+    fusion_flush(qureg);
+    freeFusionMatrices(buf);
+
+    long long int dim = 1LL << maxNumQubits;
+    buf->qubits   = malloc(maxNumQubits * sizeof *(buf->qubits));
+    buf->real     = malloc(dim * dim * sizeof *(buf->real));
+    buf->imag     = malloc(dim * dim * sizeof *(buf->imag));
+    buf->workReal = malloc(dim * dim * sizeof *(buf->workReal));
+    buf->workImag = malloc(dim * dim * sizeof *(buf->workImag));
+    buf->realRows = malloc(dim * sizeof *(buf->realRows));
+    buf->imagRows = malloc(dim * sizeof *(buf->imagRows));
+    validateMemoryAllocation(
+        buf->qubits && buf->real && buf->imag && buf->workReal &&
+        buf->workImag && buf->realRows && buf->imagRows, __func__);
+
+    buf->phaseMasks   = malloc(MAX_NUM_DIAGONAL_TERMS * sizeof *(buf->phaseMasks));
+    buf->phaseAngles  = malloc(MAX_NUM_DIAGONAL_TERMS * sizeof *(buf->phaseAngles));
+    buf->parityMasks  = malloc(MAX_NUM_DIAGONAL_TERMS * sizeof *(buf->parityMasks));
+    buf->parityAngles = malloc(MAX_NUM_DIAGONAL_TERMS * sizeof *(buf->parityAngles));
+    validateMemoryAllocation(
+        buf->phaseMasks && buf->phaseAngles && buf->parityMasks && buf->parityAngles, __func__);
+
+    if (numBlockQubits > 0) {
+        long long int cap = MAX_NUM_QUEUED_MATRICES;
+        buf->queuedNumQubits = malloc(cap * sizeof *(buf->queuedNumQubits));
+        buf->queuedQubits    = malloc(cap * maxNumQubits * sizeof *(buf->queuedQubits));
+        buf->queuedReal      = malloc(cap * dim * dim * sizeof *(buf->queuedReal));
+        buf->queuedImag      = malloc(cap * dim * dim * sizeof *(buf->queuedImag));
+        buf->queuedRealRows  = malloc(cap * dim * sizeof *(buf->queuedRealRows));
+        buf->queuedImagRows  = malloc(cap * dim * sizeof *(buf->queuedImagRows));
+        validateMemoryAllocation(
+            buf->queuedNumQubits && buf->queuedQubits && buf->queuedReal &&
+            buf->queuedImag && buf->queuedRealRows && buf->queuedImagRows, __func__);
+    }
+
+    buf->numBlockQubits = numBlockQubits;
+    buf->numQueued = 0;
+    buf->numQueuedQubits = 0;
+    buf->numPhaseTerms = 0;
+    buf->numParityTerms = 0;
+    buf->maxNumQubits = maxNumQubits;
+    buf->isFusing = 1;
+    clearPendingMatrix(buf);
+}
+
+void fusion_stop(Qureg qureg) {
+    fusion_flush(qureg);
+    freeFusionMatrices(qureg.fusionBuffer);
+    qureg.fusionBuffer->isFusing = 0;
+    qureg.fusionBuffer->maxNumQubits = 0;
+    qureg.fusionBuffer->numQubits = 0;
+    qureg.fusionBuffer->numBlockQubits = 0;
+}
+
+void fusion_discard(Qureg qureg) {
+    if (qureg.fusionBuffer->isFusing) {
+        clearPendingMatrix(qureg.fusionBuffer);
+        qureg.fusionBuffer->numQueued = 0;
+        qureg.fusionBuffer->numQueuedQubits = 0;
+        qureg.fusionBuffer->numPhaseTerms = 0;
+        qureg.fusionBuffer->numParityTerms = 0;
+    }
+}
+
+/** applies the pending matrix directly to the state */
+static void applyPendingMatrix(Qureg qureg) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+
+    // bind the flat pending matrix to a ComplexMatrixN
+    int numTargs = buf->numQubits;
+    long long int dim = 1LL << numTargs;
+    ComplexMatrixN u;
+    u.numQubits = numTargs;
+    u.real = buf->realRows;
+    u.imag = buf->imagRows;
+    for (long long int r=0; r < dim; r++) {
+        u.real[r] = &(buf->real[r*dim]);
+        u.imag[r] = &(buf->imag[r*dim]);
+    }
+
+    // apply U (as U rho U^dagger to density matrices)
+    if (qureg.isDensityMatrix)
+        densmatr_multiQubitUnitary(qureg, buf->qubits, numTargs, u);
+    else
+        statevec_multiQubitUnitary(qureg, buf->qubits, numTargs, u);
+
+    clearPendingMatrix(buf);
+}
+
+/** applies every queued matrix to the state, in one cache-blocked sweep */
+static void applyQueuedMatrices(Qureg qureg) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+    if (buf->numQueued == 0)
+        return;
+
+    // bind each queued matrix (in its slot) to a ComplexMatrixN
+    long long int slotDim = 1LL << buf->maxNumQubits;
+    ComplexMatrixN us[MAX_NUM_QUEUED_MATRICES];
+    for (int i=0; i < buf->numQueued; i++) {
+        long long int dim = 1LL << buf->queuedNumQubits[i];
+        us[i].numQubits = buf->queuedNumQubits[i];
+        us[i].real = &(buf->queuedRealRows[i*slotDim]);
+        us[i].imag = &(buf->queuedImagRows[i*slotDim]);
+        for (long long int r=0; r < dim; r++) {
+            us[i].real[r] = &(buf->queuedReal[i*slotDim*slotDim + r*dim]);
+            us[i].imag[r] = &(buf->queuedImag[i*slotDim*slotDim + r*dim]);
+        }
+    }
+
+    statevec_multiQubitUnitarySequence(qureg, buf->numBlockQubits, us, buf->queuedQubits, buf->numQueued);
+    buf->numQueued = 0;
+    buf->numQueuedQubits = 0;
+}
+
+/** copies the pending matrix (or its conjugate) upon targs into the queue, which must have room */
+static void queuePendingMatrix(GateFusionBuffer* buf, int* targs, int conj) {
+    int numTargs = buf->numQubits;
+    long long int len = (1LL << numTargs) * (1LL << numTargs);
+    long long int slotDim = 1LL << buf->maxNumQubits;
+    qreal* re = &(buf->queuedReal[buf->numQueued*slotDim*slotDim]);
+    qreal* im = &(buf->queuedImag[buf->numQueued*slotDim*slotDim]);
+    for (long long int i=0; i < len; i++) {
+        re[i] = buf->real[i];
+        im[i] = (conj)? -buf->imag[i] : buf->imag[i];
+    }
+    for (int t=0; t < numTargs; t++)
+        buf->queuedQubits[buf->numQueuedQubits + t] = targs[t];
+
+    buf->queuedNumQubits[buf->numQueued++] = numTargs;
+    buf->numQueuedQubits += numTargs;
+}
+
+/** returns whether every qubit (shifted by shift) lies within a cache block */
+static int areQubitsInBlock(GateFusionBuffer* buf, int shift) {
+    for (int i=0; i < buf->numQubits; i++)
+        if (buf->qubits[i] + shift >= buf->numBlockQubits)
+            return 0;
+    return 1;
+}
+
+/** completes the pending matrix, by queueing it for a blocked application if 
+ * it (and, for density matrices, its shifted conjugate) lies within a cache block, 
+ * else by applying it (after the queue) immediately 
+ */
+static void completePendingMatrix(Qureg qureg) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+    if (buf->numQubits == 0)
+        return;
+
+    int shift = qureg.numQubitsRepresented;
+    int numCopies = (qureg.isDensityMatrix)? 2 : 1;
+    if (buf->numBlockQubits > 0 && areQubitsInBlock(buf, 0) &&
+        (!qureg.isDensityMatrix || areQubitsInBlock(buf, shift))) {
+
+        if (buf->numQueued + numCopies > MAX_NUM_QUEUED_MATRICES)
+            applyQueuedMatrices(qureg);
+
+        int* targs = buf->qubits;
+        queuePendingMatrix(buf, targs, 0);
+        if (qureg.isDensityMatrix) {
+            shiftIndices(targs, buf->numQubits, shift);
+            queuePendingMatrix(buf, targs, 1);
+            shiftIndices(targs, buf->numQubits, -shift);
+        }
+        clearPendingMatrix(buf);
+        return;
+    }
+
+    applyQueuedMatrices(qureg);
+    applyPendingMatrix(qureg);
+}
+
+/** applies the pending matrix and queue, then the accumulated diagonal terms */
+static void applyDiagonalTerms(Qureg qureg) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+    if (buf->numPhaseTerms == 0 && buf->numParityTerms == 0)
+        return;
+
+    completePendingMatrix(qureg);
+    applyQueuedMatrices(qureg);
+    statevec_applyDiagonalPhases(qureg,
+        buf->phaseMasks, buf->phaseAngles, buf->numPhaseTerms,
+        buf->parityMasks, buf->parityAngles, buf->numParityTerms);
+    buf->numPhaseTerms = 0;
+    buf->numParityTerms = 0;
+}
+
+void fusion_flush(Qureg qureg) {
+    if (!qureg.fusionBuffer->isFusing)
+        return;
+
+    completePendingMatrix(qureg);
+    applyQueuedMatrices(qureg);
+    applyDiagonalTerms(qureg);
+}
+
+/** adds angle to the term of the same mask among the numTerms, else appends a new term */
+static void addDiagonalTerm(long long int* masks, qreal* angles, int* numTerms, long long int mask, qreal angle) {
+    for (int i=0; i < *numTerms; i++) {
+        if (masks[i] == mask) {
+            angles[i] += angle;
+            return;
+        }
+    }
+    masks[*numTerms] = mask;
+    angles[*numTerms] = angle;
+    (*numTerms)++;
+}
+
+/** accumulates exp(i angle) upon basis states where every qubit in mask is 1 (and its
+ * conjugate upon the shifted qubits of density matrices) 
+ */
+static void accumulatePhaseTerm(Qureg qureg, long long int mask, qreal angle) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+    if (buf->numPhaseTerms + 2 > MAX_NUM_DIAGONAL_TERMS)
+        applyDiagonalTerms(qureg);
+
+    addDiagonalTerm(buf->phaseMasks, buf->phaseAngles, &(buf->numPhaseTerms), mask, angle);
+    if (qureg.isDensityMatrix)
+        addDiagonalTerm(buf->phaseMasks, buf->phaseAngles, &(buf->numPhaseTerms), 
+            mask << qureg.numQubitsRepresented, -angle);
+}
+
+/** accumulates exp(-i angle/2 (-1)^p) where p is the parity of the qubits in mask (and 
+ * its conjugate upon the shifted qubits of density matrices) 
+ */
+static void accumulateParityTerm(Qureg qureg, long long int mask, qreal angle) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+    if (buf->numParityTerms + 2 > MAX_NUM_DIAGONAL_TERMS)
+        applyDiagonalTerms(qureg);
+
+    addDiagonalTerm(buf->parityMasks, buf->parityAngles, &(buf->numParityTerms), mask, angle);
+    if (qureg.isDensityMatrix)
+        addDiagonalTerm(buf->parityMasks, buf->parityAngles, &(buf->numParityTerms), 
+            mask << qureg.numQubitsRepresented, -angle);
+}
+
+/** returns the index of qubit in the pending matrix's qubits, or -1 if absent */
+static int getPendingQubitPosition(GateFusionBuffer* buf, int qubit) {
+    for (int i=0; i < buf->numQubits; i++)
+        if (buf->qubits[i] == qubit)
+            return i;
+    return -1;
+}
+
+static int getNumQubitsNotPending(GateFusionBuffer* buf, int* qubits, int numQubits) {
+    int num = 0;
+    for (int i=0; i < numQubits; i++)
+        if (getPendingQubitPosition(buf, qubits[i]) == -1)
+            num++;
+    return num;
+}
+
+/** appends any of qubits not yet targeted by the pending matrix M, replacing M with (Id (x) M) */
+static void addQubitsToPendingMatrix(GateFusionBuffer* buf, int* qubits, int numQubits) {
+
+    int oldNumQubits = buf->numQubits;
+    for (int i=0; i < numQubits; i++)
+        if (getPendingQubitPosition(buf, qubits[i]) == -1)
+            buf->qubits[buf->numQubits++] = qubits[i];
+
+    if (buf->numQubits == oldNumQubits)
+        return;
+
+    long long int oldDim = 1LL << oldNumQubits;
+    long long int newDim = 1LL << buf->numQubits;
+    long long int r, c;
+    for (r=0; r < newDim; r++) {
+        for (c=0; c < newDim; c++) {
+
+            // the new qubits are the most significant index bits, upon which M' is diagonal
+            if ((r / oldDim) == (c / oldDim)) {
+                buf->workReal[r*newDim + c] = buf->real[(r % oldDim)*oldDim + (c % oldDim)];
+                buf->workImag[r*newDim + c] = buf->imag[(r % oldDim)*oldDim + (c % oldDim)];
+            } else {
+                buf->workReal[r*newDim + c] = 0;
+                buf->workImag[r*newDim + c] = 0;
+            }
+        }
+    }
+
+    // swap the working space into the pending matrix
+    qreal* tmp;
+    tmp = buf->real; buf->real = buf->workReal; buf->workReal = tmp;
+    tmp = buf->imag; buf->imag = buf->workImag; buf->workImag = tmp;
+}
+
+/** left-multiplies the pending matrix by the gate g (of 2^numTargs rows) on targs,
+ * controlled upon ctrls, all of which must already be pending qubits. Each column
+ * of the pending matrix is treated as a state-vector of the pending qubits.
+ */
+static void leftMultiplyPendingMatrix(GateFusionBuffer* buf, int* ctrls, int numCtrls, int* targs, int numTargs, qreal** gRe, qreal** gIm) {
+
+    long long int dim = 1LL << buf->numQubits;
+    int numTargAmps = 1 << numTargs;
+
+    long long int ctrlMask = 0;
+    long long int targMask = 0;
+    long long int ampOffsets[numTargAmps];
+    for (int i=0; i < numCtrls; i++)
+        ctrlMask |= 1LL << getPendingQubitPosition(buf, ctrls[i]);
+    for (int i=0; i < numTargs; i++)
+        targMask |= 1LL << getPendingQubitPosition(buf, targs[i]);
+    for (int i=0; i < numTargAmps; i++) {
+        ampOffsets[i] = 0;
+        for (int t=0; t < numTargs; t++)
+            if ((i >> t) & 1)
+                ampOffsets[i] |= 1LL << getPendingQubitPosition(buf, targs[t]);
+    }
+
+    qreal reAmps[numTargAmps];
+    qreal imAmps[numTargAmps];
+    qreal reSum, imSum;
+    long long int ind00, ind;
+
+    for (long long int col=0; col < dim; col++) {
+        for (ind00=0; ind00 < dim; ind00++) {
+
+            // visit each group of target amplitudes once, and only where the controls are satisfied
+            if ((ind00 & targMask) || ((ind00 & ctrlMask) != ctrlMask))
+                continue;
+
+            for (int i=0; i < numTargAmps; i++) {
+                ind = (ind00 + ampOffsets[i])*dim + col;
+                reAmps[i] = buf->real[ind];
+                imAmps[i] = buf->imag[ind];
+            }
+            for (int r=0; r < numTargAmps; r++) {
+                reSum = 0;
+                imSum = 0;
+                for (int c=0; c < numTargAmps; c++) {
+                    reSum += gRe[r][c]*reAmps[c] - gIm[r][c]*imAmps[c];
+                    imSum += gRe[r][c]*imAmps[c] + gIm[r][c]*reAmps[c];
+                }
+                ind = (ind00 + ampOffsets[r])*dim + col;
+                buf->real[ind] = reSum;
+                buf->imag[ind] = imSum;
+            }
+        }
+    }
+}
+
+/** the general fusion routine which all fusion_add* functions call */
+static int addGateToPendingMatrix(Qureg qureg, int* ctrls, int numCtrls, int* targs, int numTargs, qreal** gRe, qreal** gIm) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+    if (!buf->isFusing)
+        return 0;
+
+    // the gate follows any accumulated diagonal terms, which it needn't commute with
+    applyDiagonalTerms(qureg);
+
+    // gates too large to ever fuse are left to the caller, after the pending gates
+    if (numCtrls + numTargs > buf->maxNumQubits) {
+        fusion_flush(qureg);
+        return 0;
+    }
+
+    // if the gate's qubits don't fit into the pending matrix, begin a new one
+    int numNewQubits =
+        getNumQubitsNotPending(buf, ctrls, numCtrls) +
+        getNumQubitsNotPending(buf, targs, numTargs);
+    if (buf->numQubits + numNewQubits > buf->maxNumQubits)
+        completePendingMatrix(qureg);
+
+    addQubitsToPendingMatrix(buf, ctrls, numCtrls);
+    addQubitsToPendingMatrix(buf, targs, numTargs);
+    leftMultiplyPendingMatrix(buf, ctrls, numCtrls, targs, numTargs, gRe, gIm);
+    return 1;
+}
+
+int fusion_addUnitary(Qureg qureg, int* ctrls, int numCtrls, int targ, ComplexMatrix2 u) {
+    qreal* gRe[2] = {u.real[0], u.real[1]};
+    qreal* gIm[2] = {u.imag[0], u.imag[1]};
+    return addGateToPendingMatrix(qureg, ctrls, numCtrls, (int[]) {targ}, 1, gRe, gIm);
+}
+
+int fusion_addTwoQubitUnitary(Qureg qureg, int* ctrls, int numCtrls, int targ1, int targ2, ComplexMatrix4 u) {
+    qreal* gRe[4] = {u.real[0], u.real[1], u.real[2], u.real[3]};
+    qreal* gIm[4] = {u.imag[0], u.imag[1], u.imag[2], u.imag[3]};
+    return addGateToPendingMatrix(qureg, ctrls, numCtrls, (int[]) {targ1, targ2}, 2, gRe, gIm);
+}
+
+int fusion_addMultiQubitUnitary(Qureg qureg, int* ctrls, int numCtrls, int* targs, int numTargs, ComplexMatrixN u) {
+    return addGateToPendingMatrix(qureg, ctrls, numCtrls, targs, numTargs, u.real, u.imag);
+}
+
+int fusion_addCompactUnitary(Qureg qureg, int* ctrls, int numCtrls, int targ, Complex alpha, Complex beta) {
+    ComplexMatrix2 u = {
+        .real = {{alpha.real, -beta.real}, {beta.real,  alpha.real}},
+        .imag = {{alpha.imag,  beta.imag}, {beta.imag, -alpha.imag}}
+    };
+    return fusion_addUnitary(qureg, ctrls, numCtrls, targ, u);
+}
+
+int fusion_addAxisRotation(Qureg qureg, int* ctrls, int numCtrls, int targ, qreal angle, Vector axis) {
+    Complex alpha, beta;
+    getComplexPairFromRotation(angle, axis, &alpha, &beta);
+    return fusion_addCompactUnitary(qureg, ctrls, numCtrls, targ, alpha, beta);
+}
+
+/** fuses the diagonal gate u into the pending matrix if it acts only upon pending 
+ * qubits (which, since diagonal gates commute, may precede the accumulated terms), 
+ * and otherwise accumulates it as phase terms upon the controls (and target)
+ */
+static int addDiagonalGate(Qureg qureg, int* ctrls, int numCtrls, int targ, ComplexMatrix2 u) {
+    GateFusionBuffer *buf = qureg.fusionBuffer;
+
+    int numNewQubits =
+        getNumQubitsNotPending(buf, ctrls, numCtrls) +
+        getNumQubitsNotPending(buf, &targ, 1);
+    if (buf->numQubits > 0 && numNewQubits == 0) {
+        qreal* gRe[2] = {u.real[0], u.real[1]};
+        qreal* gIm[2] = {u.imag[0], u.imag[1]};
+        leftMultiplyPendingMatrix(buf, ctrls, numCtrls, &targ, 1, gRe, gIm);
+        return 1;
+    }
+
+    // u = diag(exp(i angle0), exp(i angle1)) upon the states where the controls are 1
+    long long int ctrlMask = getQubitBitMask(ctrls, numCtrls);
+    qreal angle0 = atan2(u.imag[0][0], u.real[0][0]);
+    qreal angle1 = atan2(u.imag[1][1], u.real[1][1]);
+    if (angle0 != 0)
+        accumulatePhaseTerm(qureg, ctrlMask, angle0);
+    accumulatePhaseTerm(qureg, ctrlMask | (1LL << targ), angle1 - angle0);
+    return 1;
+}
+
+int fusion_addMultiRotateZ(Qureg qureg, long long int mask, qreal angle) {
+    if (!qureg.fusionBuffer->isFusing)
+        return 0;
+
+    accumulateParityTerm(qureg, mask, angle);
+    return 1;
+}
+
+int fusion_addGate(Qureg qureg, TargetGate gate, int* ctrls, int numCtrls, int targ, qreal param) {
+    if (!qureg.fusionBuffer->isFusing)
+        return 0;
+
+    ComplexMatrix2 u = {.real={{1,0},{0,1}}, .imag={{0}}};
+    Vector xAxis = {1, 0, 0};
+    Vector yAxis = {0, 1, 0};
+
+    switch (gate) {
+        case GATE_SIGMA_X:
+            u.real[0][0] = 0; u.real[0][1] = 1;
+            u.real[1][0] = 1; u.real[1][1] = 0;
+            break;
+        case GATE_SIGMA_Y:
+            u.real[0][0] = 0; u.imag[0][1] = -1;
+            u.imag[1][0] = 1; u.real[1][1] = 0;
+            break;
+        case GATE_SIGMA_Z:
+            u.real[1][1] = -1;
+            return addDiagonalGate(qureg, ctrls, numCtrls, targ, u);
+        case GATE_S:
+            u.real[1][1] = 0; u.imag[1][1] = 1;
+            return addDiagonalGate(qureg, ctrls, numCtrls, targ, u);
+        case GATE_T:
+            u.real[1][1] = 1/sqrt(2); u.imag[1][1] = 1/sqrt(2);
+            return addDiagonalGate(qureg, ctrls, numCtrls, targ, u);
+        case GATE_HADAMARD:
+            u.real[0][0] = 1/sqrt(2); u.real[0][1] =  1/sqrt(2);
+            u.real[1][0] = 1/sqrt(2); u.real[1][1] = -1/sqrt(2);
+            break;
+        case GATE_PHASE_SHIFT:
+            u.real[1][1] = cos(param); u.imag[1][1] = sin(param);
+            return addDiagonalGate(qureg, ctrls, numCtrls, targ, u);
+        case GATE_ROTATE_X:
+            return fusion_addAxisRotation(qureg, ctrls, numCtrls, targ, param, xAxis);
+        case GATE_ROTATE_Y:
+            return fusion_addAxisRotation(qureg, ctrls, numCtrls, targ, param, yAxis);
+        case GATE_ROTATE_Z:
+            u.real[0][0] = cos(param/2); u.imag[0][0] = - sin(param/2);
+            u.real[1][1] = cos(param/2); u.imag[1][1] =   sin(param/2);
+            return addDiagonalGate(qureg, ctrls, numCtrls, targ, u);
+        default:
+            // remaining gates are not fused
+            fusion_flush(qureg);
+            return 0;
+    }
+    return fusion_addUnitary(qureg, ctrls, numCtrls, targ, u);
+}
+
+int fusion_addSwapGate(Qureg qureg, TargetGate gate, int qb1, int qb2) {
+    if (!qureg.fusionBuffer->isFusing)
+        return 0;
+
+    ComplexMatrix4 u = {.real={{1,0,0,0},{0,0,1,0},{0,1,0,0},{0,0,0,1}}, .imag={{0}}};
+    if (gate == GATE_SQRT_SWAP) {
+        u.real[1][1] = .5; u.imag[1][1] =  .5;
+        u.real[1][2] = .5; u.imag[1][2] = -.5;
+        u.real[2][1] = .5; u.imag[2][1] = -.5;
+        u.real[2][2] = .5; u.imag[2][2] =  .5;
+    }
+    return fusion_addTwoQubitUnitary(qureg, NULL, 0, qb1, qb2, u);
+}
@@ -0,0 +1,56 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Functions for fusing consecutive unitaries into dense multi-qubit matrices,
+ * which are applied to the state in a single pass. These are hardware agnostic.
+ *
+ * Each fusion_add* function returns 1 if the gate was absorbed into the pending
+ * fused matrix (and so must not be applied by the caller), or 0 if gate fusion is
+ * disabled or the gate is too large to fuse, in which case the pending matrix has
+ * already been applied and the caller must apply the gate directly.
+ */
+
+# ifndef QUEST_FUSION_H
+# define QUEST_FUSION_H
+
+# include "QuEST.h"
+# include "QuEST_precision.h"
+# include "QuEST_qasm.h"
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+void fusion_setup(Qureg* qureg);
+
+void fusion_free(Qureg qureg);
+
+void fusion_start(Qureg qureg, int maxNumQubits, int numBlockQubits);
+
+void fusion_stop(Qureg qureg);
+
+void fusion_flush(Qureg qureg);
+
+void fusion_discard(Qureg qureg);
+
+int fusion_addGate(Qureg qureg, TargetGate gate, int* ctrls, int numCtrls, int targ, qreal param);
+
+int fusion_addMultiRotateZ(Qureg qureg, long long int mask, qreal angle);
+
+int fusion_addSwapGate(Qureg qureg, TargetGate gate, int qb1, int qb2);
+
+int fusion_addCompactUnitary(Qureg qureg, int* ctrls, int numCtrls, int targ, Complex alpha, Complex beta);
+
+int fusion_addAxisRotation(Qureg qureg, int* ctrls, int numCtrls, int targ, qreal angle, Vector axis);
+
+int fusion_addUnitary(Qureg qureg, int* ctrls, int numCtrls, int targ, ComplexMatrix2 u);
+
+int fusion_addTwoQubitUnitary(Qureg qureg, int* ctrls, int numCtrls, int targ1, int targ2, ComplexMatrix4 u);
+
+int fusion_addMultiQubitUnitary(Qureg qureg, int* ctrls, int numCtrls, int* targs, int numTargs, ComplexMatrixN u);
+
+# ifdef __cplusplus
+}
+# endif
+
+# endif // QUEST_FUSION_H
@@ -53,6 +53,20 @@ void conjugateMatrixN(ComplexMatrixN u);
 
 void getQuESTDefaultSeedKey(unsigned long int *key);
 
+void getPauliProdMasks(int* targetQubits, enum pauliOpType* pauliCodes, int numTargets, long long int* xMask, long long int* zMask, int* numY);
+
+int getPauliSumMaskGroups(enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, int numQubits, long long int* xMasks, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm);
+
+/** A shot of sampleOutcomes, drawn as a position within the cumulative probability 
+ * of the basis states, remembering its index in the caller's outcomes array */
+typedef struct {
+    qaccum prob;
+    int index;
+} SampledShot;
+
+/** Orders SampledShot by increasing prob, for qsort */
+int compareSampledShots(const void* a, const void* b);
+
 
 /*
  * operations upon density matrices 
@@ -100,10 +114,34 @@ void densmatr_mixTwoQubitKrausMap(Qureg qureg, int target1, int target2, Complex
 
 void densmatr_mixMultiQubitKrausMap(Qureg qureg, int* targets, int numTargets, ComplexMatrixN* ops, int numOps);
 
+void densmatr_applyMultiQubitKrausSuperoperator(Qureg qureg, int* targets, int numTargets, ComplexMatrixN superOp);
+
+void densmatr_applyMultiQubitUnitary(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u);
+
+void densmatr_hadamard(Qureg qureg, int targetQubit);
+
+void densmatr_rotateX(Qureg qureg, int rotQubit, qreal angle);
+
+void densmatr_rotateY(Qureg qureg, int rotQubit, qreal angle);
+
+void densmatr_rotateAroundAxis(Qureg qureg, int rotQubit, qreal angle, Vector axis);
+
+void densmatr_compactUnitary(Qureg qureg, int targetQubit, Complex alpha, Complex beta);
+
+void densmatr_unitary(Qureg qureg, int targetQubit, ComplexMatrix2 u);
+
+void densmatr_twoQubitUnitary(Qureg qureg, int targetQubit1, int targetQubit2, ComplexMatrix4 u);
+
+void densmatr_multiQubitUnitary(Qureg qureg, int* targets, int numTargets, ComplexMatrixN u);
+
+void densmatr_sqrtSwapGate(Qureg qureg, int qb1, int qb2);
+
 void densmatr_applyDiagonalOp(Qureg qureg, DiagonalOp op);
 
 Complex densmatr_calcExpecDiagonalOp(Qureg qureg, DiagonalOp op);
 
+qreal densmatr_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms);
+
 
 /* 
  * operations upon state vectors
@@ -113,11 +151,33 @@ void statevec_reportStateToScreen(Qureg qureg, QuESTEnv env, int reportRank);
 
 int statevec_compareStates(Qureg mq1, Qureg mq2, qreal precision);
 
-int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env);
+/* returns 1 if the file was opened (else 0), and sets isComplete to whether it contained every amplitude */
+int statevec_initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env, int* isComplete);
+
+/** The header at the start of a checkpoint file written by saveQuregCheckpoint(). In the file, 
+ * the fields are serialised in this order, at fixed width (32-bit, except the 64-bit numAmpsTotal) 
+ * and little-endian, independent of the writer's struct layout */
+typedef struct {
+    char magic[8];              // "QuESTchk", without a null terminator
+    int version;                // of the checkpoint format
+    int precision;              // QuEST_PREC of the writer
+    int qrealSize;              // sizeof(qreal) of the writer, in bytes
+    int numQubitsRepresented;
+    int isDensityMatrix;
+    int numChunks;              // number of ranks which wrote the checkpoint, which needn't match the reader
+    long long int numAmpsTotal;
+    int isBigEndian;            // byte order of the writer's (native) amplitudes, which must match the reader
+} CheckpointHeader;
+
+int statevec_saveCheckpoint(Qureg qureg, char* filename);
+
+int statevec_readCheckpointHeader(char* filename, CheckpointHeader* header, int* isValid);
+
+int statevec_loadCheckpoint(Qureg qureg, char* filename, CheckpointHeader header);
 
 void statevec_initStateOfSingleQubit(Qureg *qureg, int qubitId, int outcome);
 
-void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env);
+void statevec_createQureg(Qureg *qureg, int numQubits, QuESTEnv env, enum memoryPolicy policy);
 
 void statevec_destroyQureg(Qureg qureg, QuESTEnv env);
 
@@ -179,9 +239,11 @@ qreal statevec_calcFidelity(Qureg qureg, Qureg pureState);
 
 Complex statevec_calcInnerProduct(Qureg bra, Qureg ket);
 
-qreal statevec_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets, Qureg workspace);
+qreal statevec_calcExpecPauliProd(Qureg qureg, int* targetQubits, enum pauliOpType* pauliCodes, int numTargets);
+
+qreal statevec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms);
 
-qreal statevec_calcExpecPauliSum(Qureg qureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, Qureg workspace);
+qreal statevec_calcExpecPauliMasks(Qureg qureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms);
 
 void statevec_compactUnitary(Qureg qureg, int targetQubit, Complex alpha, Complex beta);
 
@@ -199,6 +261,10 @@ void statevec_controlledMultiQubitUnitary(Qureg qureg, int ctrl, int* targets, i
 
 void statevec_multiControlledMultiQubitUnitary(Qureg qureg, long long int ctrlMask, int* targs, int numTargs, ComplexMatrixN u);
 
+void statevec_multiControlledMultiQubitNot(Qureg qureg, long long int ctrlMask, long long int targMask);
+
+void statevec_multiQubitUnitarySequence(Qureg qureg, int numBlockQubits, ComplexMatrixN* us, int* targs, int numUnitaries);
+
 void statevec_rotateX(Qureg qureg, int rotQubit, qreal angle);
 
 void statevec_rotateY(Qureg qureg, int rotQubit, qreal angle);
@@ -231,10 +297,14 @@ void statevec_controlledNot(Qureg qureg, int controlQubit, int targetQubit);
 
 qreal statevec_calcProbOfOutcome(Qureg qureg, int measureQubit, int outcome);
 
+void statevec_calcProbOfAllOutcomes(Qureg qureg, int* qubits, int numQubits, qreal* outcomeProbs);
+
 void statevec_collapseToKnownProbOutcome(Qureg qureg, int measureQubit, int outcome, qreal outcomeProb);
 
 int statevec_measureWithStats(Qureg qureg, int measureQubit, qreal *outcomeProb);
 
+void statevec_sampleOutcomes(Qureg qureg, int* qubits, int numQubits, int numShots, long long int* outcomes);
+
 void statevec_swapQubitAmps(Qureg qureg, int qb1, int qb2);
 
 void statevec_sqrtSwapGate(Qureg qureg, int qb1, int qb2);
@@ -243,12 +313,18 @@ void statevec_sqrtSwapGateConj(Qureg qureg, int qb1, int qb2);
 
 void statevec_multiRotateZ(Qureg qureg, long long int mask, qreal angle);
 
+void statevec_applyDiagonalPhases(Qureg qureg, long long int* phaseMasks, qreal* phaseAngles, int numPhaseTerms, long long int* parityMasks, qreal* parityAngles, int numParityTerms);
+
 void statevec_multiRotatePauli(Qureg qureg, int* targetQubits, enum pauliOpType* targetPaulis, int numTargets, qreal angle, int applyConj);
 
+void statevec_multiRotatePauliMasks(Qureg qureg, long long int xMask, long long int zMask, qreal diagFac, Complex offDiagFac);
+
 void statevec_setWeightedQureg(Complex fac1, Qureg qureg1, Complex fac2, Qureg qureg2, Complex facOut, Qureg out);
 
 void statevec_applyPauliSum(Qureg inQureg, enum pauliOpType* allCodes, qreal* termCoeffs, int numSumTerms, Qureg outQureg);
 
+void statevec_applyPauliMasks(Qureg inQureg, long long int xMask, long long int* zMasks, qreal* coeffsRe, qreal* coeffsIm, int numTerms, Qureg outQureg);
+
 void statevec_applyDiagonalOp(Qureg qureg, DiagonalOp op);
 
 Complex statevec_calcExpecDiagonalOp(Qureg qureg, DiagonalOp op);
@@ -258,7 +334,9 @@ Complex statevec_calcExpecDiagonalOp(Qureg qureg, DiagonalOp op);
  * operations which differentiate between state-vectors and density matrices internally 
  */
  
-void agnostic_applyTrotterCircuit(Qureg qureg, PauliHamil hamil, qreal time, int order, int reps);
+TrotterPlan agnostic_createTrotterPlan(PauliHamil hamil, qreal time, int order, int reps);
+
+void agnostic_applyTrotterPlan(Qureg qureg, TrotterPlan plan);
 
 DiagonalOp agnostic_createDiagonalOp(int numQubits, QuESTEnv env);
 
@@ -0,0 +1,111 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * A pool of destroyed Quregs, recycled by later Quregs of the same size.
+ * Destroyed Quregs are pushed (with their amplitudes, pair buffers, GPU memory
+ * and QASM logger intact) onto a stack selected by their memory policy and
+ * number of state-vector qubits, so that taking and giving a Qureg are O(1).
+ * Pooled memory is only freed when pooling is stopped or the env destroyed.
+ */
+
+# include "QuEST.h"
+# include "QuEST_internal.h"
+# include "QuEST_qasm.h"
+# include "QuEST_pool.h"
+# include "QuEST_validation.h"
+
+# include <stdlib.h>
+
+/** A destroyed Qureg awaiting reuse, in a stack */
+typedef struct PooledQureg {
+    Qureg qureg;
+    struct PooledQureg* next;
+} PooledQureg;
+
+void pool_setup(QuESTEnv* env) {
+
+    QuregPool* pool = malloc(sizeof *pool);
+    validateMemoryAllocation(pool != NULL, __func__);
+
+    pool->isPooling = 0;
+    for (int p=0; p < NUM_POOLED_POLICIES; p++)
+        for (int n=0; n < NUM_POOLED_QUBITS; n++)
+            pool->bins[p][n] = NULL;
+
+    env->quregPool = pool;
+}
+
+/** frees the memory of every pooled Qureg, leaving the pool empty */
+static void emptyPool(QuESTEnv env) {
+    QuregPool* pool = env.quregPool;
+
+    for (int p=0; p < NUM_POOLED_POLICIES; p++) {
+        for (int n=0; n < NUM_POOLED_QUBITS; n++) {
+            while (pool->bins[p][n] != NULL) {
+                PooledQureg* node = pool->bins[p][n];
+                pool->bins[p][n] = node->next;
+
+                statevec_destroyQureg(node->qureg, env);
+                qasm_free(node->qureg);
+                free(node);
+            }
+        }
+    }
+}
+
+void pool_free(QuESTEnv env) {
+    if (env.quregPool == NULL)
+        return;
+
+    emptyPool(env);
+    free(env.quregPool);
+}
+
+void pool_start(QuESTEnv env) {
+    env.quregPool->isPooling = 1;
+}
+
+void pool_stop(QuESTEnv env) {
+    env.quregPool->isPooling = 0;
+    emptyPool(env);
+}
+
+int pool_takeQureg(QuESTEnv env, Qureg* qureg, int numQubitsInStateVec, enum memoryPolicy policy) {
+    QuregPool* pool = env.quregPool;
+
+    if (pool == NULL || !pool->isPooling)
+        return 0;
+
+    // any memory policy or size beyond the bins is never pooled
+    if (policy >= NUM_POOLED_POLICIES || numQubitsInStateVec >= NUM_POOLED_QUBITS)
+        return 0;
+
+    PooledQureg* node = pool->bins[policy][numQubitsInStateVec];
+    if (node == NULL)
+        return 0;
+
+    pool->bins[policy][numQubitsInStateVec] = node->next;
+    *qureg = node->qureg;
+    free(node);
+    return 1;
+}
+
+int pool_giveQureg(QuESTEnv env, Qureg qureg) {
+    QuregPool* pool = env.quregPool;
+
+    if (pool == NULL || !pool->isPooling)
+        return 0;
+
+    if (qureg.memPolicy >= NUM_POOLED_POLICIES || qureg.numQubitsInStateVec >= NUM_POOLED_QUBITS)
+        return 0;
+
+    // if even the node cannot be allocated, the caller may still free the Qureg
+    PooledQureg* node = malloc(sizeof *node);
+    if (node == NULL)
+        return 0;
+
+    node->qureg = qureg;
+    node->next = pool->bins[qureg.memPolicy][qureg.numQubitsInStateVec];
+    pool->bins[qureg.memPolicy][qureg.numQubitsInStateVec] = node;
+    return 1;
+}
@@ -0,0 +1,39 @@
+// Distributed under MIT licence. See https://github.com/QuEST-Kit/QuEST/blob/master/LICENCE.txt for details
+
+/** @file
+ * Functions for recycling the memory of destroyed Quregs through a pool held by
+ * the QuESTEnv. These are hardware agnostic.
+ *
+ * pool_takeQureg returns 1 if a pooled Qureg of the requested size and memory
+ * policy was found (whose amplitudes and QASM logger are then reused by the caller),
+ * or 0 if pooling is disabled or none was found, in which case the caller must
+ * allocate a new Qureg. Similarly, pool_giveQureg returns 1 if the Qureg was
+ * absorbed into the pool, else 0 in which case the caller must free it.
+ */
+
+# ifndef QUEST_POOL_H
+# define QUEST_POOL_H
+
+# include "QuEST.h"
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+void pool_setup(QuESTEnv* env);
+
+void pool_free(QuESTEnv env);
+
+void pool_start(QuESTEnv env);
+
+void pool_stop(QuESTEnv env);
+
+int pool_takeQureg(QuESTEnv env, Qureg* qureg, int numQubitsInStateVec, enum memoryPolicy policy);
+
+int pool_giveQureg(QuESTEnv env, Qureg qureg);
+
+# ifdef __cplusplus
+}
+# endif
+
+# endif // QUEST_POOL_H
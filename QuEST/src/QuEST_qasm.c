@@ -65,12 +65,20 @@ void qasm_setup(Qureg* qureg) {
     if (qasmLog == NULL)
         bufferOverflow();
     
-    qasmLog->isLogging = 0;
     qasmLog->bufferSize = BUF_INIT_SIZE;
     qasmLog->buffer = malloc(qasmLog->bufferSize * sizeof *(qasmLog->buffer));
     if (qasmLog->buffer == NULL)
         bufferOverflow();
     
+    qasm_reset(qureg);
+}
+
+void qasm_reset(Qureg* qureg) {
+    
+    // maintains current buffer size, which is at least BUF_INIT_SIZE
+    QASMLogger *qasmLog = qureg->qasmLog;
+    qasmLog->isLogging = 0;
+    
     // add headers and quantum / classical register creation
     qasmLog->bufferFill = snprintf(
         qasmLog->buffer, qasmLog->bufferSize,
@@ -36,6 +36,8 @@ typedef enum {
 
 void qasm_setup(Qureg* qureg);
 
+void qasm_reset(Qureg* qureg);
+
 void qasm_startRecording(Qureg qureg);
 
 void qasm_stopRecording(Qureg qureg);
@@ -94,7 +94,19 @@ typedef enum {
     E_INVALID_TROTTER_ORDER,
     E_INVALID_TROTTER_REPS,
     E_MISMATCHING_QUREG_DIAGONAL_OP_SIZE,
-    E_DIAGONAL_OP_NOT_INITIALISED
+    E_DIAGONAL_OP_NOT_INITIALISED,
+    E_INVALID_NUM_FUSED_QUBITS,
+    E_INVALID_NUM_FUSION_BLOCK_QUBITS,
+    E_MISMATCHING_TROTTER_PLAN_QUREG_NUM_QUBITS,
+    E_INVALID_MEMORY_POLICY,
+    E_CANNOT_WRITE_FILE,
+    E_CANNOT_READ_FILE,
+    E_INVALID_CHECKPOINT_FILE,
+    E_MISMATCHING_QUREG_CHECKPOINT_DIMS,
+    E_INVALID_NUM_SHOTS,
+    E_CANNOT_ALLOCATE_MEMORY,
+    E_FILE_MAPPED_DIR_NOT_SET,
+    E_INVALID_STATE_FILE
 } ErrorCode;
 
 static const char* errorMessages[] = {
@@ -161,7 +173,19 @@ static const char* errorMessages[] = {
     [E_INVALID_TROTTER_ORDER] = "The Trotterisation order must be 1, or an even number (for higher-order Suzuki symmetrized expansions).",
     [E_INVALID_TROTTER_REPS] = "The number of Trotter repetitions must be >=1.",
     [E_MISMATCHING_QUREG_DIAGONAL_OP_SIZE] = "The qureg must represent an equal number of qubits as that in the applied diagonal operator.",
-    [E_DIAGONAL_OP_NOT_INITIALISED] = "The diagonal operator has not been initialised through createDiagonalOperator()."
+    [E_DIAGONAL_OP_NOT_INITIALISED] = "The diagonal operator has not been initialised through createDiagonalOperator().",
+    [E_INVALID_NUM_FUSED_QUBITS] = "Invalid maximum number of fused qubits. Must be >0, <=numQubits and <=10.",
+    [E_INVALID_NUM_FUSION_BLOCK_QUBITS] = "Invalid number of block qubits. Must be >= the maximum number of fused qubits, and a block must fit in a single node's amplitudes.",
+    [E_MISMATCHING_TROTTER_PLAN_QUREG_NUM_QUBITS] = "The TrotterPlan must act on the same number of qubits as exist in the Qureg.",
+    [E_INVALID_MEMORY_POLICY] = "Invalid memory policy. Must be 0 (or MEMORY_DEFAULT), 1 (MEMORY_HUGE_PAGES), 2 (MEMORY_EXPLICIT_HUGE_PAGES) or 3 (MEMORY_FILE_MAPPED).",
+    [E_CANNOT_WRITE_FILE] = "Could not write to file (%s).",
+    [E_CANNOT_READ_FILE] = "Could not read from file (%s).",
+    [E_INVALID_CHECKPOINT_FILE] = "The file (%s) is not a complete QuEST checkpoint of a supported version, precision and byte order.",
+    [E_MISMATCHING_QUREG_CHECKPOINT_DIMS] = "The checkpoint in file (%s) must be of a Qureg with the same number of qubits, and of the same type (state-vector or density matrix), as the loading Qureg.",
+    [E_INVALID_NUM_SHOTS] = "Invalid number of shots. Must be >0.",
+    [E_CANNOT_ALLOCATE_MEMORY] = "Could not allocate memory for an internal buffer (insufficient memory available).",
+    [E_FILE_MAPPED_DIR_NOT_SET] = "The MEMORY_FILE_MAPPED policy requires the QUEST_FILE_MAPPED_DIR environment variable to name a directory on (disk-backed) storage.",
+    [E_INVALID_STATE_FILE] = "The file (%s) must contain a line \"real, imag\" for every amplitude of the Qureg (lines beginning with # are ignored)."
 };
 
 void exitWithError(const char* msg, const char* func) {
@@ -322,6 +346,17 @@ void validateNumQubitsInQureg(int numQubits, int numRanks, const char* caller) {
     QuESTAssert(numAmps >= numRanks, E_DISTRIB_QUREG_TOO_SMALL, caller);
 }
  
+void validateMemoryPolicy(enum memoryPolicy policy, const char* caller) {
+    QuESTAssert(
+        policy==MEMORY_DEFAULT || policy==MEMORY_HUGE_PAGES || 
+        policy==MEMORY_EXPLICIT_HUGE_PAGES || policy==MEMORY_FILE_MAPPED, E_INVALID_MEMORY_POLICY, caller);
+    
+    if (policy == MEMORY_FILE_MAPPED) {
+        const char* dir = getenv("QUEST_FILE_MAPPED_DIR");
+        QuESTAssert(dir != NULL && dir[0] != '\0', E_FILE_MAPPED_DIR_NOT_SET, caller);
+    }
+}
+
 void validateNumQubitsInMatrix(int numQubits, const char* caller) {
     QuESTAssert(numQubits>0, E_INVALID_NUM_QUBITS, caller);
 }
@@ -488,6 +523,14 @@ void validateOutcome(int outcome, const char* caller) {
     QuESTAssert(outcome==0 || outcome==1, E_INVALID_QUBIT_OUTCOME, caller);
 }
 
+void validateNumShots(int numShots, const char* caller) {
+    QuESTAssert(numShots>0, E_INVALID_NUM_SHOTS, caller);
+}
+
+void validateMemoryAllocation(int isAllocated, const char* caller) {
+    QuESTAssert(isAllocated, E_CANNOT_ALLOCATE_MEMORY, caller);
+}
+
 void validateMeasurementProb(qreal prob, const char* caller) {
     QuESTAssert(prob>REAL_EPS, E_COLLAPSE_STATE_ZERO_PROB, caller);
 }
@@ -512,6 +555,46 @@ void validateFileOpened(int opened, char* fn, const char* caller) {
     }
 }
 
+void validateFileWritten(int written, char* fn, const char* caller) {
+    if (!written) {
+        
+        sprintf(errMsgBuffer, errorMessages[E_CANNOT_WRITE_FILE], fn);
+        invalidQuESTInputError(errMsgBuffer, caller);
+    }
+}
+
+void validateFileRead(int read, char* fn, const char* caller) {
+    if (!read) {
+        
+        sprintf(errMsgBuffer, errorMessages[E_CANNOT_READ_FILE], fn);
+        invalidQuESTInputError(errMsgBuffer, caller);
+    }
+}
+
+void validateCheckpointFile(int isValid, char* fn, const char* caller) {
+    if (!isValid) {
+        
+        sprintf(errMsgBuffer, errorMessages[E_INVALID_CHECKPOINT_FILE], fn);
+        invalidQuESTInputError(errMsgBuffer, caller);
+    }
+}
+
+void validateStateFile(int isComplete, char* fn, const char* caller) {
+    if (!isComplete) {
+        
+        sprintf(errMsgBuffer, errorMessages[E_INVALID_STATE_FILE], fn);
+        invalidQuESTInputError(errMsgBuffer, caller);
+    }
+}
+
+void validateMatchingQuregCheckpointDims(Qureg qureg, int numQubits, int isDensityMatrix, char* fn, const char* caller) {
+    if (qureg.numQubitsRepresented != numQubits || qureg.isDensityMatrix != isDensityMatrix) {
+        
+        sprintf(errMsgBuffer, errorMessages[E_MISMATCHING_QUREG_CHECKPOINT_DIMS], fn);
+        invalidQuESTInputError(errMsgBuffer, caller);
+    }
+}
+
 void validateProb(qreal prob, const char* caller) {
     QuESTAssert(prob >= 0 && prob <= 1, E_INVALID_PROB, caller);
 }
@@ -670,6 +753,10 @@ void validateTrotterParams(int order, int reps, const char* caller) {
     QuESTAssert(reps > 0, E_INVALID_TROTTER_REPS, caller);
 }
 
+void validateMatchingQuregTrotterPlanDims(Qureg qureg, TrotterPlan plan, const char* caller) {
+    QuESTAssert(plan.numQubits == qureg.numQubitsRepresented, E_MISMATCHING_TROTTER_PLAN_QUREG_NUM_QUBITS, caller);
+}
+
 void validateDiagOpInit(DiagonalOp op, const char* caller) {
     QuESTAssert(op.real != NULL && op.imag != NULL, E_DIAGONAL_OP_NOT_INITIALISED, caller);
 }
@@ -679,6 +766,22 @@ void validateDiagonalOp(Qureg qureg, DiagonalOp op, const char* caller) {
     QuESTAssert(qureg.numQubitsRepresented == op.numQubits, E_MISMATCHING_QUREG_DIAGONAL_OP_SIZE, caller);
 }
 
+/* the largest fused matrix, of 4^10 amplitudes (16 MiB in double precision), kept by fusion_start */
+# define MAX_NUM_FUSED_QUBITS 10
+
+void validateNumFusedQubits(Qureg qureg, int maxNumQubits, const char* caller) {
+    QuESTAssert(
+        maxNumQubits > 0 && maxNumQubits <= qureg.numQubitsRepresented && 
+        maxNumQubits <= MAX_NUM_FUSED_QUBITS, E_INVALID_NUM_FUSED_QUBITS, caller);
+    validateMultiQubitMatrixFitsInNode(qureg, maxNumQubits, caller);
+}
+
+void validateNumFusionBlockQubits(Qureg qureg, int maxNumQubits, int numBlockQubits, const char* caller) {
+    QuESTAssert(
+        numBlockQubits >= maxNumQubits && numBlockQubits < 63 &&
+        qureg.numAmpsPerChunk >= (1LL << numBlockQubits), E_INVALID_NUM_FUSION_BLOCK_QUBITS, caller);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,6 +22,8 @@ void validateNumRanks(int numRanks, const char* caller);
 
 void validateNumQubitsInQureg(int numQubits, int numRanks, const char* caller);
 
+void validateMemoryPolicy(enum memoryPolicy policy, const char* caller);
+
 void validateNumQubitsInMatrix(int numQubits, const char* caller);
 
 void validateNumQubitsInDiagOp(int numQubits, int numRanks, const char* caller);
@@ -68,6 +70,10 @@ void validateDensityMatrQureg(Qureg qureg, const char* caller);
 
 void validateOutcome(int outcome, const char* caller);
 
+void validateNumShots(int numShots, const char* caller);
+
+void validateMemoryAllocation(int isAllocated, const char* caller);
+
 void validateMeasurementProb(qreal prob, const char* caller);
 
 void validateMatchingQuregDims(Qureg qureg1, Qureg qureg2, const char *caller);
@@ -80,6 +86,16 @@ void validateNumAmps(Qureg qureg, long long int startInd, long long int numAmps,
 
 void validateFileOpened(int opened, char* fn, const char* caller);
 
+void validateFileWritten(int written, char* fn, const char* caller);
+
+void validateFileRead(int read, char* fn, const char* caller);
+
+void validateCheckpointFile(int isValid, char* fn, const char* caller);
+
+void validateStateFile(int isComplete, char* fn, const char* caller);
+
+void validateMatchingQuregCheckpointDims(Qureg qureg, int numQubits, int isDensityMatrix, char* fn, const char* caller);
+
 void validateProb(qreal prob, const char* caller);
 
 void validateNormProbs(qreal prob1, qreal prob2, const char* caller);
@@ -124,10 +140,16 @@ void validateHamilFilePauliCode(enum pauliOpType code, PauliHamil h, FILE* file,
 
 void validateTrotterParams(int order, int reps, const char* caller);
 
+void validateMatchingQuregTrotterPlanDims(Qureg qureg, TrotterPlan plan, const char* caller);
+
 void validateDiagOpInit(DiagonalOp, const char* caller);
 
 void validateDiagonalOp(Qureg qureg, DiagonalOp op, const char* caller);
 
+void validateNumFusedQubits(Qureg qureg, int maxNumQubits, const char* caller);
+
+void validateNumFusionBlockQubits(Qureg qureg, int maxNumQubits, int numBlockQubits, const char* caller);
+
 void validateNumElems(DiagonalOp op, long long int startInd, long long int numElems, const char* caller);
 
 # ifdef __cplusplus
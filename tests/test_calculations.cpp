@@ -348,6 +348,11 @@ TEST_CASE( "calcExpecPauliProd", "[calculations]" ) {
             
             qreal res = calcExpecPauliProd(vec, targs, paulis, numTargs, vecWork);
             REQUIRE( res == Approx(real(prod)).margin(REAL_EPS) );
+            
+            // the workspace is unused, so qureg may be passed as its own workspace
+            res = calcExpecPauliProd(vec, targs, paulis, numTargs, vec);
+            REQUIRE( res == Approx(real(prod)).margin(REAL_EPS) );
+            REQUIRE( areEqual(vec, vecRef) );
         }
         SECTION( "density-matrix" ) {
             
@@ -365,6 +370,10 @@ TEST_CASE( "calcExpecPauliProd", "[calculations]" ) {
             
             qreal res = calcExpecPauliProd(mat, targs, paulis, numTargs, matWork);
             REQUIRE( res == Approx(tr).margin(10*REAL_EPS) );
+            
+            // the workspace is unused, so qureg may be passed as its own workspace
+            res = calcExpecPauliProd(mat, targs, paulis, numTargs, mat);
+            REQUIRE( res == Approx(tr).margin(10*REAL_EPS) );
         }
     }
     SECTION( "validation" ) {
@@ -460,6 +469,12 @@ TEST_CASE( "calcExpecPauliSum", "[calculations]" ) {
         qreal coeffs[numSumTerms];
         setRandomPauliSum(coeffs, paulis, NUM_QUBITS, numSumTerms);
         
+        // terms with the same X (or Y) operators are evaluated together, so we also 
+        // try sums where each term shares its X mask with the first or second term
+        int shareXMasks = GENERATE( 0, 1 );
+        if (shareXMasks)
+            setRandomPauliSumSharingXMasks(paulis, NUM_QUBITS, numSumTerms);
+        
         // produce a numTargs-big matrix 'pauliSum' by pauli-matrix tensoring and summing
         QMatrix pauliSum = toQMatrix(coeffs, paulis, NUM_QUBITS, numSumTerms);
         
@@ -870,6 +885,140 @@ TEST_CASE( "calcInnerProduct", "[calculations]" ) {
 
 
 
+/** @sa calcProbOfAllOutcomes
+ * @ingroup unittest 
+ */
+TEST_CASE( "calcProbOfAllOutcomes", "[calculations]" ) {
+    
+    Qureg vec = createQureg(NUM_QUBITS, QUEST_ENV);
+    Qureg mat = createDensityQureg(NUM_QUBITS, QUEST_ENV);
+    
+    SECTION( "correctness" ) {
+        
+        int numQubits = GENERATE( range(1,NUM_QUBITS+1) );
+        int* qubits = GENERATE_COPY( sublists(range(0,NUM_QUBITS), numQubits) );
+        
+        // the probability of each basis state, summed into the probability of each outcome
+        std::vector<qreal> basisProbs(1 << NUM_QUBITS);
+        std::vector<qreal> refProbs(1 << numQubits);
+        std::vector<qreal> outcomeProbs(1 << numQubits);
+        
+        SECTION( "state-vector" ) {
+            
+            SECTION( "normalised" ) {
+                
+                QVector ref = getRandomStateVector(NUM_QUBITS);
+                toQureg(vec, ref);
+                for (size_t ind=0; ind<ref.size(); ind++)
+                    basisProbs[ind] = pow(abs(ref[ind]), 2);
+                
+                calcProbOfAllOutcomes(vec, qubits, numQubits, outcomeProbs.data());
+            }
+            SECTION( "unnormalised" ) {
+                
+                QVector ref = getRandomQVector(1<<NUM_QUBITS);
+                toQureg(vec, ref);
+                for (size_t ind=0; ind<ref.size(); ind++)
+                    basisProbs[ind] = pow(abs(ref[ind]), 2);
+                
+                calcProbOfAllOutcomes(vec, qubits, numQubits, outcomeProbs.data());
+            }
+        }
+        SECTION( "density-matrix" ) {
+            
+            SECTION( "pure" ) {
+                
+                QVector ref = getRandomStateVector(NUM_QUBITS);
+                toQureg(mat, getKetBra(ref, ref));
+                for (size_t ind=0; ind<ref.size(); ind++)
+                    basisProbs[ind] = pow(abs(ref[ind]), 2);
+                
+                calcProbOfAllOutcomes(mat, qubits, numQubits, outcomeProbs.data());
+            }
+            SECTION( "mixed" ) {
+                
+                QMatrix ref = getRandomDensityMatrix(NUM_QUBITS);
+                toQureg(mat, ref);
+                for (size_t ind=0; ind<ref.size(); ind++)
+                    basisProbs[ind] = real(ref[ind][ind]);
+                
+                calcProbOfAllOutcomes(mat, qubits, numQubits, outcomeProbs.data());
+            }
+            SECTION( "unnormalised" ) {
+                
+                QMatrix ref = getRandomQMatrix(1<<NUM_QUBITS);
+                toQureg(mat, ref);
+                for (size_t ind=0; ind<ref.size(); ind++)
+                    basisProbs[ind] = real(ref[ind][ind]);
+                
+                calcProbOfAllOutcomes(mat, qubits, numQubits, outcomeProbs.data());
+            }
+        }
+        
+        // outcome o sums every basis state whose bits at qubits form o
+        for (size_t ind=0; ind<basisProbs.size(); ind++) {
+            int outcome = 0;
+            for (int q=0; q<numQubits; q++)
+                outcome |= ((ind >> qubits[q]) & 1) << q;
+            refProbs[outcome] += basisProbs[ind];
+        }
+        for (int o=0; o<(1 << numQubits); o++)
+            REQUIRE( outcomeProbs[o] == Approx(refProbs[o]).margin(REAL_EPS) );
+    }
+    SECTION( "many outcomes" ) {
+        
+        // too many outcomes for a histogram per thread, so that threads instead partition the outcomes
+        int numTotalQubits = 18;
+        int qubits[] = {17, 0, 16, 1, 15, 2, 14, 3, 13, 4, 12, 6, 11, 7, 10, 8, 9};
+        int numQubits = 17;
+        
+        Qureg big = createQureg(numTotalQubits, QUEST_ENV);
+        QVector ref = getRandomQVector(1 << numTotalQubits);
+        toQureg(big, ref);
+        
+        std::vector<qreal> refProbs(1 << numQubits);
+        std::vector<qreal> outcomeProbs(1 << numQubits);
+        calcProbOfAllOutcomes(big, qubits, numQubits, outcomeProbs.data());
+        
+        for (size_t ind=0; ind<ref.size(); ind++) {
+            int outcome = 0;
+            for (int q=0; q<numQubits; q++)
+                outcome |= ((ind >> qubits[q]) & 1) << q;
+            refProbs[outcome] += pow(abs(ref[ind]), 2);
+        }
+        for (int o=0; o<(1 << numQubits); o++)
+            REQUIRE( outcomeProbs[o] == Approx(refProbs[o]).margin(REAL_EPS) );
+        
+        destroyQureg(big, QUEST_ENV);
+    }
+    SECTION( "input validation" ) {
+        
+        std::vector<qreal> outcomeProbs(1 << NUM_QUBITS);
+        
+        SECTION( "number of qubits" ) {
+            
+            int numQubits = GENERATE( -1, 0, NUM_QUBITS+1 );
+            int qubits[NUM_QUBITS+1];
+            REQUIRE_THROWS_WITH( calcProbOfAllOutcomes(vec, qubits, numQubits, outcomeProbs.data()), Contains("Invalid number of qubits") );
+        }
+        SECTION( "qubit indices" ) {
+            
+            int qubits[] = {0, 1};
+            qubits[GENERATE(0,1)] = GENERATE( -1, NUM_QUBITS );
+            REQUIRE_THROWS_WITH( calcProbOfAllOutcomes(mat, qubits, 2, outcomeProbs.data()), Contains("Invalid qubit index") );
+        }
+        SECTION( "repetition of qubits" ) {
+            
+            int qubits[] = {1, 1};
+            REQUIRE_THROWS_WITH( calcProbOfAllOutcomes(vec, qubits, 2, outcomeProbs.data()), Contains("qubits must be unique") );
+        }
+    }
+    destroyQureg(vec, QUEST_ENV);
+    destroyQureg(mat, QUEST_ENV);
+}
+
+
+
 /** @sa calcProbOfOutcome
  * @ingroup unittest 
  * @author Tyson Jones 
@@ -1391,3 +1540,130 @@ TEST_CASE( "getRealAmp", "[calculations]" ) {
 }
 
 
+
+
+
+/** @sa sampleOutcomes
+ * @ingroup unittest 
+ */
+TEST_CASE( "sampleOutcomes", "[calculations]" ) {
+    
+    Qureg vec = createQureg(NUM_QUBITS, QUEST_ENV);
+    Qureg mat = createDensityQureg(NUM_QUBITS, QUEST_ENV);
+    
+    // enough shots that every outcome frequency is (very likely) within 0.025 of its probability
+    const int numShots = 1 << 14;
+    std::vector<long long int> outcomes(numShots);
+    
+    SECTION( "correctness" ) {
+        
+        int numQubits = GENERATE( range(1,NUM_QUBITS+1) );
+        int* qubits = GENERATE_COPY( sublists(range(0,NUM_QUBITS), numQubits) );
+        
+        // the probability of each outcome, from the probabilities of each basis state
+        std::vector<qreal> outcomeProbs(1 << numQubits);
+        std::vector<qreal> basisProbs(1 << NUM_QUBITS);
+        
+        SECTION( "state-vector" ) {
+            
+            SECTION( "basis state" ) {
+                
+                int ind = getRandomInt(0, 1<<NUM_QUBITS);
+                initClassicalState(vec, ind);
+                basisProbs[ind] = 1;
+                
+                long long int outcome = 0;
+                for (int q=0; q<numQubits; q++)
+                    outcome |= ((ind >> qubits[q]) & 1) << q;
+                
+                sampleOutcomes(vec, qubits, numQubits, numShots, outcomes.data());
+                REQUIRE( std::count(outcomes.begin(), outcomes.end(), outcome) == numShots );
+            }
+            SECTION( "random state" ) {
+                
+                QVector ref = getRandomStateVector(NUM_QUBITS);
+                toQureg(vec, ref);
+                for (size_t ind=0; ind<ref.size(); ind++)
+                    basisProbs[ind] = pow(abs(ref[ind]), 2);
+                
+                sampleOutcomes(vec, qubits, numQubits, numShots, outcomes.data());
+                
+                // the state is unchanged
+                REQUIRE( areEqual(vec, ref) );
+            }
+        }
+        SECTION( "density-matrix" ) {
+            
+            QMatrix ref = getRandomDensityMatrix(NUM_QUBITS);
+            toQureg(mat, ref);
+            for (size_t ind=0; ind<ref.size(); ind++)
+                basisProbs[ind] = real(ref[ind][ind]);
+            
+            sampleOutcomes(mat, qubits, numQubits, numShots, outcomes.data());
+            
+            // the state is unchanged
+            REQUIRE( areEqual(mat, ref) );
+        }
+        
+        // compare the frequency of every outcome to its probability
+        for (size_t ind=0; ind<basisProbs.size(); ind++) {
+            int outcome = 0;
+            for (int q=0; q<numQubits; q++)
+                outcome |= ((ind >> qubits[q]) & 1) << q;
+            outcomeProbs[outcome] += basisProbs[ind];
+        }
+        
+        for (int o=0; o<(1 << numQubits); o++) {
+            qreal freq = std::count(outcomes.begin(), outcomes.end(), o) / (qreal) numShots;
+            REQUIRE( freq == Approx(outcomeProbs[o]).margin(0.025) );
+        }
+    }
+    SECTION( "reproducibility" ) {
+        
+        QVector ref = getRandomStateVector(NUM_QUBITS);
+        toQureg(vec, ref);
+        int qubits[NUM_QUBITS];
+        for (int q=0; q<NUM_QUBITS; q++)
+            qubits[q] = q;
+        
+        // reseeding reproduces the same shots
+        unsigned long int seeds[] = {1, 2, 3};
+        std::vector<long long int> otherOutcomes(numShots);
+        seedQuEST(seeds, 3);
+        sampleOutcomes(vec, qubits, NUM_QUBITS, numShots, outcomes.data());
+        seedQuEST(seeds, 3);
+        sampleOutcomes(vec, qubits, NUM_QUBITS, numShots, otherOutcomes.data());
+        REQUIRE( outcomes == otherOutcomes );
+        
+        // restores the default (random) seeding of the remaining tests
+        seedQuESTDefault();
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "number of qubits" ) {
+            
+            int numQubits = GENERATE( -1, 0, NUM_QUBITS+1 );
+            int qubits[NUM_QUBITS+1];
+            REQUIRE_THROWS_WITH( sampleOutcomes(vec, qubits, numQubits, numShots, outcomes.data()), Contains("Invalid number of qubits") );
+        }
+        SECTION( "qubit indices" ) {
+            
+            int qubits[] = {0, 1};
+            qubits[GENERATE(0,1)] = GENERATE( -1, NUM_QUBITS );
+            REQUIRE_THROWS_WITH( sampleOutcomes(vec, qubits, 2, numShots, outcomes.data()), Contains("Invalid qubit index") );
+        }
+        SECTION( "repetition of qubits" ) {
+            
+            int qubits[] = {1, 1};
+            REQUIRE_THROWS_WITH( sampleOutcomes(mat, qubits, 2, numShots, outcomes.data()), Contains("qubits must be unique") );
+        }
+        SECTION( "number of shots" ) {
+            
+            int qubits[] = {0};
+            int shots = GENERATE( -1, 0 );
+            REQUIRE_THROWS_WITH( sampleOutcomes(vec, qubits, 1, shots, outcomes.data()), Contains("Invalid number of shots") );
+        }
+    }
+    destroyQureg(vec, QUEST_ENV);
+    destroyQureg(mat, QUEST_ENV);
+}
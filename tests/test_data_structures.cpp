@@ -183,6 +183,65 @@ TEST_CASE( "createDensityQureg", "[data_structures]" ) {
 
 
 
+/** @sa createDensityQuregWithPolicy
+ * @ingroup unittest 
+ */
+TEST_CASE( "createDensityQuregWithPolicy", "[data_structures]" ) {
+        
+    // must be at least one amplitude per node
+    int minNumQb = calcLog2(QUEST_ENV.numRanks) - 1; // density matrix has 2*numQb in state-vec
+    if (minNumQb <= 0)
+        minNumQb = 1;
+    
+    SECTION( "correctness" ) {
+        
+        enum memoryPolicy policy = GENERATE( MEMORY_DEFAULT, MEMORY_HUGE_PAGES, MEMORY_EXPLICIT_HUGE_PAGES, MEMORY_FILE_MAPPED );
+        
+        // file-mapped arrays are created in QUEST_FILE_MAPPED_DIR, which must be set
+        if (policy == MEMORY_FILE_MAPPED)
+            setenv("QUEST_FILE_MAPPED_DIR", getTempDirPath(), 1);
+        
+        // include a register whose arrays span several huge pages
+        int numQb = GENERATE_COPY( range(minNumQb, minNumQb+5), 10 );
+        Qureg reg = createDensityQuregWithPolicy(numQb, QUEST_ENV, policy);
+        
+        // ensure elems (CPU and/or GPU) are created, and reg begins in |0><0|
+        QMatrix ref = getZeroMatrix(1<<numQb);
+        ref[0][0] = 1; // |0><0|
+        REQUIRE( areEqual(reg, ref) );
+        
+        // ensure the arrays (including any pair buffer) are usable, and clones inherit the policy
+        int targ = numQb - 1;
+        hadamard(reg, targ);
+        Qureg clone = createCloneQureg(reg, QUEST_ENV);
+        REQUIRE( clone.memPolicy == policy );
+        REQUIRE( calcTotalProb(clone) == Approx(1) );
+        
+        destroyQureg(clone, QUEST_ENV);
+        destroyQureg(reg, QUEST_ENV);
+    }
+    SECTION( "input validation") {
+        
+        SECTION( "number of qubits" ) {
+            
+            int numQb = GENERATE( -1, 0 );
+            REQUIRE_THROWS_WITH( createDensityQuregWithPolicy(numQb, QUEST_ENV, MEMORY_DEFAULT), Contains("Invalid number of qubits") );
+        }
+        SECTION( "memory policy" ) {
+            
+            int policy = GENERATE( -1, 4 );
+            REQUIRE_THROWS_WITH( createDensityQuregWithPolicy(minNumQb, QUEST_ENV, (enum memoryPolicy) policy), Contains("Invalid memory policy") );
+        }
+        SECTION( "file-mapped directory" ) {
+            
+            unsetenv("QUEST_FILE_MAPPED_DIR");
+            REQUIRE_THROWS_WITH( createDensityQuregWithPolicy(minNumQb, QUEST_ENV, MEMORY_FILE_MAPPED), Contains("QUEST_FILE_MAPPED_DIR") );
+        }
+    }
+}
+
+
+
 /** @sa createDiagonalOp
  * @ingroup unittest 
  * @author Tyson Jones 
@@ -493,6 +552,65 @@ TEST_CASE( "createQureg", "[data_structures]" ) {
 
 
 
+/** @sa createQuregWithPolicy
+ * @ingroup unittest 
+ */
+TEST_CASE( "createQuregWithPolicy", "[data_structures]" ) {
+        
+    // must be at least one amplitude per node
+    int minNumQb = calcLog2(QUEST_ENV.numRanks);
+    if (minNumQb == 0)
+        minNumQb = 1;
+    
+    SECTION( "correctness" ) {
+        
+        enum memoryPolicy policy = GENERATE( MEMORY_DEFAULT, MEMORY_HUGE_PAGES, MEMORY_EXPLICIT_HUGE_PAGES, MEMORY_FILE_MAPPED );
+        
+        // file-mapped arrays are created in QUEST_FILE_MAPPED_DIR, which must be set
+        if (policy == MEMORY_FILE_MAPPED)
+            setenv("QUEST_FILE_MAPPED_DIR", getTempDirPath(), 1);
+        
+        // include a register whose arrays span several huge pages
+        int numQb = GENERATE_COPY( range(minNumQb, minNumQb+10), 20 );
+        Qureg reg = createQuregWithPolicy(numQb, QUEST_ENV, policy);
+        
+        // ensure elems (CPU and/or GPU) are created, and reg begins in |0>
+        QVector ref = QVector(1<<numQb);
+        ref[0] = 1; // |0>
+        REQUIRE( areEqual(reg, ref) );
+        
+        // ensure the arrays (including any pair buffer) are usable, and clones inherit the policy
+        int targ = numQb - 1;
+        hadamard(reg, targ);
+        Qureg clone = createCloneQureg(reg, QUEST_ENV);
+        REQUIRE( clone.memPolicy == policy );
+        REQUIRE( calcTotalProb(clone) == Approx(1) );
+        
+        destroyQureg(clone, QUEST_ENV);
+        destroyQureg(reg, QUEST_ENV);
+    }
+    SECTION( "input validation") {
+        
+        SECTION( "number of qubits" ) {
+            
+            int numQb = GENERATE( -1, 0 );
+            REQUIRE_THROWS_WITH( createQuregWithPolicy(numQb, QUEST_ENV, MEMORY_DEFAULT), Contains("Invalid number of qubits") );
+        }
+        SECTION( "memory policy" ) {
+            
+            int policy = GENERATE( -1, 4 );
+            REQUIRE_THROWS_WITH( createQuregWithPolicy(minNumQb, QUEST_ENV, (enum memoryPolicy) policy), Contains("Invalid memory policy") );
+        }
+        SECTION( "file-mapped directory" ) {
+            
+            unsetenv("QUEST_FILE_MAPPED_DIR");
+            REQUIRE_THROWS_WITH( createQuregWithPolicy(minNumQb, QUEST_ENV, MEMORY_FILE_MAPPED), Contains("QUEST_FILE_MAPPED_DIR") );
+        }
+    }
+}
+
+
+
 /** @sa destroyComplexMatrixN
  * @ingroup unittest 
  * @author Tyson Jones 
@@ -782,6 +900,119 @@ TEST_CASE( "setDiagonalOpElems", "[data_structures]" ) {
 
 
 
+/** @sa startQuregPool
+ * @ingroup unittest 
+ */
+TEST_CASE( "startQuregPool", "[data_structures]" ) {
+    
+    // must be at least one amplitude per node
+    int minNumQb = calcLog2(QUEST_ENV.numRanks);
+    if (minNumQb == 0)
+        minNumQb = 1;
+    int numQb = 2*minNumQb + 2; // even, so that a density matrix can share the memory
+    
+    startQuregPool(QUEST_ENV);
+    
+    SECTION( "correctness" ) {
+        
+        SECTION( "state-vector" ) {
+            
+            Qureg reg = createQureg(numQb, QUEST_ENV);
+            qreal* amps = reg.stateVec.real;
+            startRecordingQASM(reg);
+            hadamard(reg, 0);
+            destroyQureg(reg, QUEST_ENV);
+            
+            // the recycled qureg reuses the memory, but begins in |0>
+            reg = createQureg(numQb, QUEST_ENV);
+            REQUIRE( reg.stateVec.real == amps );
+            QVector ref = QVector(1<<numQb);
+            ref[0] = 1;
+            REQUIRE( areEqual(reg, ref) );
+            
+            // as does a density matrix with as many amplitudes, which still records correct QASM
+            destroyQureg(reg, QUEST_ENV);
+            Qureg rho = createDensityQureg(numQb/2, QUEST_ENV);
+            REQUIRE( rho.stateVec.real == amps );
+            REQUIRE( rho.qasmLog->isLogging == 0 );
+            REQUIRE( std::string(rho.qasmLog->buffer).find("qreg q[" + std::to_string(numQb/2) + "]") != std::string::npos );
+            destroyQureg(rho, QUEST_ENV);
+        }
+        SECTION( "clone" ) {
+            
+            Qureg reg = createQureg(numQb, QUEST_ENV);
+            Qureg tmp = createQureg(numQb, QUEST_ENV);
+            qreal* amps = tmp.stateVec.real;
+            destroyQureg(tmp, QUEST_ENV);
+            
+            // clones reuse memory of the same size, and copy the original state
+            hadamard(reg, 0);
+            Qureg clone = createCloneQureg(reg, QUEST_ENV);
+            REQUIRE( clone.stateVec.real == amps );
+            REQUIRE( areEqual(clone, toQVector(reg)) );
+            
+            destroyQureg(clone, QUEST_ENV);
+            destroyQureg(reg, QUEST_ENV);
+        }
+        SECTION( "differing size or policy" ) {
+            
+            Qureg reg = createQureg(numQb, QUEST_ENV);
+            Qureg other = createQureg(numQb+1, QUEST_ENV);
+            qreal* amps = reg.stateVec.real;
+            destroyQureg(reg, QUEST_ENV);
+            
+            // memory is only reused by quregs of the same size and policy, so stays pooled
+            Qureg big = createQureg(numQb+1, QUEST_ENV);
+            Qureg huge = createQuregWithPolicy(numQb, QUEST_ENV, MEMORY_HUGE_PAGES);
+            REQUIRE( big.stateVec.real != amps );
+            REQUIRE( huge.stateVec.real != amps );
+            
+            reg = createQureg(numQb, QUEST_ENV);
+            REQUIRE( reg.stateVec.real == amps );
+            
+            destroyQureg(reg, QUEST_ENV);
+            destroyQureg(huge, QUEST_ENV);
+            destroyQureg(big, QUEST_ENV);
+            destroyQureg(other, QUEST_ENV);
+        }
+    }
+    
+    stopQuregPool(QUEST_ENV);
+}
+
+
+
+/** @sa stopQuregPool
+ * @ingroup unittest 
+ */
+TEST_CASE( "stopQuregPool", "[data_structures]" ) {
+    
+    // must be at least one amplitude per node
+    int minNumQb = calcLog2(QUEST_ENV.numRanks);
+    if (minNumQb == 0)
+        minNumQb = 1;
+    int numQb = minNumQb + 2;
+    
+    SECTION( "correctness" ) {
+        
+        startQuregPool(QUEST_ENV);
+        Qureg reg = createQureg(numQb, QUEST_ENV);
+        destroyQureg(reg, QUEST_ENV);
+        REQUIRE( QUEST_ENV.quregPool->bins[MEMORY_DEFAULT][numQb] != nullptr );
+        
+        // stopping frees the pooled memory
+        stopQuregPool(QUEST_ENV);
+        REQUIRE( QUEST_ENV.quregPool->bins[MEMORY_DEFAULT][numQb] == nullptr );
+        
+        // and destroyed quregs are no longer pooled
+        reg = createQureg(numQb, QUEST_ENV);
+        destroyQureg(reg, QUEST_ENV);
+        REQUIRE( QUEST_ENV.quregPool->bins[MEMORY_DEFAULT][numQb] == nullptr );
+    }
+}
+
+
+
 /** @sa syncDiagonalOp
  * @ingroup unittest 
  * @author Tyson Jones 
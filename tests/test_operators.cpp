@@ -594,6 +594,12 @@ TEST_CASE( "applyPauliSum", "[operators]" ) {
         qreal coeffs[numTerms];
         pauliOpType paulis[numPaulis];
         setRandomPauliSum(coeffs, paulis, NUM_QUBITS, numTerms);
+        
+        // terms with the same X (or Y) operators are applied together, so we also 
+        // try sums where each term shares its X mask with the first or second term
+        int shareXMasks = GENERATE( 0, 1 );
+        if (shareXMasks)
+            setRandomPauliSumSharingXMasks(paulis, NUM_QUBITS, numTerms);
         QMatrix pauliSum = toQMatrix(coeffs, paulis, NUM_QUBITS, numTerms);
         
         SECTION( "state-vector" ) {
@@ -892,3 +898,201 @@ TEST_CASE( "applyTrotterCircuit", "[operators]" ) {
     destroyQureg(matRef, QUEST_ENV);
 }
 
+
+
+/* applies each rotation of the Trotter-Suzuki decomposition described in 
+ * applyTrotterCircuit's documentation, without any simplification
+ */
+static void applyReferenceSymmetrizedTrotter(Qureg qureg, PauliHamil hamil, qreal time, int order) {
+    
+    std::vector<int> targs(hamil.numQubits);
+    for (int q=0; q<hamil.numQubits; q++)
+        targs[q] = q;
+    
+    if (order == 1 || order == 2) {
+        qreal fac = (order == 1)? time : time/2;
+        for (int i=0; i<hamil.numSumTerms; i++)
+            multiRotatePauli(qureg, targs.data(), &hamil.pauliCodes[i*hamil.numQubits], 
+                hamil.numQubits, 2*fac*hamil.termCoeffs[i]);
+        if (order == 2)
+            for (int i=hamil.numSumTerms-1; i>=0; i--)
+                multiRotatePauli(qureg, targs.data(), &hamil.pauliCodes[i*hamil.numQubits], 
+                    hamil.numQubits, 2*fac*hamil.termCoeffs[i]);
+        return;
+    }
+    
+    qreal p = 1. / (4 - pow(4, 1./(order-1)));
+    qreal times[] = {p*time, p*time, (1-4*p)*time, p*time, p*time};
+    for (int i=0; i<5; i++)
+        applyReferenceSymmetrizedTrotter(qureg, hamil, times[i], order-2);
+}
+
+/** @sa applyTrotterPlan
+ * @ingroup unittest 
+ */
+TEST_CASE( "applyTrotterPlan", "[operators]" ) {
+    
+    Qureg vec = createQureg(NUM_QUBITS, QUEST_ENV);
+    Qureg mat = createDensityQureg(NUM_QUBITS, QUEST_ENV);
+    initDebugState(vec);
+    initDebugState(mat);
+    
+    Qureg vecRef = createCloneQureg(vec, QUEST_ENV);
+    Qureg matRef = createCloneQureg(mat, QUEST_ENV);
+
+    SECTION( "correctness" ) {
+        
+        SECTION( "simplified circuit" ) {
+            
+            /* A random Hamiltonian with diagonal terms (which are grouped into 
+             * passes) and a repeated term (which may be merged), compared against 
+             * every rotation of the unsimplified decomposition
+             */
+            int numTerms = 6;
+            PauliHamil hamil = createPauliHamil(NUM_QUBITS, numTerms);
+            setRandomPauliSum(hamil);
+            for (int t=1; t<=3; t+=2)
+                for (int q=0; q<NUM_QUBITS; q++)
+                    hamil.pauliCodes[q + t*NUM_QUBITS] = (getRandomInt(0,2))? PAULI_Z : PAULI_I;
+            for (int q=0; q<NUM_QUBITS; q++)
+                hamil.pauliCodes[q + 4*NUM_QUBITS] = hamil.pauliCodes[q];
+            
+            // time can be negative
+            qreal time = getRandomReal(-2,2);
+            int reps = GENERATE( 1, 2, 3 );
+            
+            SECTION( "state-vector" ) {
+                
+                int order = GENERATE( 1, 2, 4 );
+                
+                TrotterPlan plan = createTrotterPlan(hamil, time, order, reps);
+                applyTrotterPlan(vec, plan);
+                for (int r=0; r<reps; r++)
+                    applyReferenceSymmetrizedTrotter(vecRef, hamil, time/reps, order);
+                REQUIRE( areEqual(vec, vecRef, 1E2*REAL_EPS) );
+                
+                destroyTrotterPlan(plan);
+            }
+            SECTION( "density-matrix" ) {
+                
+                int order = GENERATE( 1, 2 ); // precision hurts density matrices quickly
+                
+                TrotterPlan plan = createTrotterPlan(hamil, time, order, reps);
+                applyTrotterPlan(mat, plan);
+                for (int r=0; r<reps; r++)
+                    applyReferenceSymmetrizedTrotter(matRef, hamil, time/reps, order);
+                REQUIRE( areEqual(mat, matRef, 1E2*REAL_EPS) );
+                
+                destroyTrotterPlan(plan);
+            }
+            
+            destroyPauliHamil(hamil);
+        }
+        SECTION( "merged rotations" ) {
+            
+            // H = c0 X Y Z + c1 Z I Z (on qubits 0,1,2), whose terms do not commute
+            PauliHamil hamil = createPauliHamil(NUM_QUBITS, 2);
+            hamil.pauliCodes[0] = PAULI_X;
+            hamil.pauliCodes[1] = PAULI_Y;
+            hamil.pauliCodes[2] = PAULI_Z;
+            hamil.pauliCodes[0 + NUM_QUBITS] = PAULI_Z;
+            hamil.pauliCodes[2 + NUM_QUBITS] = PAULI_Z;
+            for (int i=0; i<hamil.numSumTerms; i++)
+                hamil.termCoeffs[i] = getRandomReal(-5,5); 
+            
+            int reps = GENERATE( range(1,5) );
+            
+            SECTION( "non-commuting" ) {
+                
+                // the repeated terms at the boundaries of each sweep and repetition are merged
+                TrotterPlan plan = createTrotterPlan(hamil, 1, 2, reps);
+                REQUIRE( plan.numTerms == 2*reps + 1 );
+                destroyTrotterPlan(plan);
+            }
+            SECTION( "commuting" ) {
+                
+                // H = c0 Z Z I + c1 Z I Z, whose rotations all merge
+                hamil.pauliCodes[0] = PAULI_Z;
+                hamil.pauliCodes[1] = PAULI_Z;
+                hamil.pauliCodes[2] = PAULI_I;
+                
+                int order = GENERATE( 1, 2, 4 );
+                TrotterPlan plan = createTrotterPlan(hamil, 1, order, reps);
+                REQUIRE( plan.numTerms == 2 );
+                destroyTrotterPlan(plan);
+            }
+            
+            destroyPauliHamil(hamil);
+        }
+        SECTION( "reusable" ) {
+            
+            PauliHamil hamil = createPauliHamil(NUM_QUBITS, 3);
+            setRandomPauliSum(hamil);
+            
+            qreal time = getRandomReal(-2,2);
+            TrotterPlan plan = createTrotterPlan(hamil, time, 2, 3);
+            applyTrotterCircuit(vecRef, hamil, time, 2, 3);
+            applyTrotterCircuit(vecRef, hamil, time, 2, 3);
+            
+            // the plan does not depend upon the Hamiltonian after creation
+            setRandomPauliSum(hamil);
+            destroyPauliHamil(hamil);
+            
+            applyTrotterPlan(vec, plan);
+            applyTrotterPlan(vec, plan);
+            REQUIRE( areEqual(vec, vecRef, 10*REAL_EPS) );
+            
+            destroyTrotterPlan(plan);
+        }
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "repetitions" ) {
+            
+            PauliHamil hamil = createPauliHamil(NUM_QUBITS, 1);
+            int reps = GENERATE( -1, 0 );
+            
+            REQUIRE_THROWS_WITH( createTrotterPlan(hamil, 1, 1, reps), Contains("repetitions must be >=1") );
+            
+            destroyPauliHamil(hamil);
+        }
+        SECTION( "order" ) {
+            
+            PauliHamil hamil = createPauliHamil(NUM_QUBITS, 1);
+            int order = GENERATE( -1, 0, 3, 5, 7 );
+            
+            REQUIRE_THROWS_WITH( createTrotterPlan(hamil, 1, order, 1), Contains("order must be 1, or an even number") );
+            
+            destroyPauliHamil(hamil);
+        }
+        SECTION( "pauli codes" ) {
+            
+            int numTerms = 3;
+            PauliHamil hamil = createPauliHamil(NUM_QUBITS, numTerms);
+
+            // make one pauli code wrong
+            hamil.pauliCodes[GENERATE_COPY( range(0,numTerms*NUM_QUBITS) )] = (pauliOpType) GENERATE( -1, 4 );
+            REQUIRE_THROWS_WITH( createTrotterPlan(hamil, 1, 1, 1), Contains("Invalid Pauli code") );
+            
+            destroyPauliHamil(hamil);
+        }
+        SECTION( "matching plan qubits" ) {
+            
+            PauliHamil hamil = createPauliHamil(NUM_QUBITS + 1, 1);
+            hamil.termCoeffs[0] = 1;
+            TrotterPlan plan = createTrotterPlan(hamil, 1, 1, 1);
+            
+            REQUIRE_THROWS_WITH( applyTrotterPlan(vec, plan), Contains("same number of qubits") );
+            REQUIRE_THROWS_WITH( applyTrotterPlan(mat, plan), Contains("same number of qubits") );
+            
+            destroyTrotterPlan(plan);
+            destroyPauliHamil(hamil);
+        }
+    }
+    
+    destroyQureg(vec, QUEST_ENV);
+    destroyQureg(mat, QUEST_ENV);
+    destroyQureg(vecRef, QUEST_ENV);
+    destroyQureg(matRef, QUEST_ENV);
+}
+
@@ -5,6 +5,9 @@
     
 /* allows concise use of Contains in catch's REQUIRE_THROWS_WITH */
 using Catch::Matchers::Contains;
+
+/* declared in QuEST_debug.h, which is private to the QuEST library */
+extern "C" void initStateFromSingleFile(Qureg *qureg, char filename[200], QuESTEnv env);
     
     
 
@@ -320,6 +323,100 @@ TEST_CASE( "initStateFromAmps", "[state_initialisations]" ) {
 
 
 
+/** @sa initStateFromSingleFile
+ * @ingroup unittest 
+ */
+TEST_CASE( "initStateFromSingleFile", "[state_initialisations]" ) {
+    
+    std::string path = std::string(getTempDirPath()) + "/test_state.csv";
+    char* fn = &path[0];
+    Qureg vec = createQureg(NUM_QUBITS, QUEST_ENV);
+    QVector ref = getRandomQVector(1<<NUM_QUBITS);
+    
+    // the "real, imag" line of each amplitude in ref
+    std::vector<std::string> ampLines(ref.size());
+    for (size_t i=0; i<ref.size(); i++) {
+        char line[200];
+        sprintf(line, REAL_STRING_FORMAT ", " REAL_STRING_FORMAT "\n", real(ref[i]), imag(ref[i]));
+        ampLines[i] = line;
+    }
+    
+    // only the root node writes the file
+    auto writeFile = [&](std::vector<std::string> lines) {
+        if (QUEST_ENV.rank == 0) {
+            FILE* file = fopen(fn, "w");
+            for (std::string line : lines)
+                fputs(line.c_str(), file);
+            fclose(file);
+        }
+        syncQuESTEnv(QUEST_ENV);
+    };
+    
+    SECTION( "correctness" ) {
+        
+        SECTION( "round trip" ) {
+            
+            writeFile(ampLines);
+            initBlankState(vec);
+            initStateFromSingleFile(&vec, fn, QUEST_ENV);
+            REQUIRE( areEqual(vec, ref) );
+        }
+        SECTION( "comment lines" ) {
+            
+            // comments in the header, and between amplitudes, are ignored
+            std::vector<std::string> lines = ampLines;
+            lines.insert(lines.begin() + ref.size()/2, "# halfway\n");
+            lines.insert(lines.begin(), "# real, imag\n");
+            lines.insert(lines.begin(), "# a state-vector of " + std::to_string(NUM_QUBITS) + " qubits\n");
+            
+            writeFile(lines);
+            initBlankState(vec);
+            initStateFromSingleFile(&vec, fn, QUEST_ENV);
+            REQUIRE( areEqual(vec, ref) );
+        }
+        SECTION( "overlong lines" ) {
+            
+            // lines longer than the line buffer are each read as a single line
+            std::vector<std::string> lines = ampLines;
+            lines.insert(lines.begin() + 1, "#" + std::string(500, 'x') + "\n");
+            std::string& padded = lines[ref.size()/2];
+            padded.insert(padded.size() - 1, std::string(500, ' '));
+            
+            writeFile(lines);
+            initBlankState(vec);
+            initStateFromSingleFile(&vec, fn, QUEST_ENV);
+            REQUIRE( areEqual(vec, ref) );
+        }
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "file existence" ) {
+            
+            std::string nonexistent = std::string(getTempDirPath()) + "/nonexistent_state.csv";
+            REQUIRE_THROWS_WITH( initStateFromSingleFile(&vec, &nonexistent[0], QUEST_ENV), Contains("Could not open file") );
+        }
+        SECTION( "truncated file" ) {
+            
+            // a file with too few amplitude lines
+            std::vector<std::string> lines(ampLines.begin(), ampLines.end() - 1);
+            writeFile(lines);
+            REQUIRE_THROWS_WITH( initStateFromSingleFile(&vec, fn, QUEST_ENV), Contains("must contain a line") );
+            syncQuESTEnv(QUEST_ENV);
+            
+            // a file whose last amplitude line is cut short
+            lines.push_back(ampLines.back().substr(0, ampLines.back().find(',') + 1));
+            writeFile(lines);
+            REQUIRE_THROWS_WITH( initStateFromSingleFile(&vec, fn, QUEST_ENV), Contains("must contain a line") );
+        }
+    }
+    syncQuESTEnv(QUEST_ENV);
+    if (QUEST_ENV.rank == 0)
+        remove(fn);
+    destroyQureg(vec, QUEST_ENV);
+}
+
+
+
 /** @sa initZeroState
  * @ingroup unittest 
  * @author Tyson Jones 
@@ -361,6 +458,219 @@ TEST_CASE( "initZeroState", "[state_initialisations]" ) {
 
 
 
+/** @sa loadQuregCheckpoint
+ * @ingroup unittest 
+ */
+TEST_CASE( "loadQuregCheckpoint", "[state_initialisations]" ) {
+    
+    std::string path = std::string(getTempDirPath()) + "/test_checkpoint.qchk";
+    char* fn = &path[0];
+    Qureg vec = createQureg(NUM_QUBITS, QUEST_ENV);
+    Qureg mat = createDensityQureg(NUM_QUBITS, QUEST_ENV);
+    
+    // writes a checkpoint header, with its fields little-endian at fixed width, padded to 4096 bytes
+    auto writeHeader = [](FILE* file, int qrealSize, int numQubits, int isDensity, long long int numAmps) {
+        std::vector<unsigned char> header(4096, 0);
+        std::string magic = "QuESTchk";
+        std::copy(magic.begin(), magic.end(), header.begin());
+        unsigned int one = 1;
+        int isBigEndian = (*((unsigned char*) &one) == 0);
+        unsigned long long int fields[] = {2, 1, (unsigned long long int) qrealSize, 
+            (unsigned long long int) numQubits, (unsigned long long int) isDensity, 3, 
+            (unsigned long long int) numAmps, (unsigned long long int) isBigEndian};
+        int widths[] = {4, 4, 4, 4, 4, 4, 8, 4};
+        size_t pos = 8;
+        for (int f=0; f<8; f++)
+            for (int b=0; b<widths[f]; b++)
+                header[pos++] = (unsigned char) (fields[f] >> (8*b));
+        fwrite(header.data(), 1, header.size(), file);
+    };
+    
+    SECTION( "correctness" ) {
+        
+        SECTION( "state-vector" ) {
+            
+            QVector ref = getRandomQVector(1<<NUM_QUBITS);
+            toQureg(vec, ref);
+            saveQuregCheckpoint(vec, fn, QUEST_ENV);
+            
+            initBlankState(vec);
+            loadQuregCheckpoint(vec, fn, QUEST_ENV);
+            REQUIRE( areEqual(vec, ref) );
+        }
+        SECTION( "density-matrix" ) {
+            
+            QMatrix ref = getRandomDensityMatrix(NUM_QUBITS);
+            toQureg(mat, ref);
+            saveQuregCheckpoint(mat, fn, QUEST_ENV);
+            
+            initBlankState(mat);
+            loadQuregCheckpoint(mat, fn, QUEST_ENV);
+            REQUIRE( areEqual(mat, ref) );
+        }
+        SECTION( "single precision" ) {
+            
+            /* a checkpoint written in single precision (with the header layout of 
+             * saveQuregCheckpoint) is converted upon load, and by any number of nodes 
+             */
+            QVector ref = getRandomQVector(1<<NUM_QUBITS);
+            if (QUEST_ENV.rank == 0) {
+                FILE* file = fopen(fn, "wb");
+                writeHeader(file, sizeof(float), NUM_QUBITS, 0, 1LL<<NUM_QUBITS);
+                for (size_t i=0; i<ref.size(); i++) {
+                    float re = (float) real(ref[i]);
+                    fwrite(&re, sizeof re, 1, file);
+                }
+                for (size_t i=0; i<ref.size(); i++) {
+                    float im = (float) imag(ref[i]);
+                    fwrite(&im, sizeof im, 1, file);
+                }
+                fclose(file);
+            }
+            syncQuESTEnv(QUEST_ENV);
+            
+            loadQuregCheckpoint(vec, fn, QUEST_ENV);
+            REQUIRE( areEqual(vec, ref, 1E-6) );
+        }
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "file existence" ) {
+            
+            std::string nonexistent = std::string(getTempDirPath()) + "/nonexistent_checkpoint.qchk";
+            REQUIRE_THROWS_WITH( loadQuregCheckpoint(vec, &nonexistent[0], QUEST_ENV), Contains("Could not open file") );
+        }
+        SECTION( "file format" ) {
+            
+            // a file which isn't a checkpoint
+            if (QUEST_ENV.rank == 0) {
+                FILE* file = fopen(fn, "w");
+                fprintf(file, "real, imag\n1, 0\n");
+                fclose(file);
+            }
+            syncQuESTEnv(QUEST_ENV);
+            REQUIRE_THROWS_WITH( loadQuregCheckpoint(vec, fn, QUEST_ENV), Contains("not a complete QuEST checkpoint") );
+            syncQuESTEnv(QUEST_ENV);
+            
+            // a checkpoint which has been truncated
+            saveQuregCheckpoint(vec, fn, QUEST_ENV);
+            if (QUEST_ENV.rank == 0) {
+                FILE* file = fopen(fn, "r+b");
+                std::vector<char> contents(4096 + 2*vec.numAmpsTotal*sizeof(qreal) - 1);
+                REQUIRE( fread(contents.data(), 1, contents.size(), file) == contents.size() );
+                fclose(file);
+                file = fopen(fn, "wb");
+                fwrite(contents.data(), 1, contents.size(), file);
+                fclose(file);
+            }
+            syncQuESTEnv(QUEST_ENV);
+            REQUIRE_THROWS_WITH( loadQuregCheckpoint(vec, fn, QUEST_ENV), Contains("not a complete QuEST checkpoint") );
+        }
+        SECTION( "header fields" ) {
+            
+            // headers with an invalid density-matrix flag, or too many qubits to be represented
+            int isDensity = GENERATE( 0, 1, 2 );
+            int numQubits = (isDensity == 1)? 40 : 63;
+            if (isDensity == 2)
+                numQubits = NUM_QUBITS;
+            if (QUEST_ENV.rank == 0) {
+                FILE* file = fopen(fn, "wb");
+                writeHeader(file, sizeof(qreal), numQubits, isDensity, 1LL<<NUM_QUBITS);
+                fclose(file);
+            }
+            syncQuESTEnv(QUEST_ENV);
+            REQUIRE_THROWS_WITH( loadQuregCheckpoint(vec, fn, QUEST_ENV), Contains("not a complete QuEST checkpoint") );
+        }
+        SECTION( "qureg dimensions" ) {
+            
+            saveQuregCheckpoint(vec, fn, QUEST_ENV);
+            REQUIRE_THROWS_WITH( loadQuregCheckpoint(mat, fn, QUEST_ENV), Contains("same number of qubits") );
+            
+            Qureg other = createQureg(NUM_QUBITS + 1, QUEST_ENV);
+            REQUIRE_THROWS_WITH( loadQuregCheckpoint(other, fn, QUEST_ENV), Contains("same number of qubits") );
+            destroyQureg(other, QUEST_ENV);
+        }
+    }
+    syncQuESTEnv(QUEST_ENV);
+    if (QUEST_ENV.rank == 0)
+        remove(fn);
+    destroyQureg(vec, QUEST_ENV);
+    destroyQureg(mat, QUEST_ENV);
+}
+
+
+
+/** @sa saveQuregCheckpoint
+ * @ingroup unittest 
+ */
+TEST_CASE( "saveQuregCheckpoint", "[state_initialisations]" ) {
+    
+    std::string path = std::string(getTempDirPath()) + "/test_checkpoint.qchk";
+    char* fn = &path[0];
+    Qureg vec = createQureg(NUM_QUBITS, QUEST_ENV);
+    
+    SECTION( "correctness" ) {
+        
+        SECTION( "file layout" ) {
+            
+            // the file is independent of the number of nodes which wrote it
+            QVector ref = getRandomQVector(1<<NUM_QUBITS);
+            toQureg(vec, ref);
+            saveQuregCheckpoint(vec, fn, QUEST_ENV);
+            
+            FILE* file = fopen(fn, "rb");
+            REQUIRE( file != NULL );
+            // the header fields are little-endian and of fixed width, independent of the writer
+            unsigned char header[44];
+            REQUIRE( fread(header, 1, sizeof header, file) == sizeof header );
+            REQUIRE( std::string((char*) header, 8) == "QuESTchk" );
+            unsigned long long int fields[8];
+            int widths[] = {4, 4, 4, 4, 4, 4, 8, 4};
+            size_t pos = 8;
+            for (int f=0; f<8; f++) {
+                fields[f] = 0;
+                for (int b=0; b<widths[f]; b++)
+                    fields[f] |= ((unsigned long long int) header[pos++]) << (8*b);
+            }
+            unsigned int one = 1;
+            REQUIRE( fields[0] == 2 );
+            REQUIRE( fields[1] == QuEST_PREC );
+            REQUIRE( fields[2] == sizeof(qreal) );
+            REQUIRE( fields[3] == NUM_QUBITS );
+            REQUIRE( fields[4] == 0 );
+            REQUIRE( fields[5] == (unsigned long long int) QUEST_ENV.numRanks );
+            REQUIRE( fields[6] == (1ULL << NUM_QUBITS) );
+            REQUIRE( fields[7] == (*((unsigned char*) &one) == 0) );
+            
+            std::vector<qreal> re(ref.size()), im(ref.size());
+            REQUIRE( fseek(file, 4096, SEEK_SET) == 0 );
+            REQUIRE( fread(re.data(), sizeof(qreal), re.size(), file) == re.size() );
+            REQUIRE( fread(im.data(), sizeof(qreal), im.size(), file) == im.size() );
+            REQUIRE( fgetc(file) == EOF );
+            fclose(file);
+            
+            for (size_t i=0; i<ref.size(); i++) {
+                REQUIRE( re[i] == real(ref[i]) );
+                REQUIRE( im[i] == imag(ref[i]) );
+            }
+        }
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "file access" ) {
+            
+            std::string unwritable = std::string(getTempDirPath()) + "/nonexistent_directory/checkpoint.qchk";
+            REQUIRE_THROWS_WITH( saveQuregCheckpoint(vec, &unwritable[0], QUEST_ENV), Contains("Could not write to file") );
+        }
+    }
+    syncQuESTEnv(QUEST_ENV);
+    if (QUEST_ENV.rank == 0)
+        remove(fn);
+    destroyQureg(vec, QUEST_ENV);
+}
+
+
+
 /** @sa setAmps
  * @ingroup unittest 
  * @author Tyson Jones 
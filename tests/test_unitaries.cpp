@@ -845,6 +845,95 @@ TEST_CASE( "hadamard", "[unitaries]" ) {
 
 
 
+/** @sa multiControlledMultiQubitNot
+ * @ingroup unittest 
+ */
+TEST_CASE( "multiControlledMultiQubitNot", "[unitaries]" ) {
+    
+    PREPARE_TEST( quregVec, quregMatr, refVec, refMatr );
+    
+    SECTION( "correctness" ) {
+        
+        // try all possible numbers of targets and controls
+        int numTargs = GENERATE_COPY( range(1,NUM_QUBITS) );
+        int maxNumCtrls = NUM_QUBITS - numTargs;
+        int numCtrls = GENERATE_COPY( range(1,maxNumCtrls+1) );
+        
+        // generate all possible valid qubit arrangements
+        int* targs = GENERATE_COPY( sublists(range(0,NUM_QUBITS), numTargs) );
+        int* ctrls = GENERATE_COPY( sublists(range(0,NUM_QUBITS), numCtrls, targs, numTargs) );
+        
+        // the reference is X upon every target
+        QMatrix xOp{{0,1},{1,0}};
+        QMatrix op = xOp;
+        for (int t=1; t<numTargs; t++)
+            op = getKroneckerProduct(op, xOp);
+        
+        SECTION( "state-vector" ) {
+            
+            multiControlledMultiQubitNot(quregVec, ctrls, numCtrls, targs, numTargs);
+            applyReferenceOp(refVec, ctrls, numCtrls, targs, numTargs, op);
+            REQUIRE( areEqual(quregVec, refVec) );
+        }
+        SECTION( "density-matrix" ) {
+            
+            multiControlledMultiQubitNot(quregMatr, ctrls, numCtrls, targs, numTargs);
+            applyReferenceOp(refMatr, ctrls, numCtrls, targs, numTargs, op);
+            REQUIRE( areEqual(quregMatr, refMatr) );
+        }
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "number of targets" ) {
+            
+            int numTargs = GENERATE( -1, 0, NUM_QUBITS+1 );
+            int targs[NUM_QUBITS+1]; // prevents seg-fault if validation doesn't trigger
+            int ctrls[] = {0};
+            REQUIRE_THROWS_WITH( multiControlledMultiQubitNot(quregVec, ctrls, 1, targs, numTargs), Contains("Invalid number of target"));
+        }
+        SECTION( "repetition in targets" ) {
+            
+            int ctrls[] = {0};
+            int targs[] = {1,2,2};
+            REQUIRE_THROWS_WITH( multiControlledMultiQubitNot(quregVec, ctrls, 1, targs, 3), Contains("target") && Contains("unique"));
+        }
+        SECTION( "number of controls" ) {
+            
+            int numCtrls = GENERATE( -1, 0, NUM_QUBITS, NUM_QUBITS+1 );
+            int ctrls[NUM_QUBITS+1]; // avoids seg-fault if validation not triggered
+            int targs[1] = {0};
+            REQUIRE_THROWS_WITH( multiControlledMultiQubitNot(quregVec, ctrls, numCtrls, targs, 1), Contains("Invalid number of control"));
+        }
+        SECTION( "repetition in controls" ) {
+            
+            int ctrls[] = {0,1,1};
+            int targs[] = {3};
+            REQUIRE_THROWS_WITH( multiControlledMultiQubitNot(quregVec, ctrls, 3, targs, 1), Contains("control") && Contains("unique"));
+        }
+        SECTION( "control and target collision" ) {
+            
+            int ctrls[] = {0,1,2};
+            int targs[] = {3,1,4};
+            REQUIRE_THROWS_WITH( multiControlledMultiQubitNot(quregVec, ctrls, 3, targs, 3), Contains("Control") && Contains("target") && Contains("disjoint"));
+        }
+        SECTION( "qubit indices" ) {
+            
+            int qb1[2] = {0,1};
+            int qb2[2] = {2,3};
+            
+            // make qb1 invalid
+            int inv = GENERATE( -1, NUM_QUBITS );
+            qb1[GENERATE(range(0,2))] = inv;
+            
+            REQUIRE_THROWS_WITH( multiControlledMultiQubitNot(quregVec, qb1, 2, qb2, 2), Contains("Invalid control") );
+            REQUIRE_THROWS_WITH( multiControlledMultiQubitNot(quregVec, qb2, 2, qb1, 2), Contains("Invalid target") );
+        }
+    }
+    CLEANUP_TEST( quregVec, quregMatr );
+}
+
+
+
 /** @sa multiControlledMultiQubitUnitary
  * @ingroup unittest 
  * @author Tyson Jones 
@@ -2131,6 +2220,252 @@ TEST_CASE( "sqrtSwapGate", "[unitaries]" ) {
 
 
 
+/** @sa startBlockedGateFusion
+ * @ingroup unittest 
+ */
+TEST_CASE( "startBlockedGateFusion", "[unitaries]" ) {
+    
+    PREPARE_TEST( quregVec, quregMatr, refVec, refMatr );
+    
+    SECTION( "correctness" ) {
+        
+        int maxNumQubits = GENERATE( range(1,4) );
+        int numBlockQubits = GENERATE_COPY( range(maxNumQubits,NUM_QUBITS+1) );
+        
+        // a circuit mostly upon low qubits, interrupted by gates upon the highest qubit
+        qreal a = 1/sqrt(2);
+        qreal param = getRandomReal(-4*M_PI, 4*M_PI);
+        QMatrix hOp{{a,a},{a,-a}};
+        QMatrix xOp{{0,1},{1,0}};
+        QMatrix ryOp{{cos(param/2), -sin(param/2)},{sin(param/2), cos(param/2)}};
+        QMatrix op1 = getRandomUnitary(1);
+        QMatrix op2 = getRandomUnitary(2);
+        int targs2[] = {2, 0};
+        int high = NUM_QUBITS-1;
+        
+        auto applyCircuit = [&](Qureg qureg, auto& ref) {
+            for (int rep=0; rep < 3; rep++) {
+                for (int q=0; q < NUM_QUBITS-1; q++) {
+                    hadamard(qureg, q);
+                    applyReferenceOp(ref, q, hOp);
+                }
+                controlledNot(qureg, 0, 1);
+                applyReferenceOp(ref, 0, 1, xOp);
+                twoQubitUnitary(qureg, targs2[0], targs2[1], toComplexMatrix4(op2));
+                applyReferenceOp(ref, targs2, 2, op2);
+                rotateY(qureg, 3, param);
+                applyReferenceOp(ref, 3, ryOp);
+                unitary(qureg, 1, toComplexMatrix2(op1));
+                applyReferenceOp(ref, 1, op1);
+                controlledNot(qureg, high, 0);
+                applyReferenceOp(ref, high, 0, xOp);
+            }
+        };
+        
+        SECTION( "state-vector" ) {
+            
+            startBlockedGateFusion(quregVec, maxNumQubits, numBlockQubits);
+            applyCircuit(quregVec, refVec);
+            stopGateFusion(quregVec);
+            REQUIRE( areEqual(quregVec, refVec) );
+        }
+        SECTION( "density-matrix" ) {
+            
+            startBlockedGateFusion(quregMatr, maxNumQubits, numBlockQubits);
+            applyCircuit(quregMatr, refMatr);
+            stopGateFusion(quregMatr);
+            REQUIRE( areEqual(quregMatr, refMatr, 100*REAL_EPS) );
+        }
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "number of fused qubits" ) {
+            
+            int maxNumQubits = GENERATE( -1, 0, NUM_QUBITS+1 );
+            REQUIRE_THROWS_WITH( startBlockedGateFusion(quregVec, maxNumQubits, NUM_QUBITS), Contains("Invalid maximum number of fused qubits") );
+        }
+        SECTION( "number of block qubits" ) {
+            
+            // blocks must contain the fused matrices, and fit in the register
+            int maxNumQubits = 3;
+            int numBlockQubits = GENERATE( 0, 2, NUM_QUBITS+1 );
+            REQUIRE_THROWS_WITH( startBlockedGateFusion(quregVec, maxNumQubits, numBlockQubits), Contains("Invalid number of block qubits") );
+        }
+    }
+    CLEANUP_TEST( quregVec, quregMatr );
+}
+
+
+
+/** @sa startGateFusion
+ * @ingroup unittest 
+ */
+TEST_CASE( "startGateFusion", "[unitaries]" ) {
+    
+    PREPARE_TEST( quregVec, quregMatr, refVec, refMatr );
+    
+    SECTION( "correctness" ) {
+        
+        int maxNumQubits = GENERATE( range(1,NUM_QUBITS+1) );
+        
+        // a fixed circuit of fusable (and, for small maxNumQubits, unfusable) gates
+        qreal a = 1/sqrt(2);
+        qreal param = getRandomReal(-4*M_PI, 4*M_PI);
+        QMatrix hOp{{a,a},{a,-a}};
+        QMatrix xOp{{0,1},{1,0}};
+        QMatrix tOp{{1,0},{0,expI(M_PI/4)}};
+        QMatrix rxOp{{cos(param/2), -1i*sin(param/2)}, {-1i*sin(param/2), cos(param/2)}};
+        QMatrix phaseOp{{1,0},{0,expI(param)}};
+        QMatrix swapOp{{1,0,0,0},{0,0,1,0},{0,1,0,0},{0,0,0,1}};
+        QMatrix op1 = getRandomUnitary(1);
+        QMatrix op2 = getRandomUnitary(2);
+        QMatrix op3 = getRandomUnitary(3);
+        ComplexMatrixN matr3 = createComplexMatrixN(3);
+        toComplexMatrixN(op3, matr3);
+        int targs3[] = {4, 0, 2};
+        int ctrls2[] = {1, 3};
+        
+        auto applyCircuit = [&](Qureg qureg, auto& ref) {
+            int targs2[] = {1, 4};
+            int swapTargs[] = {0, 3};
+            hadamard(qureg, 0);
+            applyReferenceOp(ref, 0, hOp);
+            controlledNot(qureg, 0, 1);
+            applyReferenceOp(ref, 0, 1, xOp);
+            rotateX(qureg, 2, param);
+            applyReferenceOp(ref, 2, rxOp);
+            unitary(qureg, 3, toComplexMatrix2(op1));
+            applyReferenceOp(ref, 3, op1);
+            twoQubitUnitary(qureg, targs2[0], targs2[1], toComplexMatrix4(op2));
+            applyReferenceOp(ref, targs2, 2, op2);
+            multiQubitUnitary(qureg, targs3, 3, matr3);
+            applyReferenceOp(ref, targs3, 3, op3);
+            swapGate(qureg, swapTargs[0], swapTargs[1]);
+            applyReferenceOp(ref, swapTargs, 2, swapOp);
+            tGate(qureg, 4);
+            applyReferenceOp(ref, 4, tOp);
+            controlledPhaseShift(qureg, 2, 1, param);
+            applyReferenceOp(ref, 2, 1, phaseOp);
+            multiControlledUnitary(qureg, ctrls2, 2, 0, toComplexMatrix2(op1));
+            applyReferenceOp(ref, ctrls2, 2, 0, op1);
+            hadamard(qureg, 4);
+            applyReferenceOp(ref, 4, hOp);
+        };
+        
+        SECTION( "state-vector" ) {
+            
+            startGateFusion(quregVec, maxNumQubits);
+            applyCircuit(quregVec, refVec);
+            stopGateFusion(quregVec);
+            REQUIRE( areEqual(quregVec, refVec) );
+        }
+        SECTION( "density-matrix" ) {
+            
+            startGateFusion(quregMatr, maxNumQubits);
+            applyCircuit(quregMatr, refMatr);
+            stopGateFusion(quregMatr);
+            REQUIRE( areEqual(quregMatr, refMatr, 10*REAL_EPS) );
+        }
+        SECTION( "pending gates are applied before the state is read" ) {
+            
+            startGateFusion(quregVec, maxNumQubits);
+            applyCircuit(quregVec, refVec);
+            
+            int outcome = 0;
+            qreal prob = 0;
+            for (size_t i=0; i<refVec.size(); i++)
+                if (((i >> 2) & 1) == outcome)
+                    prob += pow(abs(refVec[i]), 2);
+            REQUIRE( calcProbOfOutcome(quregVec, 2, outcome) == Approx(prob) );
+            REQUIRE( areEqual(quregVec, refVec) );
+            stopGateFusion(quregVec);
+        }
+        SECTION( "pending gates are applied before the state is copied" ) {
+            
+            // areEqual reads qureg.stateVec directly, after only copyStateFromGPU
+            startGateFusion(quregVec, maxNumQubits);
+            applyCircuit(quregVec, refVec);
+            REQUIRE( areEqual(quregVec, refVec) );
+            stopGateFusion(quregVec);
+        }
+        SECTION( "diagonal gates" ) {
+            
+            // a QFT-like ladder of phases, interleaved with other diagonal and non-diagonal gates
+            QMatrix zOp{{1,0},{0,-1}};
+            QMatrix sOp{{1,0},{0,1i}};
+            QMatrix rzOp{{expI(-param/2.),0},{0,expI(param/2.)}};
+            int zTargs[] = {0, 2, 3};
+            QMatrix zzzOp = getZeroMatrix(8);
+            for (size_t i=0; i<zzzOp.size(); i++) {
+                int parity = (i & 1) ^ ((i >> 1) & 1) ^ ((i >> 2) & 1);
+                zzzOp[i][i] = expI(((parity)? 1 : -1) * param/2.);
+            }
+            
+            auto applyPhaseCircuit = [&](Qureg qureg, auto& ref) {
+                for (int t=0; t < NUM_QUBITS; t++) {
+                    hadamard(qureg, t);
+                    applyReferenceOp(ref, t, hOp);
+                    for (int c=t+1; c < NUM_QUBITS; c++) {
+                        QMatrix op{{1,0},{0,expI(M_PI/(1 << (c-t)))}};
+                        controlledPhaseShift(qureg, c, t, M_PI/(1 << (c-t)));
+                        applyReferenceOp(ref, c, t, op);
+                    }
+                }
+                pauliZ(qureg, 1);
+                applyReferenceOp(ref, 1, zOp);
+                sGate(qureg, 4);
+                applyReferenceOp(ref, 4, sOp);
+                rotateZ(qureg, 3, param);
+                applyReferenceOp(ref, 3, rzOp);
+                controlledRotateZ(qureg, 0, 4, param);
+                applyReferenceOp(ref, 0, 4, rzOp);
+                multiRotateZ(qureg, zTargs, 3, param);
+                applyReferenceOp(ref, zTargs, 3, zzzOp);
+                multiControlledPhaseFlip(qureg, ctrls2, 2);
+                applyReferenceOp(ref, ctrls2, 1, ctrls2[1], zOp);
+                rotateX(qureg, 2, param);
+                applyReferenceOp(ref, 2, rxOp);
+                tGate(qureg, 2);
+                applyReferenceOp(ref, 2, tOp);
+            };
+            
+            SECTION( "state-vector" ) {
+                
+                startGateFusion(quregVec, maxNumQubits);
+                applyPhaseCircuit(quregVec, refVec);
+                stopGateFusion(quregVec);
+                REQUIRE( areEqual(quregVec, refVec) );
+            }
+            SECTION( "density-matrix" ) {
+                
+                startGateFusion(quregMatr, maxNumQubits);
+                applyPhaseCircuit(quregMatr, refMatr);
+                stopGateFusion(quregMatr);
+                REQUIRE( areEqual(quregMatr, refMatr, 100*REAL_EPS) );
+            }
+        }
+        destroyComplexMatrixN(matr3);
+    }
+    SECTION( "input validation" ) {
+        
+        SECTION( "number of fused qubits" ) {
+            
+            int maxNumQubits = GENERATE( -1, 0, NUM_QUBITS+1 );
+            REQUIRE_THROWS_WITH( startGateFusion(quregVec, maxNumQubits), Contains("Invalid maximum number of fused qubits") );
+        }
+        SECTION( "fused matrix size" ) {
+            
+            // fused matrices are dense, so are limited to 10 qubits even in larger registers
+            Qureg bigVec = createQureg(11, QUEST_ENV);
+            REQUIRE_THROWS_WITH( startGateFusion(bigVec, 11), Contains("Invalid maximum number of fused qubits") );
+            destroyQureg(bigVec, QUEST_ENV);
+        }
+    }
+    CLEANUP_TEST( quregVec, quregMatr );
+}
+
+
+
 /** @sa swapGate
  * @ingroup unittest 
  * @author Tyson Jones 
@@ -10,6 +10,8 @@
 #include <random>
 #include <algorithm>
 #include <bitset>
+#include <stdio.h>
+#include <stdlib.h>
 
 #ifdef DISTRIBUTED_MODE 
 #include <mpi.h>
@@ -358,6 +360,11 @@ QMatrix getFullOperatorMatrix(
     return fullOp;
 }
 
+const char* getTempDirPath() {
+    const char* dir = getenv("TMPDIR");
+    return (dir != NULL && dir[0] != '\0')? dir : P_tmpdir;
+}
+
 unsigned int calcLog2(long unsigned int res) {
     unsigned int n = 0;
     while (res >>= 1)
@@ -1062,6 +1069,17 @@ void setRandomPauliSum(qreal* coeffs, pauliOpType* codes, int numQubits, int num
 void setRandomPauliSum(PauliHamil hamil) {
     setRandomPauliSum(hamil.termCoeffs, hamil.pauliCodes, hamil.numQubits, hamil.numSumTerms);
 }
+void setRandomPauliSumSharingXMasks(pauliOpType* codes, int numQubits, int numTerms) {
+    for (int t=2; t<numTerms; t++) {
+        for (int q=0; q<numQubits; q++) {
+            pauliOpType code = codes[(t%2)*numQubits + q];
+            if (getRandomInt(0,2))
+                code = (code == PAULI_I)? PAULI_Z : (code == PAULI_Z)? PAULI_I : 
+                       (code == PAULI_X)? PAULI_Y : PAULI_X;
+            codes[t*numQubits + q] = code;
+        }
+    }
+}
 
 QMatrix toQMatrix(qreal* coeffs, pauliOpType* paulis, int numQubits, int numTerms) {
     
@@ -838,6 +838,13 @@ bool areEqual(QVector vec, qreal* reals, qreal* imags);
  */
 qcomp expI(qreal phase);
 
+/** Returns the directory in which tests may create temporary files; that named by 
+ * the TMPDIR environment variable, else the system temporary directory
+ *
+ * @ingroup testutilities 
+ */
+const char* getTempDirPath();
+
 /** Returns log2 of numbers which must be gauranteed to be 2^n 
  *
  * @ingroup testutilities 
@@ -860,6 +867,16 @@ void setRandomPauliSum(qreal* coeffs, pauliOpType* codes, int numQubits, int num
  */
 void setRandomPauliSum(PauliHamil hamil);
 
+/** Overwrites every term (beyond the second) of the pauli sum \p codes with a 
+ * copy of the first or second term, in which each code is randomly swapped 
+ * between I and Z, or X and Y. Every term therefore shares its X mask with the 
+ * first or second term (and terms may repeat), exercising the evaluation of 
+ * terms grouped by X mask.
+ *
+ * @ingroup testutilities 
+ */
+void setRandomPauliSumSharingXMasks(pauliOpType* codes, int numQubits, int numTerms);
+
 // makes below signatures more concise
 template<class T> using CatchGen = Catch::Generators::GeneratorWrapper<T>;
 